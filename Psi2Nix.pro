@@ -2,6 +2,8 @@ TEMPLATE = subdirs
 
 SUBDIRS += \
     Psi2Nix \
+    Psi2NixBench \
+    Psi2NixCli \
     Psi2NixTest
 
 OTHER_FILES=psi2nix-src.pri
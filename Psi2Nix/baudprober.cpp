@@ -0,0 +1,125 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "baudprober.hpp"
+
+#include <QSerialPortInfo>
+#include <QtDebug>
+
+#include <algorithm>
+
+namespace CommsLink {
+
+// The rates the Organiser II's CommsLink offers.
+const QList<qint32> organiserRates{1200, 2400, 4800, 9600};
+
+BaudProber::BaudProber(Link &aLink, RateSetter aSetRate, QObject *parent) :
+    QObject(parent), link(aLink), setRate(std::move(aSetRate))
+{
+    setClock(Clock::system());
+}
+
+void BaudProber::setClock(Clock &clock) {
+    delete timer;
+    timer = clock.createTimer(this);
+    connect(timer, &ClockTimer::timeout, this, &BaudProber::replyTimeout);
+}
+
+QList<qint32> BaudProber::supportedRates() {
+    const auto standard = QSerialPortInfo::standardBaudRates();
+    QList<qint32> rates;
+    for (auto rate : organiserRates) {
+        if (standard.contains(rate)) {
+            rates.append(rate);
+        }
+    }
+    return rates;
+}
+
+void BaudProber::start(QList<qint32> rates) {
+    std::sort(rates.begin(), rates.end(), std::greater<qint32>());
+    remaining = rates;
+    rateResults.clear();
+    receivedConnection = connect(&link, &Link::packetReceived,
+                                 this, &BaudProber::packetReceived);
+    writtenConnection = connect(&link, &Link::frameWritten,
+                                this, &BaudProber::frameWritten);
+    nextRate();
+}
+
+void BaudProber::nextRate() {
+    while (!remaining.isEmpty()) {
+        const auto rate = remaining.takeFirst();
+        rateResults.append({rate, 0, 0, 0, false});
+        if (setRate(rate)) {
+            crcErrorsBefore = link.metrics().snapshot().crcErrors;
+            sendProbe();
+            return;
+        }
+        qDebug() << "Can't set rate" << rate;
+    }
+    finish(0);
+}
+
+void BaudProber::sendProbe() {
+    const Message request{PacketType::linkRequest, QByteArray{}};
+    if (!link.send(request)) {
+        // Wait for whatever is being written to finish.
+        sendPending = true;
+        return;
+    }
+    sendPending = false;
+    awaiting = true;
+    rateResults.last().probesSent++;
+    timer->start(replyWait);
+}
+
+void BaudProber::packetReceived(MessageRef msg) {
+    if (awaiting && msg->type == PacketType::acknowledge) {
+        probeDone(true);
+    }
+}
+
+void BaudProber::frameWritten() {
+    if (sendPending) {
+        sendProbe();
+    } else if (awaiting) {
+        // Time the reply from the end of the request.
+        timer->start(replyWait);
+    }
+}
+
+void BaudProber::replyTimeout() {
+    if (awaiting) {
+        probeDone(false);
+    }
+}
+
+void BaudProber::probeDone(bool acknowledged) {
+    awaiting = false;
+    timer->stop();
+    auto &result = rateResults.last();
+    result.crcErrors = link.metrics().snapshot().crcErrors - crcErrorsBefore;
+    if (acknowledged) {
+        result.acknowledged++;
+    }
+    if (!acknowledged || result.crcErrors > 0) {
+        qDebug() << "Rate" << result.rate << "is unreliable";
+        nextRate();
+        return;
+    }
+    if (result.probesSent < probesPerRate) {
+        sendProbe();
+        return;
+    }
+    result.reliable = true;
+    finish(result.rate);
+}
+
+void BaudProber::finish(qint32 rate) {
+    timer->stop();
+    disconnect(receivedConnection);
+    disconnect(writtenConnection);
+    emit finished(rate);
+}
+}
@@ -0,0 +1,97 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QList>
+#include <QObject>
+#include <QVector>
+
+#include <chrono>
+#include <functional>
+
+#include "clock.hpp"
+#include "link.hpp"
+
+namespace CommsLink {
+
+/// \brief Finds the fastest baud rate at which the device answers reliably.
+///
+/// Rates are tried from the fastest down. At each, a few link requests are
+/// sent; the rate is accepted if every one is acknowledged with no CRC
+/// errors in between, and abandoned at the first that isn't.
+///
+/// The prober drives the Link itself, so it must finish before a Protocol
+/// is attached.
+class BaudProber : public QObject
+{
+    Q_OBJECT
+public:
+    /// \brief Change the port's rate; return false if it can't be used.
+    using RateSetter = std::function<bool(qint32 rate)>;
+
+    /// \brief The outcome of probing one rate.
+    struct RateResult {
+        qint32 rate;
+        int probesSent;
+        int acknowledged;
+        quint64 crcErrors;
+        bool reliable;
+    };
+
+    BaudProber(Link &link, RateSetter setRate, QObject *parent = nullptr);
+    /// \brief Set the number of link requests that must succeed at a rate.
+    void setProbesPerRate(int probes) { probesPerRate = probes; }
+    /// \brief Set how long to wait for each acknowledgement.
+    void setReplyTimeout(std::chrono::milliseconds timeout) {
+        replyWait = timeout;
+    }
+    /// \brief Time replies by \p clock, which must outlive this prober,
+    /// instead of the system clock; call before start().
+    void setClock(Clock &clock);
+    /// \brief Start probing; finished() is emitted when done.
+    void start(QList<qint32> rates);
+    /// \brief Return the results for each rate tried, in order.
+    const QVector<RateResult> &results() const { return rateResults; }
+    /// \brief Return the standard rates the Organiser's link supports that
+    /// the host's serial ports do too.
+    static QList<qint32> supportedRates();
+
+signals:
+    /// \brief Emitted with the rate chosen, which the port is left at, or
+    /// 0 if none was reliable.
+    void finished(qint32 rate);
+
+private slots:
+    void packetReceived(CommsLink::MessageRef msg);
+    void frameWritten();
+    void replyTimeout();
+
+private:
+    /// \brief Move on to the next rate, or finish if none are left.
+    void nextRate();
+    void sendProbe();
+    /// \brief Note the outcome of the last probe and send the next, or
+    /// judge the rate.
+    void probeDone(bool acknowledged);
+    void finish(qint32 rate);
+
+    Link &link;
+    RateSetter setRate;
+    int probesPerRate = 4;
+    std::chrono::milliseconds replyWait{500};
+    ClockTimer *timer = nullptr;
+    /// \brief Rates still to try, fastest first.
+    QList<qint32> remaining;
+    QVector<RateResult> rateResults;
+    /// \brief The link's CRC error count when this rate was set.
+    quint64 crcErrorsBefore = 0;
+    /// \brief true iff a probe has been sent and not yet answered.
+    bool awaiting = false;
+    /// \brief true iff the probe couldn't be sent because the link was
+    /// busy, and should be once it isn't.
+    bool sendPending = false;
+    QMetaObject::Connection receivedConnection;
+    QMetaObject::Connection writtenConnection;
+};
+}
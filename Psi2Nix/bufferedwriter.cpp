@@ -0,0 +1,92 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "bufferedwriter.hpp"
+
+#include <QtConcurrent>
+#include <QtDebug>
+
+#include <utility>
+
+namespace CommsLink {
+
+BufferedWriter::BufferedWriter(const QString &path, QObject *parent) :
+    QObject(parent), file(path)
+{
+    // Reserved capacity survives resize(0), so the buffers are only
+    // allocated once.
+    front.reserve(2 * FLUSH_SIZE);
+    back.reserve(2 * FLUSH_SIZE);
+    connect(&watcher, &QFutureWatcher<bool>::finished,
+            this, &BufferedWriter::written);
+}
+
+BufferedWriter::~BufferedWriter() {
+    // An uncommitted QSaveFile is discarded when it's destroyed.
+    watcher.waitForFinished();
+}
+
+void BufferedWriter::append(const char *data, qint64 size) {
+    Q_ASSERT(!closing);
+    appended += size;
+    if (failed) {
+        return;
+    }
+    front.append(data, static_cast<int>(size));
+    if (!writing && front.size() >= FLUSH_SIZE) {
+        launch(false);
+    }
+}
+
+void BufferedWriter::close() {
+    closing = true;
+    if (!writing) {
+        launch(true);
+    }
+}
+
+bool BufferedWriter::writeBack(bool last) {
+    bool ok = !failed;
+    if (ok && !file.isOpen() && !file.open(QIODevice::WriteOnly)) {
+        ok = false;
+    }
+    if (ok && !back.isEmpty()) {
+        ok = file.write(back) == back.size();
+    }
+    back.resize(0);
+    if (last) {
+        if (ok) {
+            ok = file.commit();
+        } else if (file.isOpen()) {
+            file.cancelWriting();
+        }
+    }
+    return ok;
+}
+
+void BufferedWriter::launch(bool last) {
+    committing = last;
+    writing = true;
+    std::swap(front, back);
+    watcher.setFuture(QtConcurrent::run([this, last] {
+        return writeBack(last);
+    }));
+}
+
+void BufferedWriter::written() {
+    writing = false;
+    if (!watcher.result() && !failed) {
+        qWarning() << "Unable to write" << file.fileName() << ":"
+                   << file.errorString();
+        failed = true;
+        front.resize(0);
+    }
+    if (committing) {
+        emit finished(!failed);
+    } else if (closing) {
+        launch(true);
+    } else if (front.size() >= FLUSH_SIZE) {
+        launch(false);
+    }
+}
+}
@@ -0,0 +1,68 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QByteArray>
+#include <QFutureWatcher>
+#include <QObject>
+#include <QSaveFile>
+
+namespace CommsLink {
+
+/// \brief Writes a file on the global thread pool, so that whoever's
+/// producing its contents never waits for the disk.
+///
+/// Data is appended to one buffer while the other is being written; once
+/// the write has finished and enough has built up, the buffers swap. The
+/// file only replaces any existing one of the same name once all of it
+/// has been written.
+class BufferedWriter : public QObject
+{
+    Q_OBJECT
+public:
+    /// \brief The amount of data gathered before it's written.
+    static constexpr int FLUSH_SIZE = 64 * 1024;
+    /// \param path The file to write; it's opened by the first write.
+    explicit BufferedWriter(const QString &path, QObject *parent = nullptr);
+    /// \brief Wait for any write in progress, and discard the file unless
+    /// it has been closed.
+    ~BufferedWriter();
+    /// \brief Add data to the end of the file; never waits for the disk.
+    void append(const char *data, qint64 size);
+    /// \brief Write whatever's left and commit the file; finished() is
+    /// emitted once that's done.
+    void close();
+    /// \brief Return the number of bytes appended so far.
+    qint64 size() const { return appended; }
+    QString path() const { return file.fileName(); }
+
+signals:
+    /// \brief Emitted once the file has been committed, or has failed.
+    void finished(bool success);
+
+private:
+    /// \brief Write the back buffer, and commit the file if \p last; runs
+    /// on the thread pool.
+    bool writeBack(bool last);
+    /// \brief Swap the buffers and start writing the one just filled.
+    void launch(bool last);
+    /// \brief Called when the write in progress is done.
+    void written();
+
+    QSaveFile file;
+    /// \brief Being appended to.
+    QByteArray front;
+    /// \brief Being written, while a write is in progress.
+    QByteArray back;
+    QFutureWatcher<bool> watcher;
+    qint64 appended = 0;
+    /// \brief true iff a write is in progress.
+    bool writing = false;
+    /// \brief true iff close() has been called.
+    bool closing = false;
+    /// \brief true iff the write in progress is the last.
+    bool committing = false;
+    bool failed = false;
+};
+}
@@ -0,0 +1,200 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "clock.hpp"
+
+#include <QAbstractEventDispatcher>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QPointer>
+#include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+
+#include <algorithm>
+
+namespace CommsLink {
+
+namespace {
+// How long runUntil() sleeps while waiting for work elsewhere.
+constexpr unsigned long REAL_WAIT_MS = 1;
+// How long runUntil() waits for work elsewhere with no timers left to move
+// time on to before giving up.
+constexpr qint64 REAL_LIMIT_MS = 5000;
+
+class SystemTimer : public ClockTimer
+{
+public:
+    explicit SystemTimer(QObject *parent) : ClockTimer(parent), timer(this)
+    {
+        timer.setSingleShot(true);
+        connect(&timer, &QTimer::timeout, this, &ClockTimer::timeout);
+    }
+    void start(std::chrono::milliseconds interval) override {
+        timer.start(interval);
+    }
+    void stop() override { timer.stop(); }
+    bool isActive() const override { return timer.isActive(); }
+
+private:
+    QTimer timer;
+};
+
+class SystemClock : public Clock
+{
+public:
+    SystemClock() { elapsed.start(); }
+    std::chrono::nanoseconds now() const override {
+        return std::chrono::nanoseconds{elapsed.nsecsElapsed()};
+    }
+    ClockTimer *createTimer(QObject *parent) override {
+        return new SystemTimer(parent);
+    }
+    void callAfter(std::chrono::microseconds delay, QObject *context,
+                   std::function<void()> action) override {
+        // Round up, so that nothing happens early.
+        const auto ms = static_cast<int>((std::max<qint64>(delay.count(), 0)
+                                          + 999) / 1000);
+        QTimer::singleShot(ms, Qt::PreciseTimer, context, std::move(action));
+    }
+
+private:
+    QElapsedTimer elapsed;
+};
+}
+
+Clock &Clock::system() {
+    static SystemClock clock;
+    return clock;
+}
+
+class VirtualClock::Timer : public ClockTimer
+{
+public:
+    Timer(VirtualClock *aClock, QObject *parent) :
+        ClockTimer(parent), clock(aClock) {}
+    ~Timer() override {
+        if (clock != nullptr) {
+            clock->timers.removeOne(this);
+        }
+    }
+    void start(std::chrono::milliseconds interval) override {
+        startAfter(interval);
+    }
+    void startAfter(std::chrono::nanoseconds interval) {
+        if (clock == nullptr) {
+            return;
+        }
+        deadline = clock->current + interval;
+        order = clock->starts++;
+        active = true;
+    }
+    void stop() override { active = false; }
+    bool isActive() const override { return active; }
+    /// \brief Null once the clock has gone.
+    VirtualClock *clock;
+    /// \brief true iff the clock should delete the timer once it's fired.
+    bool disposable = false;
+    std::chrono::nanoseconds deadline{0};
+    quint64 order = 0;
+    bool active = false;
+};
+
+VirtualClock::~VirtualClock() {
+    for (auto *timer : timers) {
+        timer->clock = nullptr;
+    }
+}
+
+ClockTimer *VirtualClock::createTimer(QObject *parent) {
+    auto *timer = new Timer(this, parent);
+    timers.append(timer);
+    return timer;
+}
+
+void VirtualClock::callAfter(std::chrono::microseconds delay,
+                             QObject *context, std::function<void()> action) {
+    // To the microsecond, unlike a real timer.
+    auto *timer = new Timer(this, context);
+    timers.append(timer);
+    timer->disposable = true;
+    QObject::connect(timer, &ClockTimer::timeout, timer, std::move(action));
+    timer->startAfter(delay);
+}
+
+VirtualClock::Timer *VirtualClock::nextDue() const {
+    Timer *next = nullptr;
+    for (auto *timer : timers) {
+        if (timer->active && (next == nullptr
+                              || timer->deadline < next->deadline
+                              || (timer->deadline == next->deadline
+                                  && timer->order < next->order))) {
+            next = timer;
+        }
+    }
+    return next;
+}
+
+void VirtualClock::fire(Timer *timer) {
+    current = std::max(current, timer->deadline);
+    timer->active = false;
+    // Whatever it does may destroy it.
+    QPointer<Timer> guard(timer);
+    emit timer->timeout();
+    if (guard && guard->disposable) {
+        delete guard;
+    }
+}
+
+void VirtualClock::advance(std::chrono::nanoseconds interval) {
+    const auto end = current + interval;
+    for (auto *next = nextDue(); next != nullptr && next->deadline <= end;
+         next = nextDue()) {
+        fire(next);
+    }
+    current = end;
+}
+
+bool VirtualClock::advanceToNext() {
+    auto *next = nextDue();
+    if (next == nullptr) {
+        return false;
+    }
+    fire(next);
+    return true;
+}
+
+bool VirtualClock::runUntil(const std::function<bool()> &done,
+                            std::chrono::nanoseconds limit) {
+    const auto end = current + limit;
+    auto *dispatcher = QAbstractEventDispatcher::instance();
+    QElapsedTimer idle;
+    idle.start();
+    for (;;) {
+        // Let whatever's ready now happen before time moves on.
+        QCoreApplication::sendPostedEvents();
+        while (dispatcher->processEvents(QEventLoop::AllEvents)) {
+            QCoreApplication::sendPostedEvents();
+            idle.restart();
+        }
+        if (done()) {
+            return true;
+        }
+        auto *next = nextDue();
+        if (QThreadPool::globalInstance()->activeThreadCount() > 0
+                || next == nullptr) {
+            if (idle.elapsed() > REAL_LIMIT_MS) {
+                return false;
+            }
+            QThread::msleep(REAL_WAIT_MS);
+            continue;
+        }
+        if (next->deadline > end) {
+            current = end;
+            return done();
+        }
+        fire(next);
+        idle.restart();
+    }
+}
+}
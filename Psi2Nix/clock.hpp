@@ -0,0 +1,96 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QList>
+#include <QObject>
+
+#include <chrono>
+#include <functional>
+
+namespace CommsLink {
+
+/// \brief A single-shot timer from a Clock.
+class ClockTimer : public QObject
+{
+    Q_OBJECT
+public:
+    using QObject::QObject;
+    /// \brief Fire once \p interval has passed, cancelling any earlier
+    /// start.
+    virtual void start(std::chrono::milliseconds interval) = 0;
+    virtual void stop() = 0;
+    virtual bool isActive() const = 0;
+
+signals:
+    void timeout();
+};
+
+/// \brief The source of time, and of timers, for the link layers.
+///
+/// Everything is on the system clock unless given another, such as a
+/// VirtualClock that lets tests and simulations skip the waiting.
+class Clock
+{
+public:
+    virtual ~Clock() = default;
+    /// \brief Return the time since some fixed point; never goes back.
+    virtual std::chrono::nanoseconds now() const = 0;
+    /// \brief Create a timer, stopped, owned by \p parent.
+    virtual ClockTimer *createTimer(QObject *parent) = 0;
+    /// \brief Call \p action on \p context's thread once \p delay has
+    /// passed, unless \p context has been destroyed by then.
+    virtual void callAfter(std::chrono::microseconds delay, QObject *context,
+                           std::function<void()> action) = 0;
+    /// \brief Return the clock shared by everything on real time.
+    static Clock &system();
+};
+
+/// \brief A clock whose time only moves when it's told to, so that
+/// anything timed runs as fast as the CPU allows and always in the same
+/// order.
+///
+/// Timers fire in order of their deadlines, or of being started if their
+/// deadlines are the same, with the clock reading each one's deadline.
+/// Everything using the clock must live on the thread that moves it.
+class VirtualClock : public Clock
+{
+public:
+    ~VirtualClock() override;
+    std::chrono::nanoseconds now() const override { return current; }
+    ClockTimer *createTimer(QObject *parent) override;
+    void callAfter(std::chrono::microseconds delay, QObject *context,
+                   std::function<void()> action) override;
+    /// \brief Move time on by \p interval, firing each timer that falls
+    /// due on the way.
+    void advance(std::chrono::nanoseconds interval);
+    /// \brief Move time on to the next timer's deadline and fire it.
+    /// \return false if no timer is running.
+    bool advanceToNext();
+    /// \brief Run the event loop until \p done returns true, moving time
+    /// on to the next deadline whenever nothing else is left to do.
+    ///
+    /// Work on the global thread pool is waited for in real time before
+    /// the clock moves, as are events from other threads if no timer is
+    /// running at all.
+    /// \param limit The most time that may pass on this clock.
+    /// \return false if \p done still returned false after \p limit, or
+    /// once nothing more could happen.
+    bool runUntil(const std::function<bool()> &done,
+                  std::chrono::nanoseconds limit);
+
+private:
+    class Timer;
+    /// \brief Return the running timer due first, or nullptr.
+    Timer *nextDue() const;
+    /// \brief Move time on to \p timer's deadline and fire it.
+    void fire(Timer *timer);
+
+    std::chrono::nanoseconds current{0};
+    /// \brief Incremented each time a timer starts, to order timers with
+    /// the same deadline.
+    quint64 starts = 0;
+    QList<Timer *> timers;
+};
+}
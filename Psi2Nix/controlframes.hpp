@@ -0,0 +1,86 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <array>
+
+#include "crc16.hpp"
+#include "message.hpp"
+
+namespace CommsLink {
+
+/// \brief A complete, encoded frame with no payload.
+struct ControlFrame {
+    /// \brief Room for the framing, the type byte and its escape.
+    std::array<char, MIN_MSG_SIZE + 1> bytes{};
+    qint64 size = 0;
+    const char *data() const { return bytes.data(); }
+};
+
+/// \brief Encode a frame with no payload; gives the same bytes as
+/// FrameEncoder::encode().
+constexpr ControlFrame makeControlFrame(PacketType type, quint8 sequenceNo) {
+    const auto seqAndType = static_cast<quint8>(
+                (static_cast<quint8>(type) << 3) | (sequenceNo & 0x7));
+    quint16 checksum = crc16Update(0x0000, 0x01);
+    checksum = crc16Update(checksum, seqAndType);
+    ControlFrame frame;
+    auto put = [&frame](quint8 b) {
+        frame.bytes[static_cast<size_t>(frame.size++)] = static_cast<char>(b);
+    };
+    put(0x16);
+    put(0x10);
+    put(0x02);
+    put(0x01);
+    put(seqAndType);
+    if (seqAndType == 0x10) {
+        put(0x10);
+    }
+    put(0x10);
+    put(0x03);
+    put(static_cast<quint8>(checksum >> 8));
+    put(static_cast<quint8>(checksum & 0xff));
+    return frame;
+}
+
+/// \brief The packet types that are sent without a payload.
+constexpr std::array<PacketType, 3> controlTypes{
+    PacketType::acknowledge, PacketType::disconnect, PacketType::linkRequest
+};
+
+/// \brief Every control frame, indexed by packet type then sequence number.
+using ControlFrameTable = std::array<std::array<ControlFrame, 8>,
+                                     controlTypes.size()>;
+constexpr ControlFrameTable initControlFrames() {
+    ControlFrameTable res{};
+    for (size_t t = 0; t < controlTypes.size(); t++) {
+        for (quint8 seq = 0; seq < 8; seq++) {
+            res[t][seq] = makeControlFrame(controlTypes[t], seq);
+        }
+    }
+    return res;
+}
+
+constexpr ControlFrameTable controlFrames = initControlFrames();
+
+/// \brief Return true iff frames of type \p type are in controlFrames.
+constexpr bool isControlType(PacketType type) {
+    return static_cast<quint8>(type) < controlTypes.size();
+}
+
+/// \brief Return the precomputed frame for a control message.
+constexpr const ControlFrame &controlFrame(PacketType type,
+                                           quint8 sequenceNo) {
+    return controlFrames[static_cast<quint8>(type)][sequenceNo & 0x7];
+}
+
+// The link request frame as captured from a real device.
+static_assert(controlFrame(PacketType::linkRequest, 0).size == 10
+              && controlFrame(PacketType::linkRequest, 0).bytes[5] == 0x10
+              && controlFrame(PacketType::linkRequest, 0).bytes[8] == 0x00
+              && controlFrame(PacketType::linkRequest, 0).bytes[9] == 0x5c,
+              "Control frames don't match the wire format");
+}
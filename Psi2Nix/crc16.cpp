@@ -0,0 +1,161 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "crc16.hpp"
+
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PSI2NIX_HAVE_CLMUL 1
+#include <immintrin.h>
+#endif
+
+namespace CommsLink {
+
+// crc16table holds the byte-swapped form of a reflected CRC-16 (the
+// polynomial is 0x8005, reflected to 0xa001). The multi-byte
+// implementations work on the reflected register directly and swap at the
+// boundaries.
+constexpr quint16 swapBytes(quint16 v) {
+    return static_cast<quint16>((v << 8) | (v >> 8));
+}
+
+// Slicing-by-8 tables: sliceTable[k][i] is the register after feeding byte
+// i followed by k zero bytes into a zeroed register.
+using SliceTables = std::array<std::array<quint16, 256>, 8>;
+constexpr SliceTables initSliceTables() {
+    SliceTables res{};
+    for (int i = 0; i < 256; i++) {
+        res[0][static_cast<size_t>(i)] = swapBytes(crc16table[static_cast<size_t>(i)]);
+    }
+    for (size_t k = 1; k < res.size(); k++) {
+        for (size_t i = 0; i < 256; i++) {
+            const quint16 prev = res[k - 1][i];
+            res[k][i] = static_cast<quint16>((prev >> 8) ^ res[0][prev & 0xff]);
+        }
+    }
+    return res;
+}
+constexpr SliceTables sliceTables = initSliceTables();
+
+// Below this length the set-up cost of folding outweighs its gain.
+constexpr qint64 CLMUL_THRESHOLD = 64;
+
+quint16 crc16Bytewise(quint16 checksum, const char *data, qint64 size) {
+    for (qint64 i = 0; i < size; i++) {
+        checksum = crc16Update(checksum, static_cast<quint8>(data[i]));
+    }
+    return checksum;
+}
+
+quint16 crc16Sliced(quint16 checksum, const char *data, qint64 size) {
+    const auto *p = reinterpret_cast<const quint8 *>(data);
+    quint16 r = swapBytes(checksum);
+    const auto &t = sliceTables;
+    while (size >= 8) {
+        r = static_cast<quint16>(t[7][(p[0] ^ r) & 0xff]
+                ^ t[6][p[1] ^ (r >> 8)]
+                ^ t[5][p[2]] ^ t[4][p[3]]
+                ^ t[3][p[4]] ^ t[2][p[5]]
+                ^ t[1][p[6]] ^ t[0][p[7]]);
+        p += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        r = static_cast<quint16>((r >> 8) ^ t[0][(r ^ *p++) & 0xff]);
+    }
+    return swapBytes(r);
+}
+
+#ifdef PSI2NIX_HAVE_CLMUL
+// Folding constants, each the bit-reflected 64-bit form of x^n mod P. A
+// reflected carry-less product comes out one bit short of the full width,
+// so each is taken at one power lower than the distance it folds across.
+constexpr quint64 FOLD_HI = 0xccd0000000000000; // x^191 mod P
+constexpr quint64 FOLD_LO = 0xc100000000000000; // x^127 mod P
+constexpr quint64 FOLD_64 = 0xd101000000000000; // x^63 mod P
+// Barrett reduction: floor(x^80 / P) without its x^64 term, and P without
+// its x^16 term, both reflected.
+constexpr quint64 BARRETT_MU = 0xf87ff5ffe7ffdfff;
+constexpr quint64 BARRETT_P  = 0xa001;
+
+__attribute__((target("pclmul,sse4.1")))
+static quint16 crc16Fold(quint16 r, const char *data, qint64 size) {
+    // Fold the message 128 bits at a time into a 128-bit accumulator that
+    // is congruent to it (mod P).
+    const __m128i k = _mm_set_epi64x(static_cast<qint64>(FOLD_LO),
+                                     static_cast<qint64>(FOLD_HI));
+    __m128i acc = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+    acc = _mm_xor_si128(acc, _mm_cvtsi32_si128(r));
+    for (qint64 pos = 16; pos < size; pos += 16) {
+        const __m128i next = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(data + pos));
+        acc = _mm_xor_si128(_mm_xor_si128(_mm_clmulepi64_si128(acc, k, 0x00),
+                                          _mm_clmulepi64_si128(acc, k, 0x11)),
+                            next);
+    }
+    // Fold down to 64 bits, in two steps as each product may overhang.
+    const __m128i k64 = _mm_cvtsi64_si128(static_cast<qint64>(FOLD_64));
+    for (int i = 0; i < 2; i++) {
+        acc = _mm_xor_si128(_mm_clmulepi64_si128(acc, k64, 0x00),
+                            _mm_unpackhi_epi64(_mm_setzero_si128(), acc));
+    }
+    const auto v = static_cast<quint64>(_mm_extract_epi64(acc, 1));
+    // Barrett-reduce the remaining 64 bits to 16.
+    const auto t = static_cast<quint64>(_mm_cvtsi128_si64(
+        _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<qint64>(v)),
+                             _mm_cvtsi64_si128(static_cast<qint64>(BARRETT_MU)),
+                             0x00)));
+    const quint64 q = v ^ (t << 1);
+    const __m128i rem = _mm_clmulepi64_si128(
+                _mm_cvtsi64_si128(static_cast<qint64>(q)),
+                _mm_cvtsi64_si128(static_cast<qint64>(BARRETT_P)), 0x00);
+    const auto lo = static_cast<quint64>(_mm_cvtsi128_si64(rem));
+    const auto hi = static_cast<quint64>(_mm_extract_epi64(rem, 1));
+    return static_cast<quint16>((lo >> 63) | (hi << 1));
+}
+#endif
+
+bool crc16ClmulSupported() {
+#ifdef PSI2NIX_HAVE_CLMUL
+    static const bool supported = __builtin_cpu_supports("pclmul")
+            && __builtin_cpu_supports("sse4.1");
+    return supported;
+#else
+    return false;
+#endif
+}
+
+quint16 crc16Clmul(quint16 checksum, const char *data, qint64 size) {
+#ifdef PSI2NIX_HAVE_CLMUL
+    if (size >= 16 && crc16ClmulSupported()) {
+        const qint64 folded = size & ~qint64{15};
+        checksum = swapBytes(crc16Fold(swapBytes(checksum), data, folded));
+        data += folded;
+        size -= folded;
+    }
+#endif
+    return crc16Sliced(checksum, data, size);
+}
+
+quint16 crc16(quint16 checksum, const char *data, qint64 size) {
+    if (size >= CLMUL_THRESHOLD) {
+        return crc16Clmul(checksum, data, size);
+    }
+    return crc16Sliced(checksum, data, size);
+}
+
+quint16 crc16Unescaped(quint16 checksum, const char *data, qint64 size) {
+    const char *pos = data;
+    const char *const end = data + size;
+    while (pos < end) {
+        const auto dle = static_cast<const char *>(
+                    std::memchr(pos, 0x10, static_cast<size_t>(end - pos)));
+        const char *runEnd = dle ? dle + 1 : end;
+        checksum = crc16(checksum, pos, runEnd - pos);
+        // Skip the stuffed copy of the 0x10.
+        pos = dle ? runEnd + 1 : end;
+    }
+    return checksum;
+}
+}
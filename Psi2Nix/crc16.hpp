@@ -0,0 +1,69 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <array>
+
+namespace CommsLink {
+
+// Generate the lookup table for our CRC-16 function.
+constexpr quint16 CRC16_POLYNOMIAL = 0xa001;
+constexpr quint16 crc16Byte(quint8 b) {
+    quint16 c = b;
+    quint16 crc = 0x0000;
+    for (quint16 j = 0; j<8; j++) {
+        if ((crc^c)& 0x0001) {
+            crc = static_cast<quint16>((crc >> 1) ^ CRC16_POLYNOMIAL);
+        } else {
+            crc >>= 1;
+        }
+        c >>= 1;
+    }
+    return static_cast<quint16>(((crc & 0xff) << 8) | (crc>>8));
+}
+
+constexpr std::array<quint16, 256> initCRC16Table() {
+    std::array<quint16, 256> res{0};
+    for (quint16 i = 0; i < 256; i++) {
+        res[i] = crc16Byte(static_cast<quint8>(i));
+    }
+    return res;
+}
+
+constexpr std::array<quint16, 256> crc16table = initCRC16Table();
+
+/// \brief Add one byte to a running CRC-16.
+constexpr quint16 crc16Update(quint16 checksum, quint8 b) {
+    return static_cast<quint16>((checksum << 8)
+                                ^ crc16table[b ^ (checksum >> 8)]);
+}
+
+// All of the functions below take and return a running checksum in the
+// same form as crc16Update, starting from 0x0000, and give bit-identical
+// results.
+
+/// \brief Add a span of bytes to a running CRC-16, one table lookup per
+/// byte.
+quint16 crc16Bytewise(quint16 checksum, const char *data, qint64 size);
+/// \brief Add a span of bytes to a running CRC-16 using slicing-by-8:
+/// eight table lookups per eight bytes, with no dependency between them.
+quint16 crc16Sliced(quint16 checksum, const char *data, qint64 size);
+/// \brief Return true iff this CPU can run crc16Clmul natively.
+bool crc16ClmulSupported();
+/// \brief Add a span of bytes to a running CRC-16 by folding 16 bytes at a
+/// time with carry-less multiplication.
+///
+/// Falls back to crc16Sliced if the CPU lacks PCLMULQDQ.
+quint16 crc16Clmul(quint16 checksum, const char *data, qint64 size);
+/// \brief Add a span of bytes to a running CRC-16 using the fastest
+/// implementation available on this CPU for its length.
+quint16 crc16(quint16 checksum, const char *data, qint64 size);
+/// \brief Add a span of byte-stuffed bytes to a running CRC-16, skipping
+/// the second byte of each 0x10 0x10 pair.
+///
+/// The span must not end in the middle of a pair.
+quint16 crc16Unescaped(quint16 checksum, const char *data, qint64 size);
+}
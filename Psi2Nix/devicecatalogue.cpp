@@ -0,0 +1,202 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "devicecatalogue.hpp"
+
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QReadLocker>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QWriteLocker>
+#include <QtDebug>
+
+#include <algorithm>
+
+namespace CommsLink {
+
+namespace {
+constexpr int CATALOGUE_VERSION = 1;
+
+using DeviceFiles = QHash<QByteArray, CatalogueEntry>;
+
+// Read a catalogue file into devices, which is left empty if there isn't
+// one.
+bool readCatalogue(const QString &path,
+                   QHash<QString, DeviceFiles> &devices) {
+    QFile file(path);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Unable to read" << path << ":" << file.errorString();
+        return false;
+    }
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (doc.isNull() || doc.object().value("version").toInt()
+            != CATALOGUE_VERSION) {
+        qWarning() << "Ignoring unreadable catalogue" << path << ":"
+                   << error.errorString();
+        return false;
+    }
+    const auto devs = doc.object().value("devices").toObject();
+    for (auto dev = devs.begin(); dev != devs.end(); ++dev) {
+        auto &files = devices[dev.key()];
+        const auto entries = dev.value().toObject();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            const auto entry = it.value().toObject();
+            const auto name = it.key().toLatin1();
+            files.insert(name, {
+                             name,
+                             static_cast<qint64>(
+                                 entry.value("size").toDouble()),
+                             static_cast<qint64>(
+                                 entry.value("modified").toDouble())
+                         });
+        }
+    }
+    return true;
+}
+}
+
+DeviceCatalogue::DeviceCatalogue(QString path) :
+    cataloguePath(std::move(path))
+{
+}
+
+QString DeviceCatalogue::defaultPath() {
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+            + "/catalogue.json";
+}
+
+bool DeviceCatalogue::load() {
+    // Read without the lock held, so that lookups carry on meanwhile.
+    QHash<QString, DeviceFiles> loaded;
+    const bool success = readCatalogue(cataloguePath, loaded);
+    if (!success) {
+        loaded.clear();
+    }
+    QWriteLocker locker(&lock);
+    devices.swap(loaded);
+    listed.clear();
+    changes++;
+    return success;
+}
+
+bool DeviceCatalogue::save() const {
+    QJsonObject devs;
+    {
+        QReadLocker locker(&lock);
+        for (auto dev = devices.begin(); dev != devices.end(); ++dev) {
+            QJsonObject entries;
+            for (const auto &entry : *dev) {
+                entries.insert(QString::fromLatin1(entry.name), QJsonObject{
+                                   {"size", static_cast<double>(entry.size)},
+                                   {"modified",
+                                    static_cast<double>(entry.modified)}
+                               });
+            }
+            devs.insert(dev.key(), entries);
+        }
+    }
+    const QJsonObject root{
+        {"version", CATALOGUE_VERSION},
+        {"devices", devs}
+    };
+    QDir().mkpath(QFileInfo(cataloguePath).absolutePath());
+    QSaveFile file(cataloguePath);
+    if (!file.open(QIODevice::WriteOnly)
+            || file.write(QJsonDocument(root).toJson(QJsonDocument::Compact))
+            < 0
+            || !file.commit()) {
+        qWarning() << "Unable to write" << cataloguePath << ":"
+                   << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool DeviceCatalogue::needsListing(const QString &device) const {
+    QReadLocker locker(&lock);
+    return !listed.contains(device);
+}
+
+void DeviceCatalogue::fill(const QString &device,
+                           const QVector<CatalogueEntry> &listing) {
+    DeviceFiles files;
+    files.reserve(listing.size());
+    for (const auto &entry : listing) {
+        files.insert(entry.name, entry);
+    }
+    QWriteLocker locker(&lock);
+    devices[device].swap(files);
+    listed.insert(device);
+    changes++;
+}
+
+QVector<CatalogueEntry> DeviceCatalogue::entries(
+        const QString &device) const {
+    QVector<CatalogueEntry> result;
+    {
+        QReadLocker locker(&lock);
+        const auto dev = devices.constFind(device);
+        if (dev == devices.constEnd()) {
+            return result;
+        }
+        result.reserve(dev->size());
+        for (const auto &entry : *dev) {
+            result.append(entry);
+        }
+    }
+    std::sort(result.begin(), result.end(),
+              [](const CatalogueEntry &a, const CatalogueEntry &b) {
+        return a.name < b.name;
+    });
+    return result;
+}
+
+bool DeviceCatalogue::find(const QString &device, const QByteArray &name,
+                           CatalogueEntry &entry) const {
+    QReadLocker locker(&lock);
+    const auto dev = devices.constFind(device);
+    if (dev == devices.constEnd()) {
+        return false;
+    }
+    const auto it = dev->constFind(name);
+    if (it == dev->constEnd()) {
+        return false;
+    }
+    entry = *it;
+    return true;
+}
+
+void DeviceCatalogue::recordWritten(const QString &device,
+                                    const QByteArray &name, qint64 size) {
+    const CatalogueEntry entry{name, size,
+                               QDateTime::currentMSecsSinceEpoch()};
+    QWriteLocker locker(&lock);
+    devices[device].insert(name, entry);
+    changes++;
+}
+
+void DeviceCatalogue::recordRemoved(const QString &device,
+                                    const QByteArray &name) {
+    QWriteLocker locker(&lock);
+    const auto dev = devices.find(device);
+    if (dev != devices.end() && dev->remove(name) > 0) {
+        changes++;
+    }
+}
+
+void DeviceCatalogue::forgetDevice(const QString &device) {
+    QWriteLocker locker(&lock);
+    devices.remove(device);
+    listed.remove(device);
+    changes++;
+}
+}
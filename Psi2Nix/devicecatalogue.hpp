@@ -0,0 +1,84 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QReadWriteLock>
+#include <QSet>
+#include <QString>
+#include <QVector>
+
+#include <atomic>
+
+namespace CommsLink {
+
+/// \brief A file known to be on a device.
+struct CatalogueEntry {
+    QByteArray name;
+    /// \brief The bytes of file data the device holds for it.
+    qint64 size = 0;
+    /// \brief When it was last written or listed, in milliseconds since the
+    /// epoch.
+    qint64 modified = 0;
+};
+
+/// \brief A cache of what's on each device, so that questions about a
+/// device's contents are answered without going over the link.
+///
+/// A device's entries are replaced by a directory listing at most once a
+/// session, and kept up to date from then on by the writes and deletes
+/// made through us. The catalogue is kept between runs, so a device's
+/// last known contents are there from the start; needsListing() says
+/// whether they have yet to be confirmed this session.
+///
+/// Devices are told apart by a name chosen by the caller, as for SyncIndex.
+/// All members may be called from any thread; lookups never wait for
+/// the link.
+class DeviceCatalogue
+{
+public:
+    /// \param path The file in which the catalogue is kept.
+    explicit DeviceCatalogue(QString path = defaultPath());
+    /// \brief Return the catalogue file used unless another is given.
+    static QString defaultPath();
+    QString path() const { return cataloguePath; }
+    /// \brief Read the catalogue file; a missing one gives an empty
+    /// catalogue.
+    /// \return false if the file exists but couldn't be read.
+    bool load();
+    /// \brief Write the catalogue file, replacing it atomically.
+    bool save() const;
+    /// \brief Return true iff \p device's contents haven't been listed
+    /// since this catalogue was created.
+    bool needsListing(const QString &device) const;
+    /// \brief Replace \p device's entries with a directory listing.
+    void fill(const QString &device, const QVector<CatalogueEntry> &listing);
+    /// \brief Return the files believed to be on \p device, sorted by name.
+    QVector<CatalogueEntry> entries(const QString &device) const;
+    /// \brief Look up one file on \p device.
+    /// \return false if it isn't believed to be there.
+    bool find(const QString &device, const QByteArray &name,
+              CatalogueEntry &entry) const;
+    /// \brief Note that \p name has been written to \p device.
+    void recordWritten(const QString &device, const QByteArray &name,
+                       qint64 size);
+    /// \brief Note that \p name has been deleted from \p device.
+    void recordRemoved(const QString &device, const QByteArray &name);
+    /// \brief Forget everything about \p device, as after it's wiped.
+    void forgetDevice(const QString &device);
+    /// \brief Return a number that changes whenever the catalogue does,
+    /// so that a view of it need only be rebuilt when it's out of date.
+    quint64 revision() const { return changes.load(); }
+
+private:
+    QString cataloguePath;
+    mutable QReadWriteLock lock;
+    /// \brief Keyed by device, then by name on the device.
+    QHash<QString, QHash<QByteArray, CatalogueEntry>> devices;
+    /// \brief Devices listed since the catalogue was created.
+    QSet<QString> listed;
+    std::atomic<quint64> changes{0};
+};
+}
@@ -0,0 +1,238 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "eventtrace.hpp"
+
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <memory>
+
+namespace CommsLink {
+
+namespace {
+
+static_assert((EventTrace::RING_SIZE & (EventTrace::RING_SIZE - 1)) == 0,
+              "EventTrace::RING_SIZE must be a power of two");
+constexpr quint64 RING_MASK = EventTrace::RING_SIZE - 1;
+
+// An event packed into words, so that it can be read while it's being
+// overwritten without a data race.
+struct Slot {
+    /// Odd while the slot is being written; 2 * (index + 1) once event
+    /// number index is in it.
+    std::atomic<quint64> seq{0};
+    std::array<std::atomic<quint64>, 4> words{};
+};
+
+struct Ring {
+    std::array<Slot, EventTrace::RING_SIZE> slots;
+    /// The number of events ever recorded in the ring; written only by the
+    /// thread that owns it.
+    std::atomic<quint64> written{0};
+    /// true iff a thread owns the ring.
+    bool inUse = false;
+    quint8 number = 0;
+};
+
+// Rings are never freed, so that events from threads that have finished
+// can still be read. A ring whose thread has finished is given to the next
+// new thread.
+class Registry {
+public:
+    Ring *acquire() {
+        QMutexLocker lock(&mutex);
+        const auto n = count.load(std::memory_order_relaxed);
+        for (int i = 0; i < n; i++) {
+            if (!rings[static_cast<size_t>(i)]->inUse) {
+                rings[static_cast<size_t>(i)]->inUse = true;
+                return rings[static_cast<size_t>(i)].get();
+            }
+        }
+        if (n == EventTrace::MAX_RINGS) {
+            // This thread's events will go unrecorded.
+            return nullptr;
+        }
+        auto &ring = rings[static_cast<size_t>(n)];
+        ring = std::make_unique<Ring>();
+        ring->number = static_cast<quint8>(n);
+        ring->inUse = true;
+        count.store(n + 1, std::memory_order_release);
+        return ring.get();
+    }
+    void release(Ring *ring) {
+        QMutexLocker lock(&mutex);
+        ring->inUse = false;
+    }
+    int size() const { return count.load(std::memory_order_acquire); }
+    const Ring &at(int i) const { return *rings[static_cast<size_t>(i)]; }
+private:
+    QMutex mutex;
+    std::array<std::unique_ptr<Ring>, EventTrace::MAX_RINGS> rings;
+    std::atomic<int> count{0};
+};
+
+Registry &registry() {
+    // Deliberately leaked: threads may record events during exit.
+    static auto *instance = new Registry;
+    return *instance;
+}
+
+// The calling thread's ring, acquired on its first event.
+class ThreadRing {
+public:
+    ~ThreadRing() {
+        if (ring != nullptr) {
+            registry().release(ring);
+        }
+    }
+    Ring *get() {
+        if (!acquired) {
+            ring = registry().acquire();
+            acquired = true;
+        }
+        return ring;
+    }
+private:
+    Ring *ring = nullptr;
+    bool acquired = false;
+};
+
+thread_local ThreadRing threadRing;
+
+struct Description {
+    const char *text;
+    int args;
+};
+
+constexpr std::array<Description, static_cast<size_t>(TraceEventId::count)>
+descriptions{{
+    {"%1 bytes written; %2 remaining", 2},
+    {"%2 bytes reported written with %1 remaining", 2},
+    {"%1 bytes available to read", 1},
+    {"Read timeout; discarding partial frame", 0},
+    {"Frame with %1 payload bytes received", 1},
+    {"Framing error; waiting for preamble", 0},
+    {"Frame exceeds %1 bytes; discarding", 1},
+    {"Truncated frame; resynchronising", 0},
+    {"Frame received without type; discarding", 0},
+    {"Frame received with bad CRC %2, expected %1; discarding", 2},
+    {"MockSerial asked for %1 bytes; read %2", 2},
+    {"MockSerial received %1 bytes", 1}
+}};
+
+constexpr std::array<const char *, 4> levelNames{
+    "debug", "info", "warning", "off"
+};
+}
+
+std::atomic<TraceLevel> EventTrace::runtimeLevel{TraceLevel::debug};
+
+void EventTrace::record(TraceLevel level, TraceEventId id,
+                        qint64 arg0, qint64 arg1) {
+    auto *ring = threadRing.get();
+    if (ring == nullptr) {
+        return;
+    }
+    const auto n = ring->written.load(std::memory_order_relaxed);
+    auto &slot = ring->slots[n & RING_MASK];
+    slot.seq.store(2 * n + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.words[0].store(now(), std::memory_order_relaxed);
+    slot.words[1].store(static_cast<quint64>(id)
+                        | static_cast<quint64>(level) << 16
+                        | static_cast<quint64>(ring->number) << 24,
+                        std::memory_order_relaxed);
+    slot.words[2].store(static_cast<quint64>(arg0), std::memory_order_relaxed);
+    slot.words[3].store(static_cast<quint64>(arg1), std::memory_order_relaxed);
+    slot.seq.store(2 * n + 2, std::memory_order_release);
+    ring->written.store(n + 1, std::memory_order_release);
+}
+
+quint64 EventTrace::now() {
+    return static_cast<quint64>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(
+                    std::chrono::steady_clock::now().time_since_epoch())
+                .count());
+}
+
+std::vector<TraceEvent> EventTrace::snapshot() {
+    std::vector<TraceEvent> events;
+    const auto &rings = registry();
+    for (int r = 0; r < rings.size(); r++) {
+        const auto &ring = rings.at(r);
+        const auto end = ring.written.load(std::memory_order_acquire);
+        const auto begin = end > RING_SIZE ? end - RING_SIZE : 0;
+        for (auto n = begin; n < end; n++) {
+            const auto &slot = ring.slots[n & RING_MASK];
+            const auto before = slot.seq.load(std::memory_order_acquire);
+            if (before != 2 * n + 2) {
+                // Already overwritten.
+                continue;
+            }
+            std::array<quint64, 4> words;
+            for (size_t i = 0; i < words.size(); i++) {
+                words[i] = slot.words[i].load(std::memory_order_relaxed);
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != before) {
+                continue;
+            }
+            TraceEvent event;
+            event.timestamp = words[0];
+            event.id = static_cast<TraceEventId>(words[1] & 0xffff);
+            event.level = static_cast<TraceLevel>((words[1] >> 16) & 0xff);
+            event.ring = static_cast<quint8>((words[1] >> 24) & 0xff);
+            event.args[0] = static_cast<qint64>(words[2]);
+            event.args[1] = static_cast<qint64>(words[3]);
+            events.push_back(event);
+        }
+    }
+    std::stable_sort(events.begin(), events.end(),
+                     [](const TraceEvent &a, const TraceEvent &b) {
+        return a.timestamp < b.timestamp;
+    });
+    return events;
+}
+
+QString EventTrace::format(const TraceEvent &event) {
+    const auto index = static_cast<size_t>(event.id);
+    QString text;
+    if (index < descriptions.size()) {
+        text = QString::fromLatin1(descriptions[index].text);
+        if (descriptions[index].args > 0) {
+            text = descriptions[index].args == 1
+                    ? text.arg(event.args[0])
+                    : text.arg(event.args[0]).arg(event.args[1]);
+        }
+    } else {
+        text = QString("Unknown event %1").arg(index);
+    }
+    const auto micros = event.timestamp / 1000;
+    return QString("%1.%2 [%3] %4: %5")
+            .arg(micros / 1000000)
+            .arg(micros % 1000000, 6, 10, QChar('0'))
+            .arg(event.ring)
+            .arg(levelName(event.level), text);
+}
+
+QString EventTrace::levelName(TraceLevel level) {
+    const auto index = static_cast<size_t>(level);
+    return index < levelNames.size()
+            ? QString::fromLatin1(levelNames[index]) : QString();
+}
+
+bool EventTrace::levelFromName(const QString &name, TraceLevel &level) {
+    for (size_t i = 0; i < levelNames.size(); i++) {
+        if (name == QLatin1String(levelNames[i])) {
+            level = static_cast<TraceLevel>(i);
+            return true;
+        }
+    }
+    return false;
+}
+}
@@ -0,0 +1,121 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <atomic>
+#include <vector>
+
+class QString;
+
+/// \brief The least severe trace level compiled in: 0 for debug, 1 for info,
+/// 2 for warning and 3 for none. Events below it cost nothing at all.
+#ifndef PSI2NIX_TRACE_LEVEL
+#define PSI2NIX_TRACE_LEVEL 0
+#endif
+
+namespace CommsLink {
+
+/// \brief The severity of a trace event.
+enum struct TraceLevel : quint8 {
+    debug   = 0,
+    info    = 1,
+    warning = 2,
+    off     = 3
+};
+
+/// \brief Everything that can be traced; each has a fixed description,
+/// filled in from the event's arguments when it's decoded.
+enum struct TraceEventId : quint16 {
+    bytesWritten,   //!< %1 bytes written, %2 still to write
+    writeOverrun,   //!< %2 bytes reported written with %1 left to write
+    bytesAvailable, //!< %1 bytes available to read
+    readTimeout,    //!< Partial frame discarded after a read timeout
+    frameDecoded,   //!< Frame with %1 payload bytes decoded
+    framingError,   //!< Framing error; waiting for a preamble
+    oversizeFrame,  //!< Frame longer than %1 bytes discarded
+    truncatedFrame, //!< Truncated frame; resynchronising
+    untypedFrame,   //!< Frame without a type discarded
+    badCrc,         //!< Frame discarded; CRC %2 received, %1 expected
+    mockRead,       //!< Test port asked for %1 bytes; gave %2
+    mockReceived,   //!< Test port received %1 bytes from the device
+    count
+};
+
+/// \brief A trace event as recorded.
+struct TraceEvent {
+    /// \brief Nanoseconds since an arbitrary, fixed epoch.
+    quint64 timestamp = 0;
+    TraceEventId id = TraceEventId::count;
+    TraceLevel level = TraceLevel::debug;
+    /// \brief The number of the ring the event was recorded in, which
+    /// identifies the thread that recorded it.
+    quint8 ring = 0;
+    qint64 args[2] = {0, 0};
+};
+
+constexpr TraceLevel COMPILED_TRACE_LEVEL =
+        static_cast<TraceLevel>(PSI2NIX_TRACE_LEVEL);
+
+/// \brief A flight recorder for frequent events.
+///
+/// Each thread records into a lock-free ring of its own, overwriting its
+/// oldest events once the ring is full. Recording an event costs a clock
+/// read and a few stores; turning events into text is left until someone
+/// asks for them, which may be on another thread.
+class EventTrace
+{
+public:
+    /// \brief The number of events kept for each thread.
+    static constexpr int RING_SIZE = 4096;
+    /// \brief The most threads that can record events at once.
+    static constexpr int MAX_RINGS = 64;
+
+    /// \brief Return true iff events of \p level are being recorded.
+    static bool isEnabled(TraceLevel level) {
+        return level >= COMPILED_TRACE_LEVEL
+                && level >= runtimeLevel.load(std::memory_order_relaxed);
+    }
+    /// \brief Record only events of \p level and above; defaults to debug.
+    static void setLevel(TraceLevel level) {
+        runtimeLevel.store(level, std::memory_order_relaxed);
+    }
+    static TraceLevel level() {
+        return runtimeLevel.load(std::memory_order_relaxed);
+    }
+    /// \brief Record an event from the calling thread, whatever the level.
+    static void record(TraceLevel level, TraceEventId id,
+                       qint64 arg0, qint64 arg1);
+    /// \brief Return the current time on the events' clock.
+    static quint64 now();
+    /// \brief Return the events still held for every thread, oldest first.
+    ///
+    /// May be called from any thread while others are recording; events
+    /// overwritten while being copied are left out.
+    static std::vector<TraceEvent> snapshot();
+    /// \brief Return an event as a line of text, without a line ending.
+    static QString format(const TraceEvent &event);
+    /// \brief Return the name of a level, as accepted by levelFromName().
+    static QString levelName(TraceLevel level);
+    /// \brief Parse the name of a level.
+    /// \return false if \p name isn't one.
+    static bool levelFromName(const QString &name, TraceLevel &level);
+
+private:
+    static std::atomic<TraceLevel> runtimeLevel;
+};
+
+/// \brief Record an event if \p Level is both compiled in and enabled.
+///
+/// With a level below PSI2NIX_TRACE_LEVEL, this compiles to nothing.
+template <TraceLevel Level>
+inline void traceEvent(TraceEventId id, qint64 arg0 = 0, qint64 arg1 = 0) {
+    if constexpr (Level >= COMPILED_TRACE_LEVEL) {
+        if (EventTrace::isEnabled(Level)) {
+            EventTrace::record(Level, id, arg0, arg1);
+        }
+    }
+}
+}
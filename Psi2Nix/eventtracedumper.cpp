@@ -0,0 +1,45 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "eventtracedumper.hpp"
+
+#include <QFile>
+#include <QTextStream>
+
+#include "eventtrace.hpp"
+
+namespace CommsLink {
+
+EventTraceDumper::EventTraceDumper(QObject *parent) : QObject(parent)
+{
+    dumpThread.setObjectName("EventTraceDumper");
+    context = new QObject;
+    context->moveToThread(&dumpThread);
+    connect(&dumpThread, &QThread::finished, context, &QObject::deleteLater);
+    dumpThread.start(QThread::LowPriority);
+}
+
+EventTraceDumper::~EventTraceDumper() {
+    // Let any dump already asked for finish.
+    dumpThread.quit();
+    dumpThread.wait();
+}
+
+void EventTraceDumper::dump(const QString &path) {
+    QMetaObject::invokeMethod(context, [this, path] {
+        const auto events = EventTrace::snapshot();
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            emit dumped(path, 0, false);
+            return;
+        }
+        QTextStream out(&file);
+        for (const auto &event : events) {
+            out << EventTrace::format(event) << '\n';
+        }
+        out.flush();
+        emit dumped(path, static_cast<int>(events.size()),
+                    out.status() == QTextStream::Ok);
+    }, Qt::QueuedConnection);
+}
+}
@@ -0,0 +1,36 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <QThread>
+
+namespace CommsLink {
+
+/// \brief Turns the events held by EventTrace into text on a thread of its
+/// own, so that whoever asks for them isn't held up.
+class EventTraceDumper : public QObject
+{
+    Q_OBJECT
+public:
+    explicit EventTraceDumper(QObject *parent = nullptr);
+    ~EventTraceDumper();
+    /// \brief Write every event held so far to a text file, one per line.
+    ///
+    /// Returns at once; dumped() is emitted when the file has been written.
+    void dump(const QString &path);
+
+signals:
+    /// \brief Emitted from the dumper's thread once a dump has finished.
+    /// \param events The number of events written.
+    /// \param ok false if the file couldn't be written.
+    void dumped(QString path, int events, bool ok);
+
+private:
+    QThread dumpThread;
+    /// \brief Lives on dumpThread, so that work posted to it runs there.
+    QObject *context = nullptr;
+};
+}
@@ -0,0 +1,106 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "filereceiver.hpp"
+
+#include <QDir>
+#include <QtDebug>
+
+#include "filetransfer.hpp"
+
+namespace CommsLink {
+
+FileReceiver::FileReceiver(Protocol &protocol, const QString &aDirectory,
+                           QObject *parent) :
+    QObject(parent), directory(aDirectory)
+{
+    connect(&protocol, &Protocol::dataReceived,
+            this, &FileReceiver::dataReceived);
+    connect(&protocol, &Protocol::connectionChanged,
+            this, [this](bool connected) {
+        if (!connected) {
+            abandon();
+        }
+    });
+}
+
+QString FileReceiver::localPath(const QByteArray &remoteName) const {
+    // Device names may include a pack prefix such as "A:"; keep only what's
+    // safe in a host file name.
+    QString name;
+    for (const char c : remoteName) {
+        const bool safe = (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z')
+                || (c >= '0' && c <= '9') || c == '.' || c == '-'
+                || c == '_';
+        name.append(safe ? QLatin1Char(c) : QLatin1Char('_'));
+    }
+    if (name.isEmpty() || name == "." || name == "..") {
+        name = "UNNAMED";
+    }
+    return QDir(directory).filePath(name);
+}
+
+qint64 FileReceiver::bytesReceived() const {
+    return writer != nullptr ? writer->size() : 0;
+}
+
+void FileReceiver::dataReceived(MessageRef msg) {
+    const auto &payload = msg->data;
+    if (payload.isEmpty()) {
+        return;
+    }
+    switch (static_cast<FileOp>(payload.at(0))) {
+    case FileOp::open: {
+        if (writer != nullptr) {
+            qWarning() << "File" << writer->path()
+                       << "was never closed; discarding it";
+        }
+        abandon();
+        const auto remoteName = payload.mid(1);
+        writer = new BufferedWriter(localPath(remoteName), this);
+        connect(writer, &BufferedWriter::finished,
+                this, [this, done = writer](bool success) {
+            saving--;
+            done->deleteLater();
+            emit fileReceived(done->path(), success);
+        });
+        emit fileStarted(remoteName);
+        break;
+    }
+    case FileOp::data:
+        if (writer == nullptr) {
+            qWarning() << "Ignoring data for no file";
+            return;
+        }
+        writer->append(payload.constData() + 1, payload.size() - 1);
+        emit progress(writer->size());
+        break;
+    case FileOp::close:
+        if (writer == nullptr) {
+            qWarning() << "Ignoring close of no file";
+            return;
+        }
+        // The writer finishes on its own, and a new file can start
+        // meanwhile.
+        saving++;
+        writer->close();
+        writer = nullptr;
+        break;
+    default:
+        qWarning() << "Ignoring file operation"
+                   << static_cast<int>(payload.at(0));
+        break;
+    }
+}
+
+void FileReceiver::abandon() {
+    if (writer == nullptr) {
+        return;
+    }
+    const auto path = writer->path();
+    // Destroying the writer discards what it's written.
+    delete writer;
+    writer = nullptr;
+    emit fileReceived(path, false);
+}
+}
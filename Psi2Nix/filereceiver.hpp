@@ -0,0 +1,60 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+
+#include "bufferedwriter.hpp"
+#include "protocol.hpp"
+
+namespace CommsLink {
+
+/// \brief Saves the files the device sends through the file layer into a
+/// directory on the host.
+///
+/// Each file's data is handed to a BufferedWriter as its frames arrive,
+/// and the Protocol acknowledges them without waiting for the disk, so
+/// files come in at line speed however slow the storage. A file is only
+/// saved under its name once all of it has been received; one that's cut
+/// short by the device disconnecting is discarded.
+class FileReceiver : public QObject
+{
+    Q_OBJECT
+public:
+    /// \param directory Where to save the files, which must exist.
+    FileReceiver(Protocol &protocol, const QString &directory,
+                 QObject *parent = nullptr);
+    /// \brief Return the host path a file from the device is saved as.
+    QString localPath(const QByteArray &remoteName) const;
+    /// \brief Return the number of bytes received of the file being
+    /// received, if any.
+    qint64 bytesReceived() const;
+    /// \brief Return true iff a file is being received, or has been but
+    /// is still being saved.
+    bool isReceiving() const { return writer != nullptr || saving > 0; }
+
+signals:
+    /// \brief Emitted when the device starts sending a file.
+    void fileStarted(const QByteArray &remoteName);
+    /// \brief Emitted as each part of a file is received.
+    void progress(qint64 bytesReceived);
+    /// \brief Emitted when a file has been saved, or couldn't be.
+    void fileReceived(const QString &path, bool success);
+
+private slots:
+    void dataReceived(CommsLink::MessageRef msg);
+
+private:
+    /// \brief Discard the file being received, if any.
+    void abandon();
+
+    QString directory;
+    /// \brief Writing the file being received, if any; files that have
+    /// been closed finish writing by themselves.
+    BufferedWriter *writer = nullptr;
+    /// \brief The number of files closed but not yet saved.
+    int saving = 0;
+};
+}
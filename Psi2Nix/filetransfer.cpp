@@ -0,0 +1,251 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "filetransfer.hpp"
+
+#include <QPointer>
+#include <QtDebug>
+
+#include <algorithm>
+
+namespace CommsLink {
+
+// The number of messages kept queued on the Protocol.
+constexpr int PIPELINE_DEPTH = 2;
+// The size of the window of the file mapped at once.
+constexpr qint64 MAP_WINDOW = 64 * 1024;
+
+namespace {
+// Return the number of wire bytes taken by a payload, once its 0x10s have
+// been escaped.
+qint64 wireLength(const QByteArray &payload) {
+    return payload.size() + payload.count('\x10');
+}
+}
+
+FileTransfer::FileTransfer(Protocol &aProtocol, QObject *parent) :
+    QObject(parent), protocol(aProtocol)
+{
+    connect(&protocol, &Protocol::backpressure,
+            this, [this](bool congested) {
+        if (!congested) {
+            pump();
+        }
+    });
+}
+
+bool FileTransfer::start(const QString &path, const QByteArray &aRemoteName,
+                         Conversion conversion) {
+    Q_ASSERT(!active);
+    // The open request carries the name in a single frame, after the
+    // operation byte, as a data chunk would be.
+    if (aRemoteName.isEmpty()
+            || wireLength(aRemoteName) > PayloadPlanner::MAX_BUDGET) {
+        qWarning() << "Can't send" << path << "as" << aRemoteName
+                   << ": the name is empty or too long";
+        return false;
+    }
+    file.setFileName(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Unable to open" << path << ":" << file.errorString();
+        return false;
+    }
+    remoteName = aRemoteName;
+    size = file.size();
+    readPos = 0;
+    sent = 0;
+    stored = 0;
+    inFlight = 0;
+    retransmissions = protocol.retransmissions();
+    openSent = false;
+    closeQueued = false;
+    if (conversion == Conversion::text) {
+        records = std::make_unique<RecordStream>(file);
+        connect(records.get(), &RecordStream::recordsReady,
+                this, &FileTransfer::pump);
+        records->start();
+    } else if (size > 0 && !remap()) {
+        qDebug() << "Unable to map" << path << "; reading instead";
+    }
+    active = true;
+    pump();
+    return true;
+}
+
+void FileTransfer::pump() {
+    while (active && inFlight < PIPELINE_DEPTH && !closeQueued) {
+        if (records && openSent && !records->isReady()) {
+            // Wait for the next piece to be converted.
+            return;
+        }
+        // Remember where we were in case the queue is full.
+        const auto savedReadPos = readPos;
+        const auto savedOpenSent = openSent;
+        Message msg;
+        qint64 chunkSize = 0;
+        qint64 wireBytes = 0;
+        if (!nextMessage(msg, chunkSize, wireBytes)) {
+            finish(false);
+            return;
+        }
+        const bool isClose = closeQueued;
+        const qint64 dataSize =
+                msg.data.at(0) == static_cast<char>(FileOp::data)
+                ? msg.data.size() - 1 : 0;
+        QPointer<FileTransfer> self(this);
+        const bool queued = protocol.enqueue(
+                    msg, [self, chunkSize, dataSize, wireBytes,
+                          isClose](bool success) {
+            if (!self || !self->active) {
+                return;
+            }
+            self->inFlight--;
+            if (!success) {
+                self->finish(false);
+                return;
+            }
+            const auto total = self->protocol.retransmissions();
+            self->payloadPlanner.frameAcknowledged(
+                        wireBytes,
+                        static_cast<int>(total - self->retransmissions));
+            self->retransmissions = total;
+            self->sent += chunkSize;
+            self->stored += dataSize;
+            if (chunkSize > 0) {
+                emit self->progress(self->sent, self->size);
+            }
+            if (isClose) {
+                self->finish(true);
+            } else {
+                self->pump();
+            }
+        });
+        if (!queued) {
+            // Try again once the queue has drained.
+            if (records && savedOpenSent && !isClose) {
+                records->untake();
+            }
+            readPos = savedReadPos;
+            openSent = savedOpenSent;
+            closeQueued = false;
+            if (window == nullptr && !records) {
+                file.seek(readPos);
+            }
+            return;
+        }
+        inFlight++;
+    }
+}
+
+bool FileTransfer::nextMessage(Message &msg, qint64 &chunkSize,
+                               qint64 &wireBytes) {
+    msg.type = PacketType::data;
+    chunkSize = 0;
+    if (!openSent) {
+        msg.data.reserve(1 + remoteName.size());
+        msg.data.append(static_cast<char>(FileOp::open));
+        msg.data.append(remoteName);
+        openSent = true;
+        wireBytes = wireLength(msg.data);
+        return true;
+    }
+    if (records) {
+        const bool ok = nextRecord(msg, chunkSize);
+        wireBytes = wireLength(msg.data);
+        return ok;
+    }
+    if (readPos >= size) {
+        msg.data = QByteArray(1, static_cast<char>(FileOp::close));
+        closeQueued = true;
+        wireBytes = 1;
+        return true;
+    }
+    const auto budget = payloadPlanner.budget();
+    msg.data.reserve(static_cast<int>(1 + budget));
+    msg.data.append(static_cast<char>(FileOp::data));
+    if (window != nullptr) {
+        // Slide the window on if the next chunk might run off its end.
+        const auto windowEnd = windowStart + windowSize;
+        if (readPos + budget > windowEnd && windowEnd < size
+                && !remap()) {
+            qDebug() << "Unable to remap" << file.fileName()
+                     << "; reading instead";
+            file.seek(readPos);
+        }
+    }
+    if (window != nullptr) {
+        const auto *src = reinterpret_cast<const char *>(window)
+                + (readPos - windowStart);
+        chunkSize = payloadPlanner.plan(
+                    src, windowStart + windowSize - readPos, wireBytes);
+        msg.data.append(src, static_cast<int>(chunkSize));
+    } else {
+        const auto peeked = file.peek(budget);
+        chunkSize = payloadPlanner.plan(peeked.constData(), peeked.size(),
+                                        wireBytes);
+        if (chunkSize == 0 || !file.seek(readPos + chunkSize)) {
+            qWarning() << "Unable to read" << file.fileName() << ":"
+                       << file.errorString();
+            return false;
+        }
+        msg.data.append(peeked.constData(), static_cast<int>(chunkSize));
+    }
+    readPos += chunkSize;
+    // The operation byte.
+    wireBytes++;
+    return true;
+}
+
+bool FileTransfer::nextRecord(Message &msg, qint64 &chunkSize) {
+    Record record;
+    if (records->take(record)) {
+        msg.data.reserve(1 + record.data.size());
+        msg.data.append(static_cast<char>(FileOp::data));
+        msg.data.append(record.data);
+        chunkSize = record.sourceBytes;
+        readPos += chunkSize;
+        return true;
+    }
+    if (records->hasError()) {
+        qWarning() << "Unable to read" << file.fileName() << ":"
+                   << file.errorString();
+        return false;
+    }
+    // Every record has been queued; count any bytes left over, such as a
+    // final line ending, with the close.
+    Q_ASSERT(records->atEnd());
+    msg.data = QByteArray(1, static_cast<char>(FileOp::close));
+    chunkSize = size - readPos;
+    readPos = size;
+    closeQueued = true;
+    return true;
+}
+
+bool FileTransfer::remap() {
+    if (window != nullptr) {
+        file.unmap(window);
+    }
+    windowStart = readPos;
+    windowSize = std::min(MAP_WINDOW, size - readPos);
+    window = file.map(windowStart, windowSize);
+    return window != nullptr;
+}
+
+void FileTransfer::finish(bool success) {
+    active = false;
+    if (records) {
+        if (records->splitLines() > 0) {
+            qWarning() << records->splitLines() << "line(s) of"
+                       << file.fileName() << "were too long for one record";
+        }
+        // Waits for any conversion still using the file.
+        records.reset();
+    }
+    if (window != nullptr) {
+        file.unmap(window);
+        window = nullptr;
+    }
+    file.close();
+    emit finished(success);
+}
+}
@@ -0,0 +1,108 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QFile>
+#include <QObject>
+
+#include <memory>
+
+#include "payloadplanner.hpp"
+#include "protocol.hpp"
+#include "recordstream.hpp"
+
+namespace CommsLink {
+
+/// \brief Operations in the file layer; the first byte of each data
+/// message's payload.
+enum struct FileOp : quint8 {
+    open  = 0x00, //!< Create a file; followed by its name
+    data  = 0x01, //!< Followed by the next part of the file, or record
+    close = 0x02, //!< End of file
+    remove = 0x03 //!< Delete a file; followed by its name
+};
+
+/// \brief Sends one host file to the device through the file layer.
+///
+/// The file is read through a small memory-mapped window (or read in
+/// frame-sized pieces if it can't be mapped) and sent as data messages
+/// sized by a PayloadPlanner, which fills each one as close to MAX_MSG_SIZE
+/// as its escaping allows unless the line is noisy. Only a couple
+/// of messages are queued on the Protocol at a time, so memory use doesn't
+/// grow with the size of the file.
+///
+/// A text file can instead be converted into records as it's sent, with a
+/// RecordStream converting ahead of the frames being transmitted; each
+/// record then goes in a data message of its own.
+class FileTransfer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileTransfer(Protocol &protocol, QObject *parent = nullptr);
+    /// \brief Start sending a file.
+    /// \param path The file on the host.
+    /// \param remoteName The name to give it on the device.
+    /// \param conversion How to convert the file on the way.
+    /// \return false if the file couldn't be opened, or \p remoteName is
+    /// empty or won't fit in a frame.
+    bool start(const QString &path, const QByteArray &remoteName,
+               Conversion conversion = Conversion::none);
+    /// \brief Return the number of bytes of the file sent so far.
+    qint64 bytesSent() const { return sent; }
+    /// \brief Return the size of the file being sent.
+    qint64 totalBytes() const { return size; }
+    /// \brief Return the bytes of file data the device has acknowledged;
+    /// for a converted file, the total length of its records.
+    qint64 bytesStored() const { return stored; }
+    /// \brief Return the planner sizing the data messages.
+    const PayloadPlanner &planner() const { return payloadPlanner; }
+signals:
+    /// \brief Emitted as each part of the file is sent.
+    void progress(qint64 bytesSent, qint64 totalBytes);
+    /// \brief Emitted when the transfer has ended.
+    void finished(bool success);
+
+private slots:
+    /// \brief Queue messages until the pipeline is full.
+    void pump();
+
+private:
+    /// \brief Build the next message to be sent from the file.
+    /// \param[out] chunkSize The number of bytes of the file it contains.
+    /// \param[out] wireBytes The number of wire bytes its payload takes.
+    /// \return false if the file couldn't be read.
+    bool nextMessage(Message &msg, qint64 &chunkSize, qint64 &wireBytes);
+    /// \brief Build the next message from the converted records.
+    bool nextRecord(Message &msg, qint64 &chunkSize);
+    /// \brief Map the window of the file starting at the read position.
+    bool remap();
+    void finish(bool success);
+
+    Protocol &protocol;
+    PayloadPlanner payloadPlanner;
+    /// \brief The protocol's retransmission count when the last message
+    /// completed.
+    quint64 retransmissions = 0;
+    QFile file;
+    QByteArray remoteName;
+    /// \brief Converts the file into records, if it's being converted.
+    std::unique_ptr<RecordStream> records;
+    /// \brief The mapped window of the file, or nullptr if reading.
+    uchar *window = nullptr;
+    /// \brief The offset in the file of the start of the mapped window.
+    qint64 windowStart = 0;
+    qint64 windowSize = 0;
+    /// \brief The offset in the file of the next byte to be queued; when
+    /// converting, the number of bytes accounted for by records queued.
+    qint64 readPos = 0;
+    qint64 size = 0;
+    qint64 sent = 0;
+    qint64 stored = 0;
+    /// \brief The number of messages queued but not yet sent.
+    int inFlight = 0;
+    bool openSent = false;
+    bool closeQueued = false;
+    bool active = false;
+};
+}
@@ -0,0 +1,159 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "framedecoder.hpp"
+#include "crc16.hpp"
+#include "eventtrace.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace CommsLink {
+
+// Framing characters.
+constexpr quint8 SYN = 0x16;
+constexpr quint8 DLE = 0x10;
+constexpr quint8 STX = 0x02;
+constexpr quint8 ETX = 0x03;
+
+FrameDecoder::FrameDecoder()
+{
+    body.reserve(MAX_MSG_SIZE);
+}
+
+qint64 FrameDecoder::decode(const char *data, qint64 size) {
+    qint64 pos = 0;
+    while (pos < size && !ready) {
+        if (state == State::body) {
+            // Take everything up to the next 0x10 in one go.
+            const char *run = data + pos;
+            const auto limit = std::min(size - pos,
+                                        qint64{MAX_MSG_SIZE - frameSize});
+            const auto dle = static_cast<const char *>(
+                        std::memchr(run, DLE, static_cast<size_t>(limit)));
+            const auto runLength = dle ? dle - run : limit;
+            checksum = crc16(checksum, run, runLength);
+            body.append(run, static_cast<int>(runLength));
+            frameSize += static_cast<int>(runLength);
+            pos += runLength;
+            if (pos == size) {
+                break;
+            }
+        }
+        const auto b = static_cast<quint8>(data[pos++]);
+        if (state >= State::channel && ++frameSize > MAX_MSG_SIZE) {
+            traceEvent<TraceLevel::warning>(TraceEventId::oversizeFrame,
+                                            MAX_MSG_SIZE);
+            resync(b);
+            continue;
+        }
+        switch (state) {
+        case State::idle:
+            if (b == SYN) {
+                state = State::sync;
+            }
+            break;
+        case State::sync:
+            if (b == DLE) {
+                state = State::dle;
+            } else {
+                resync(b);
+            }
+            break;
+        case State::dle:
+            if (b == STX) {
+                state = State::channel;
+                frameSize = 3;
+            } else {
+                resync(b);
+            }
+            break;
+        case State::channel:
+            checksum = crc16Update(0x0000, b);
+            body.resize(0);
+            state = State::body;
+            break;
+        case State::body:
+            // The run above only stops short of the input at a 0x10.
+            Q_ASSERT(b == DLE);
+            state = State::bodyEscape;
+            break;
+        case State::bodyEscape:
+            if (b == DLE) {
+                // Stuffed 0x10.
+                checksum = crc16Update(checksum, b);
+                body.append(static_cast<char>(b));
+                state = State::body;
+            } else if (b == ETX) {
+                state = State::crcHigh;
+            } else if (b == STX && !body.isEmpty()
+                       && static_cast<quint8>(body.back()) == SYN) {
+                // 0x16 0x10 0x02 can't occur in a valid body, so the
+                // previous frame was truncated and this is a new one.
+                traceEvent<TraceLevel::warning>(
+                            TraceEventId::truncatedFrame);
+                state = State::channel;
+                frameSize = 3;
+            } else {
+                resync(b);
+            }
+            break;
+        case State::crcHigh:
+            receivedChecksum = static_cast<quint16>(b << 8);
+            state = State::crcLow;
+            break;
+        case State::crcLow:
+            receivedChecksum |= b;
+            state = State::idle;
+            if (body.isEmpty()) {
+                traceEvent<TraceLevel::warning>(TraceEventId::untypedFrame);
+            } else if (receivedChecksum != checksum) {
+                traceEvent<TraceLevel::warning>(TraceEventId::badCrc,
+                                                checksum, receivedChecksum);
+                numCrcErrors++;
+            } else {
+                traceEvent<TraceLevel::debug>(TraceEventId::frameDecoded,
+                                              body.size() - 1);
+                ready = true;
+            }
+            break;
+        }
+    }
+    return pos;
+}
+
+Message FrameDecoder::takeMessage() {
+    Message msg;
+    takeMessage(msg);
+    return msg;
+}
+
+void FrameDecoder::takeMessage(Message &msg) {
+    Q_ASSERT(ready);
+    const auto typeField = static_cast<quint8>(body.at(0));
+    msg.type = static_cast<PacketType>(typeField >> 3);
+    msg.sequenceNo = typeField & 0x7;
+    // Drop the type byte in place and hand the buffer over.
+    body.remove(0, 1);
+    msg.data.swap(body);
+    if (body.isDetached() && body.capacity() >= MAX_MSG_SIZE) {
+        body.resize(0);
+    } else {
+        body = QByteArray();
+        body.reserve(MAX_MSG_SIZE);
+    }
+    ready = false;
+}
+
+void FrameDecoder::reset() {
+    state = State::idle;
+    frameSize = 0;
+    ready = false;
+}
+
+void FrameDecoder::resync(quint8 b) {
+    traceEvent<TraceLevel::debug>(TraceEventId::framingError);
+    frameSize = 0;
+    state = (b == SYN) ? State::sync : State::idle;
+}
+}
@@ -0,0 +1,72 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QByteArray>
+
+#include "message.hpp"
+
+namespace CommsLink {
+
+/// \brief Incremental decoder for frames received over the link.
+///
+/// Received bytes are fed through a state machine one at a time; the
+/// unescaping and CRC state are kept between calls, so a frame may arrive
+/// split across any number of reads and several frames may arrive in one.
+/// Anything that isn't part of a frame is skipped until the next
+/// 0x16 0x10 0x02 preamble.
+class FrameDecoder
+{
+public:
+    FrameDecoder();
+    /// \brief Feed received bytes to the decoder.
+    ///
+    /// Decoding stops after the last byte of a frame's CRC, so that the
+    /// caller can take the message before feeding the remainder.
+    /// \return The number of bytes consumed.
+    qint64 decode(const char *data, qint64 size);
+    /// \brief Return true iff a complete frame with a valid CRC has been
+    /// decoded and not yet taken.
+    bool hasMessage() const { return ready; }
+    /// \brief Return the decoded message and resume decoding.
+    Message takeMessage();
+    /// \brief Move the decoded message into \p msg and resume decoding.
+    ///
+    /// The payload's buffer is exchanged for \p msg's old one, so if that
+    /// has room for a whole frame and isn't shared, nothing is allocated
+    /// or copied.
+    void takeMessage(Message &msg);
+    /// \brief Discard any partially-received frame.
+    void reset();
+    /// \brief Return true iff the decoder is not within a frame.
+    bool isIdle() const { return state == State::idle; }
+    /// \brief Return the number of frames dropped due to a bad CRC.
+    quint64 crcErrors() const { return numCrcErrors; }
+private:
+    enum struct State : quint8 {
+        idle,       //!< Waiting for 0x16
+        sync,       //!< Received 0x16; waiting for 0x10
+        dle,        //!< Received 0x16 0x10; waiting for 0x02
+        channel,    //!< Waiting for channel number
+        body,       //!< Receiving type and data
+        bodyEscape, //!< Received 0x10 within the body
+        crcHigh,    //!< Waiting for first CRC byte
+        crcLow      //!< Waiting for second CRC byte
+    };
+    /// \brief Abandon the current frame; \p b is the offending byte,
+    /// which may itself begin the next preamble.
+    void resync(quint8 b);
+    State state = State::idle;
+    /// \brief The CRC of the current frame so far.
+    quint16 checksum = 0;
+    /// \brief The CRC received at the end of the current frame.
+    quint16 receivedChecksum = 0;
+    /// \brief Wire bytes received so far in the current frame.
+    int frameSize = 0;
+    /// \brief The unescaped type and data bytes of the current frame.
+    QByteArray body;
+    bool ready = false;
+    quint64 numCrcErrors = 0;
+};
+}
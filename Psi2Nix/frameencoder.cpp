@@ -0,0 +1,67 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "frameencoder.hpp"
+#include "crc16.hpp"
+
+#include <cstring>
+
+namespace CommsLink {
+
+// Start and end sequences
+constexpr char packetStart[]{0x16, 0x10, 0x02};
+constexpr char dataEnd[]{0x10, 0x03};
+constexpr char DLE = 0x10;
+constexpr char CHANNEL = 0x01;
+
+bool FrameEncoder::encode(PacketType type, quint8 sequenceNo,
+                          const char *data, qint64 size) {
+    len = 0;
+    // As it happens, qChecksum calculates the CRC-16 using the CCITT
+    // polynomial, which is exactly what the Psion protocol uses.
+    //
+    // Sadly, since we want to ignore byte-stuffing and also checksum the
+    // channel/type/sequence bytes, we'd need to generate a QByteArray
+    // with the c/t/s and then an un-byte-stuffed copy of data if we were
+    // to use qChecksum. So I'm DIYing here.
+    const auto seqAndType = static_cast<quint8>(
+                (static_cast<quint8>(type) << 3) | (sequenceNo & 0x7));
+    quint16 checksum = crc16Update(0x0000, CHANNEL);
+    checksum = crc16Update(checksum, seqAndType);
+    checksum = crc16(checksum, data, size);
+
+    put(packetStart, sizeof(packetStart));
+    put(&CHANNEL, 1);
+    const auto typeByte = static_cast<char>(seqAndType);
+    put(&typeByte, 1);
+    if (typeByte == DLE) {
+        // Escape it.
+        put(&DLE, 1);
+    }
+    // Write data, escaping 0x10 by copying each run up to and including
+    // it, then repeating it.
+    const char *pos = data;
+    const char *const end = data + size;
+    while (pos < end) {
+        const auto dle = static_cast<const char *>(
+                    std::memchr(pos, DLE, static_cast<size_t>(end - pos)));
+        const char *runEnd = dle ? dle + 1 : end;
+        if (!put(pos, runEnd - pos) || (dle && !put(&DLE, 1))) {
+            return false;
+        }
+        pos = runEnd;
+    }
+    const char crc[]{static_cast<char>(checksum >> 8),
+                     static_cast<char>(checksum & 0xff)};
+    return put(dataEnd, sizeof(dataEnd)) && put(crc, sizeof(crc));
+}
+
+bool FrameEncoder::put(const char *data, qint64 size) {
+    if (len + size > static_cast<qint64>(buf.size())) {
+        return false;
+    }
+    std::memcpy(buf.data() + len, data, static_cast<size_t>(size));
+    len += size;
+    return true;
+}
+}
@@ -0,0 +1,41 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <array>
+
+#include "message.hpp"
+
+namespace CommsLink {
+
+/// \brief Encoder for frames to be sent over the link.
+///
+/// Frames are built in a fixed buffer owned by the encoder, which is
+/// reused for every frame; the encoded frame remains valid until the next
+/// call to encode().
+class FrameEncoder
+{
+public:
+    /// \brief Encode a frame, replacing any previously-encoded one.
+    /// \param type The packet type.
+    /// \param sequenceNo The sequence number (0..7).
+    /// \param data The unescaped payload.
+    /// \param size The length of the payload.
+    /// \return true iff the encoded frame fits within MAX_MSG_SIZE.
+    bool encode(PacketType type, quint8 sequenceNo,
+                const char *data, qint64 size);
+    /// \brief Return the encoded frame.
+    const char *data() const { return buf.data(); }
+    /// \brief Return the length of the encoded frame.
+    qint64 size() const { return len; }
+private:
+    /// \brief Append a run of bytes to the frame.
+    /// \return false if there isn't enough room.
+    bool put(const char *data, qint64 size);
+    std::array<char, MAX_MSG_SIZE> buf;
+    qint64 len = 0;
+};
+}
@@ -0,0 +1,165 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "hotplugsource.hpp"
+
+#include <QSocketNotifier>
+#include <QtDebug>
+#include <QtEndian>
+
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#include <linux/netlink.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace CommsLink {
+
+namespace {
+// The header udev puts before the properties of the events it broadcasts.
+struct UdevHeader {
+    char prefix[8];           // "libudev"
+    quint32 magic;            // UDEV_MAGIC, big-endian
+    quint32 headerSize;
+    quint32 propertiesOffset;
+    quint32 propertiesLength;
+};
+constexpr quint32 UDEV_MAGIC = 0xfeedcafe;
+// The netlink multicast group udev broadcasts to; the kernel's is 1.
+constexpr int UDEV_GROUP = 2;
+// The largest message we expect.
+constexpr int MAX_UEVENT = 8192;
+}
+
+bool parseUevent(const char *data, qint64 size, Uevent &event) {
+    event.action.clear();
+    event.properties.clear();
+    const char *pos = data;
+    const char *end = data + size;
+    if (size >= static_cast<qint64>(sizeof(UdevHeader))
+            && std::memcmp(data, "libudev", 8) == 0) {
+        UdevHeader header;
+        std::memcpy(&header, data, sizeof(header));
+        if (qFromBigEndian(header.magic) != UDEV_MAGIC
+                || header.propertiesOffset < sizeof(UdevHeader)
+                || header.propertiesOffset > size
+                || header.propertiesLength
+                > size - header.propertiesOffset) {
+            return false;
+        }
+        pos = data + header.propertiesOffset;
+        end = pos + header.propertiesLength;
+    } else {
+        // The kernel's start with "action@devpath".
+        const auto *first = static_cast<const char *>(
+                    std::memchr(data, '\0', static_cast<size_t>(size)));
+        if (first == nullptr
+                || std::memchr(data, '@', static_cast<size_t>(first - data))
+                == nullptr) {
+            return false;
+        }
+        pos = first + 1;
+    }
+    while (pos < end) {
+        const auto *terminator = static_cast<const char *>(
+                    std::memchr(pos, '\0', static_cast<size_t>(end - pos)));
+        const auto *fieldEnd = terminator != nullptr ? terminator : end;
+        const auto *equals = static_cast<const char *>(
+                    std::memchr(pos, '=', static_cast<size_t>(fieldEnd - pos)));
+        if (equals != nullptr) {
+            event.properties.insert(
+                        QByteArray(pos, static_cast<int>(equals - pos)),
+                        QByteArray(equals + 1,
+                                   static_cast<int>(fieldEnd - equals - 1)));
+        }
+        pos = fieldEnd + 1;
+    }
+    event.action = event.properties.value("ACTION");
+    return !event.action.isEmpty();
+}
+
+QString ueventPortName(const Uevent &event) {
+    auto name = event.properties.value("DEVNAME");
+    if (name.startsWith("/dev/")) {
+        name.remove(0, 5);
+    }
+    return QString::fromLocal8Bit(name);
+}
+
+UeventHotplugSource::~UeventHotplugSource() {
+#ifdef Q_OS_LINUX
+    if (socket >= 0) {
+        ::close(socket);
+    }
+#endif
+}
+
+bool UeventHotplugSource::start() {
+#ifdef Q_OS_LINUX
+    if (socket >= 0) {
+        return true;
+    }
+    socket = ::socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK,
+                      NETLINK_KOBJECT_UEVENT);
+    if (socket < 0) {
+        qWarning() << "Unable to watch for ports:" << std::strerror(errno);
+        return false;
+    }
+    sockaddr_nl address{};
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = UDEV_GROUP;
+    if (::bind(socket, reinterpret_cast<sockaddr *>(&address),
+               sizeof(address)) < 0) {
+        qWarning() << "Unable to watch for ports:" << std::strerror(errno);
+        ::close(socket);
+        socket = -1;
+        return false;
+    }
+    notifier = new QSocketNotifier(socket, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated,
+            this, &UeventHotplugSource::readEvents);
+    return true;
+#else
+    return false;
+#endif
+}
+
+void UeventHotplugSource::readEvents() {
+#ifdef Q_OS_LINUX
+    char buffer[MAX_UEVENT];
+    for (;;) {
+        const auto size = ::recv(socket, buffer, sizeof(buffer), 0);
+        if (size <= 0) {
+            // Drained (EAGAIN), or nothing more to be had.
+            return;
+        }
+        Uevent event;
+        if (!parseUevent(buffer, size, event)
+                || event.properties.value("SUBSYSTEM") != "tty") {
+            continue;
+        }
+        const auto name = ueventPortName(event);
+        if (name.isEmpty()) {
+            continue;
+        }
+        if (event.action == "add") {
+            // Virtual consoles and the like have no bus behind them.
+            if (!event.properties.contains("ID_BUS")) {
+                continue;
+            }
+            auto description = event.properties.value(
+                        "ID_MODEL_FROM_DATABASE");
+            if (description.isEmpty()) {
+                description = event.properties.value("ID_MODEL");
+                description.replace('_', ' ');
+            }
+            emit portAdded(name, QString::fromLocal8Bit(description));
+        } else if (event.action == "remove") {
+            emit portRemoved(name);
+        }
+    }
+#endif
+}
+}
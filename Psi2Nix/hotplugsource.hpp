@@ -0,0 +1,72 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QObject>
+#include <QString>
+
+class QSocketNotifier;
+
+namespace CommsLink {
+
+/// \brief Reports serial ports as they appear and disappear.
+class HotplugSource : public QObject
+{
+    Q_OBJECT
+public:
+    using QObject::QObject;
+    /// \brief Start watching.
+    /// \return false if ports can't be watched here.
+    virtual bool start() = 0;
+
+signals:
+    /// \brief Emitted when a port appears.
+    void portAdded(const QString &name, const QString &description);
+    /// \brief Emitted when a port disappears.
+    void portRemoved(const QString &name);
+};
+
+/// \brief A device event, as broadcast by the Linux kernel or by udev.
+struct Uevent {
+    /// \brief "add", "remove", "change" and so on.
+    QByteArray action;
+    /// \brief KEY=value pairs such as SUBSYSTEM and DEVNAME.
+    QHash<QByteArray, QByteArray> properties;
+};
+
+/// \brief Parse one uevent message, in either the kernel's format or
+/// udev's.
+/// \return false if it isn't a well-formed message.
+bool parseUevent(const char *data, qint64 size, Uevent &event);
+
+/// \brief Return the name of the port \p event is about, as QSerialPortInfo
+/// would name it, or an empty string if it names none.
+///
+/// The kernel gives DEVNAME relative to /dev; udev gives the full path.
+QString ueventPortName(const Uevent &event);
+
+/// \brief Watches for serial ports by listening to udev's broadcasts on a
+/// netlink socket; only works on Linux.
+///
+/// udev's broadcasts come once the device node has been created and
+/// carry the properties it has looked up, so a port can be opened and
+/// described as soon as it's reported without another scan.
+class UeventHotplugSource : public HotplugSource
+{
+    Q_OBJECT
+public:
+    using HotplugSource::HotplugSource;
+    ~UeventHotplugSource() override;
+    bool start() override;
+
+private:
+    /// \brief Handle every message waiting on the socket.
+    void readEvents();
+
+    int socket = -1;
+    QSocketNotifier *notifier = nullptr;
+};
+}
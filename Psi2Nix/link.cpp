@@ -2,64 +2,40 @@
 // Licensed under the MIT License (LICENSE.txt in this repository).
 
 #include "link.hpp"
-#include <array>
+#include "controlframes.hpp"
+#include "eventtrace.hpp"
+
 #include <QDebug>
 #include <QTextStream>
 
+#include <algorithm>
+
 namespace CommsLink {
 
-// Minimum and maximum sizes for a received message.
-const int MIN_MSG_SIZE = 0x009;
-const int MAX_MSG_SIZE = 0x200;
 // Timeout value - maximum time without any data received
-// before input buffer flushed.
+// before a partially-received frame is discarded.
 const std::chrono::milliseconds timeoutValue{250};
-
-// Start and end sequences
-constexpr char packetStart[]{0x16, 0x10, 0x02};
-constexpr char dataEnd[]{0x10, 0x03};
-const QByteArray postamble(dataEnd, sizeof(dataEnd));
+// Initial capacity of the read buffer.
+constexpr int READ_BUFFER_SIZE = 4096;
 
 Link::Link(QObject *parent) : QObject(parent)
 {
-    // add one for the '\0' terminator.
-    readBuf.reserve(MAX_MSG_SIZE + 1);
-
-    readTimer = new QTimer(this);
-    connect(readTimer, &QTimer::timeout,
-            this, &Link::readTimeout);
+    qRegisterMetaType<CommsLink::MessageRef>();
+    readBuf.reserve(READ_BUFFER_SIZE);
+    setClock(Clock::system());
 }
 
 Link::~Link() {
     delete readTimer;
 }
 
-// Generate the lookup table for our CRC-16 function.
-constexpr quint16 CRC16_POLYNOMIAL = 0xa001;
-constexpr quint16 crc16Byte(quint8 b) {
-    quint16 c = b;
-    quint16 crc = 0x0000;
-    for (quint16 j = 0; j<8; j++) {
-        if ((crc^c)& 0x0001) {
-            crc = static_cast<quint16>((crc >> 1) ^ CRC16_POLYNOMIAL);
-        } else {
-            crc >>= 1;
-        }
-        c >>= 1;
-    }
-    return static_cast<quint16>(((crc & 0xff) << 8) | (crc>>8));
-}
-
-constexpr std::array<quint16, 256> initCRC16Table() {
-    std::array<quint16, 256> res{0};
-    for (quint16 i = 0; i < 256; i++) {
-        res[i] = crc16Byte(static_cast<quint8>(i));
-    }
-    return res;
+void Link::setClock(Clock &clock) {
+    delete readTimer;
+    readTimer = clock.createTimer(this);
+    connect(readTimer, &ClockTimer::timeout,
+            this, &Link::readTimeout);
 }
 
-constexpr std::array<quint16, 256> crc16table = initCRC16Table();
-
 void Link::setPort(QIODevice &aPort) {
     // TODO disconnect bytesWritten from old?
     port = &aPort;
@@ -71,59 +47,52 @@ void Link::setPort(QIODevice &aPort) {
 }
 
 bool Link::send(const Message &msg) {
-    if (!busy.tryLock()) {
-        // Unable to acquire a lock.
+    // Increment sequence number for next packet - only if data.
+    if (msg.type != PacketType::data) {
+        return send(msg, 0);
+    }
+    const auto thisSeq = static_cast<quint8>((nextSeq + 1) % 8);
+    if (!send(msg, thisSeq)) {
         return false;
     }
-    // As it happens, qChecksum calculates the CRC-16 using the CCITT
-    // polynomial, which is exactly what the Psion protocol uses.
-    //
-    // Sadly, since we want to ignore byte-stuffing and also checksum the
-    // channel/type/sequence bytes, we'd need to generate a QByteArray
-    // with the c/t/s and then an un-byte-stuffed copy of data if we were
-    // to use qChecksum. So I'm DIYing here.
-    quint16 checksum = 0x0000;
-    const auto checkByte = [&](quint8 b){
-        checksum = static_cast<quint16>((checksum << 8)
-                                        ^ crc16table[b ^ (checksum >> 8)]);
-    };
-    writeBuf.open(QBuffer::ReadWrite);
-    writeBuf.write(packetStart, sizeof(packetStart));
-    writeBuf.putChar(0x01); // channel number
-    checkByte(0x01);
-    // Increment sequence number for next packet - only if data.
-    quint8 thisSeq = 0;
-    if (msg.type == PacketType::data) {
-        nextSeq++;
-        thisSeq = static_cast<quint8>(nextSeq);
+    nextSeq = thisSeq;
+    return true;
+}
+
+bool Link::send(const Message &msg, quint8 sequenceNo) {
+    if (busy) {
+        linkMetrics->busyRejection();
+        return false;
     }
-    quint8 seqAndType = static_cast<quint8>(
-                (static_cast<quint8>(msg.type) << 3)
-                | thisSeq);
-    writeBuf.putChar(static_cast<char>(seqAndType));
-    checkByte(seqAndType);
-    if (seqAndType == 0x10) {
-        // Escape it.
-        writeBuf.putChar(static_cast<char>(seqAndType));
+    if (isControlType(msg.type) && msg.data.isEmpty()) {
+        // Nothing to encode; write the precomputed frame.
+        const auto &frame = controlFrame(msg.type, sequenceNo);
+        return write(frame.data(), frame.size, 0);
     }
-    // Write data, escaping 0x10.
-    for (auto b : msg.data) {
-        writeBuf.putChar(b);
-        checkByte(static_cast<quint8>(b));
-        // Any 0x10 byte is repeated for sending.
-        if (b == 0x10) {
-            writeBuf.putChar(b);
-        }
+    if (!encoder.encode(msg.type, sequenceNo,
+                        msg.data.constData(), msg.data.size())) {
+        qWarning() << "Message too large to send:"
+                   << msg.data.size() << "byte(s)";
+        return false;
     }
-    writeBuf.write(dataEnd, sizeof(dataEnd));
-    // Append checksum.
-    writeBuf.putChar(static_cast<char>(checksum >> 8));
-    writeBuf.putChar(static_cast<char>(checksum & 0xff));
+    return write(encoder.data(), encoder.size(), msg.data.size());
+}
 
+bool Link::write(const char *frame, qint64 size, qint64 payloadSize) {
     // Call port.write method. Ensure that this method can't be called again
     // until write finishes or times out.
-    numBytesToWrite = writeBuf.size();
-    port->write(writeBuf.data());
+    busy = true;
+    numBytesToWrite = size;
+    if (port->write(frame, size) < 0) {
+        qWarning() << "Write failed:" << port->errorString();
+        busy = false;
+        numBytesToWrite = 0;
+        return false;
+    }
+    linkMetrics->frameSent(payloadSize, size);
+    if (trace != nullptr) {
+        trace->record(TraceDirection::sent, frame, size);
+    }
 
     return true;
 }
@@ -131,128 +100,70 @@ bool Link::send(const Message &msg) {
 void Link::bytesWritten(qint64 numBytes) {
     if (numBytes > numBytesToWrite) {
         // NOPE.
-        qDebug() << "Overwrite: " << numBytesToWrite << "remaining;"
-                 << numBytes << "allegedly written";
+        traceEvent<TraceLevel::warning>(TraceEventId::writeOverrun,
+                                        numBytesToWrite, numBytes);
     }
     numBytesToWrite -= numBytes;
-    qDebug() << numBytes << "written; " << numBytesToWrite << "remaining.";
+    traceEvent<TraceLevel::debug>(TraceEventId::bytesWritten,
+                                  numBytes, numBytesToWrite);
     if (numBytesToWrite == 0) {
         /// This packet has been completely written.
-        busy.unlock();
+        busy = false;
+        emit frameWritten();
     }
 }
 
 void Link::readyRead() {
     qint64 bytesAvail = port->bytesAvailable();
-    qDebug() << "Bytes available to read:" << bytesAvail;
-    if ((readBuf.size() + bytesAvail) > MAX_MSG_SIZE) {
-        // This cannot happen. Emit error.
-        return;
-    }
-
-    // (Re)set the timeout period.
-    readTimer->start(timeoutValue);
-    readBuf.append(port->readAll());
-    qint64 bytesRead = bytesAvail - port->bytesAvailable();
+    traceEvent<TraceLevel::debug>(TraceEventId::bytesAvailable, bytesAvail);
+    // Read into the existing buffer rather than allocating a new one.
+    readBuf.resize(static_cast<int>(bytesAvail));
+    const auto bytesRead = port->read(readBuf.data(), bytesAvail);
+    readBuf.resize(static_cast<int>(std::max<qint64>(bytesRead, 0)));
     if (bytesRead < bytesAvail) {
         qWarning() << "Unexpected short read";
     }
-    auto msg = parseMessage();
-    if (msg) {
-        // There's a valid message here.
-        readTimer->stop();
-        emit packetReceived(*msg);
+    if (trace != nullptr && !readBuf.isEmpty()) {
+        trace->record(TraceDirection::received,
+                      readBuf.constData(), readBuf.size());
     }
+    parseMessage();
 }
 
-bool Link::validMessageReceived() {
-    return parseMessage(false) == nullptr;
-}
-
-std::unique_ptr<Message> Link::parseMessage(bool popCompleteMessage){
-    // For now, assume that buffer contains only an actual frame.
-    // Check for preamble.
-
-    if (readBuf.size() < MIN_MSG_SIZE
-            || readBuf.at(0) != 0x16
-            || readBuf.at(1) != 0x10
-            || readBuf.at(2) != 0x02) {
-        qDebug() << "Not enough data to be a message:"
-                 << readBuf.size() << "byte(s) received.";
-        return nullptr;
-    }
-    // Check valid channel, type, sequence.
-    // Check for 0x10 03 and CRC afterwards
-    auto postamblePos = readBuf.indexOf(postamble);
-    if (postamblePos < 0 || readBuf.size() < postamblePos + 3) {
-        // postamblePos starts 2-byte postamble and 2-byte CRC;
-        // therefore the last byte of the frame is at postamblePos + 3
-        qDebug() << "Postamble but no CRC";
-        return nullptr;
-    }
-    // Validate CRC
-    quint16 checksum = 0x0000;
-    const auto checkByte = [&](quint8 b){
-        checksum = static_cast<quint16>((checksum << 8)
-                                        ^ crc16table[b ^ (checksum >> 8)]);
-    };
-    bool escaped = false;
-    for (auto i = 3; i < postamblePos; i++) {
-        quint8 b = static_cast<quint8>(readBuf.at(i));
-        if (escaped) {
-            // this is an 0x10; skip it.
-            Q_ASSERT(b == 0x10);
-            escaped = false;
-            continue;
-        }
-        checkByte(b);
-        if (b == 0x10) {
-            // skip the next byte (0x10)
-            escaped = true;
+void Link::parseMessage() {
+    const char *pos = readBuf.constData();
+    qint64 remaining = readBuf.size();
+    const auto crcErrorsBefore = decoder.crcErrors();
+    linkMetrics->bytesRead(remaining);
+    while (remaining > 0) {
+        const auto consumed = decoder.decode(pos, remaining);
+        pos += consumed;
+        remaining -= consumed;
+        if (decoder.hasMessage()) {
+            auto msg = pool.acquire();
+            decoder.takeMessage(msg.message());
+            linkMetrics->frameReceived(msg->data.size());
+            emit packetReceived(msg);
         }
     }
-    quint16 expectedChecksum =
-            static_cast<quint16>((readBuf.at(postamblePos + 2 ) << 8)
-                                 | (readBuf.at(postamblePos + 3)));
-    if (expectedChecksum != checksum) {
-        qWarning() << "Frame received with bad CRC";
-        return nullptr;
+    if (decoder.crcErrors() != crcErrorsBefore) {
+        linkMetrics->addCrcErrors(
+                    static_cast<qint64>(decoder.crcErrors() - crcErrorsBefore));
     }
-    // Emit signal for available data
-    // ACK or NAK.
-    qDebug() << "Frame received with good CRC";
-    auto preamblePos = 0; // for searching the whole buffer later
-    // Preamble is three bytes, then one-byte channel number.
-    auto typePos = preamblePos + 4;
-    auto msg = std::make_unique<Message>();
-    auto typeField = readBuf.at(typePos);
-    msg->type = static_cast<PacketType>(typeField >> 3);
-    msg->sequenceNo = typeField & 0x7;
-    if (typeField == 0x10) {
-        // Start the copy loop below at the right position.
-        typePos++;
-    }
-    // Append data, de-escaping.
-    Q_ASSERT(postamblePos < readBuf.size());
-    for (auto pos = readBuf.cbegin() + typePos + 1;
-         pos < readBuf.cbegin() + postamblePos; pos++) {
-        char curByte = *pos;
-        msg->data.append(curByte);
-        if (curByte == 0x10) {
-            // Advance a second time.
-            pos++;
-        }
-    }
-    if (popCompleteMessage) {
-        readBuf.remove(0, postamblePos + 4);
+    // Keep the buffer's capacity for the next read.
+    readBuf.resize(0);
+    // Only a partially-received frame can time out.
+    if (decoder.isIdle()) {
+        readTimer->stop();
+    } else {
+        readTimer->start(timeoutValue);
     }
-    return msg;
 }
 
 void Link::readTimeout() {
-    qDebug() << "Read timeout reached; flushing buffer";
-    port->readAll();
-    readBuf.clear();
+    traceEvent<TraceLevel::info>(TraceEventId::readTimeout);
+    linkMetrics->readTimeout();
+    decoder.reset();
 }
 
 }
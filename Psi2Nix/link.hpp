@@ -4,84 +4,100 @@
 #pragma once
 
 #include <QByteArray>
-#include <QBuffer>
-#include <QMutex>
 #include <QObject>
 #include <QSerialPort>
-#include <QTimer>
 
 #include <memory>
 
+#include "clock.hpp"
+#include "framedecoder.hpp"
+#include "frameencoder.hpp"
+#include "linkmetrics.hpp"
+#include "message.hpp"
+#include "messagepool.hpp"
+#include "wiretrace.hpp"
+
 class TestLink; // forward-declare test class for friendship
+class BenchLink; // likewise for the benchmarks
 
 namespace CommsLink {
-/// \brief The available packet types.
-enum struct PacketType : uint8_t {
-    acknowledge = 0,
-    disconnect  = 1,
-    linkRequest = 2,
-    data        = 3,
-    unknown     = 255
-};
-
-/// \brief A message to be transmitted over the link.
-///
-/// The CRC will be calculated automatically.
-struct Message {
-    /// \brief The message's type.
-    PacketType type;
-    /// \brief The message's sequence number (valid: 0..7).
-    uint8_t    sequenceNo = 0;
-    /// \brief The data to be sent.
-    ///
-    /// Byte-stuffing will be automatically added to sent messages and
-    /// removed from received messages.
-    QByteArray data;
-
-    Message(PacketType t, const QByteArray &d) :
-        type(t), data(d) {}
-    Message() : type(PacketType::unknown), data{} {}
-};
-
 class Link : public QObject
 {
     Q_OBJECT
 private:
     /// \brief The QIODevice over which this Link communicates.
     QIODevice *port = nullptr;
-    /// \brief A timer restarted when traffic is received; will trigger a
-    /// timeout if more than 250 ms passes without more traffic or a completed
-    /// message.
-    QTimer *readTimer = nullptr;
-    /// \brief An internal buffer into which traffic to be sent is written.
-    QBuffer writeBuf;
-    /// \brief An internal buffer into which received traffic is written.
+    /// \brief A timer restarted when traffic is received mid-frame; will
+    /// trigger a timeout if more than 250 ms passes without more traffic or
+    /// a completed message.
+    ClockTimer *readTimer = nullptr;
+    /// \brief Encoder for sent frames; the frame being transmitted is
+    /// written directly from its buffer, or from controlFrames if it has
+    /// no payload.
+    FrameEncoder encoder;
+    /// \brief An internal buffer into which received traffic is read
+    /// before being passed to the decoder; its capacity is kept between
+    /// reads.
     QByteArray readBuf;
-    /// \brief A QMutex that is locked iff data is being transmitted.
-    QMutex busy;
+    /// \brief Slots that received messages are decoded into.
+    MessagePool pool;
+    /// \brief Decoder for received frames; keeps its state across reads.
+    FrameDecoder decoder;
+    /// \brief true iff data is being transmitted. A Link is only used from
+    /// the thread it lives on, so this needs no locking.
+    bool busy = false;
     /// \brief The number of bytes remaining to write in the current packet.
     qint64 numBytesToWrite = 0;
     /// \brief The sequence number of the next packet to be sent; it's a
     /// uint64 here to eliminate an alignment warning.
     quint64 nextSeq = 0;
-    bool validMessageReceived();
-    /// \brief Read a message from the buffer.
-    /// \param popCompleteMessage Iff true and a valid and complete
-    /// message is in the buffer, clear the buffer afterwards.
-    /// \return The message, or nullptr if none available.
-    std::unique_ptr<Message> parseMessage(bool popCompleteMessage = true);
+    /// \brief Counters used unless setMetrics() supplies others.
+    LinkMetrics ownMetrics;
+    /// \brief The counters being updated.
+    LinkMetrics *linkMetrics = &ownMetrics;
+    /// \brief Where to record traffic, if anywhere.
+    WireTraceWriter *trace = nullptr;
+    /// \brief Decode the contents of the read buffer, emitting
+    /// packetReceived for each complete message.
+    void parseMessage();
+    /// \brief Start writing an encoded frame, which must stay valid until
+    /// it has been written.
+    bool write(const char *frame, qint64 size, qint64 payloadSize);
 public:
     explicit Link(QObject *parent = nullptr);
     ~Link();
     /// \brief Send the provided message to the device.
     /// \return true if we could start the send; false if the link
-    /// was busy.
+    /// was busy or the message is too large for one frame.
     bool send(const Message &msg);
+    /// \brief Send the provided message with the given sequence number,
+    /// e.g. to retransmit it; the link's own sequence is left alone.
+    /// \return As for send(const Message &).
+    bool send(const Message &msg, quint8 sequenceNo);
+    /// \brief Return true iff a frame is being written.
+    bool isBusy() const { return busy; }
     /// \brief Set the port that this Link should use.
     void setPort(QIODevice &port);
+    /// \brief Record everything read and written to \p trace, which must
+    /// outlive this Link or be unset first; nullptr stops recording.
+    void setTrace(WireTraceWriter *aTrace) { trace = aTrace; }
+    /// \brief Return the counters this Link (and its Protocol) update.
+    LinkMetrics &metrics() { return *linkMetrics; }
+    /// \brief Update \p metrics, which must outlive this Link, instead of
+    /// the Link's own counters.
+    void setMetrics(LinkMetrics &metrics) { linkMetrics = &metrics; }
+    /// \brief Time reads by \p clock, which must outlive this Link,
+    /// instead of the system clock; call before any traffic.
+    void setClock(Clock &clock);
 signals:
     /// \brief Emitted when a message has been received with a valid CRC.
-    void packetReceived(Message);
+    ///
+    /// The handle refers to a pooled slot; receivers that hold on to it
+    /// keep that slot out of use.
+    void packetReceived(CommsLink::MessageRef msg);
+    /// \brief Emitted when the last byte of a frame has been written, at
+    /// which point the link is ready to send another.
+    void frameWritten();
 
 public slots:
     /// \brief Notify this object that a scheduled write has been completed.
@@ -92,5 +108,6 @@ public slots:
     void readTimeout();
 
 friend class ::TestLink;
+friend class ::BenchLink;
 };
 }
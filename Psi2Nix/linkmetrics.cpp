@@ -0,0 +1,82 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "linkmetrics.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace CommsLink {
+
+quint64 LatencySnapshot::count() const {
+    quint64 total = 0;
+    for (auto n : counts) {
+        total += n;
+    }
+    return total;
+}
+
+qint64 LatencySnapshot::mean() const {
+    const auto n = count();
+    return n == 0 ? 0 : static_cast<qint64>(totalMicros / n);
+}
+
+qint64 LatencySnapshot::percentile(double p) const {
+    const auto n = count();
+    if (n == 0) {
+        return 0;
+    }
+    const auto rank = std::max<quint64>(
+                1, static_cast<quint64>(std::ceil(p / 100 * n)));
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKETS; i++) {
+        seen += counts[i];
+        if (seen >= rank) {
+            return qint64{1} << i;
+        }
+    }
+    return qint64{1} << (BUCKETS - 1);
+}
+
+void LatencyHistogram::record(qint64 micros) {
+    const auto value = static_cast<quint64>(std::max<qint64>(micros, 0));
+    // The bucket is the bit width of the sample.
+    int bucket = 0;
+    for (auto v = value; v != 0 && bucket < LatencySnapshot::BUCKETS - 1;
+         v >>= 1) {
+        bucket++;
+    }
+    auto &count = counts[static_cast<size_t>(bucket)];
+    count.store(count.load(std::memory_order_relaxed) + 1,
+                std::memory_order_relaxed);
+    totalMicros.store(totalMicros.load(std::memory_order_relaxed) + value,
+                      std::memory_order_relaxed);
+}
+
+LatencySnapshot LatencyHistogram::snapshot() const {
+    LatencySnapshot snapshot;
+    for (size_t i = 0; i < counts.size(); i++) {
+        snapshot.counts[i] = counts[i].load(std::memory_order_relaxed);
+    }
+    snapshot.totalMicros = totalMicros.load(std::memory_order_relaxed);
+    return snapshot;
+}
+
+LinkMetricsSnapshot LinkMetrics::snapshot() const {
+    LinkMetricsSnapshot snapshot;
+    snapshot.framesSent = framesSent.load(std::memory_order_relaxed);
+    snapshot.framesReceived = framesReceived.load(std::memory_order_relaxed);
+    snapshot.payloadBytesSent =
+            payloadBytesSent.load(std::memory_order_relaxed);
+    snapshot.wireBytesSent = wireBytesSent.load(std::memory_order_relaxed);
+    snapshot.payloadBytesReceived =
+            payloadBytesReceived.load(std::memory_order_relaxed);
+    snapshot.wireBytesReceived =
+            wireBytesReceived.load(std::memory_order_relaxed);
+    snapshot.crcErrors = crcErrors.load(std::memory_order_relaxed);
+    snapshot.readTimeouts = readTimeouts.load(std::memory_order_relaxed);
+    snapshot.busyRejections = busyRejections.load(std::memory_order_relaxed);
+    snapshot.ackLatency = ackLatency.snapshot();
+    return snapshot;
+}
+}
@@ -0,0 +1,109 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QtGlobal>
+
+#include <array>
+#include <atomic>
+
+namespace CommsLink {
+
+/// \brief A snapshot of a LatencyHistogram.
+struct LatencySnapshot {
+    static constexpr int BUCKETS = 24;
+    /// \brief counts[i] is the number of samples of less than 2^i µs (and
+    /// at least 2^(i-1) µs); the last bucket also holds everything larger.
+    std::array<quint64, BUCKETS> counts{};
+    quint64 totalMicros = 0;
+
+    quint64 count() const;
+    /// \brief Return the mean, in microseconds, or 0 if there are no
+    /// samples.
+    qint64 mean() const;
+    /// \brief Return an upper bound, in microseconds, on the given
+    /// percentile (0..100), or 0 if there are no samples.
+    qint64 percentile(double p) const;
+};
+
+/// \brief A histogram of latencies in power-of-two buckets.
+///
+/// Only one thread may record samples, but any may take a snapshot.
+class LatencyHistogram
+{
+public:
+    /// \brief Record a sample; negative samples count as zero.
+    void record(qint64 micros);
+    LatencySnapshot snapshot() const;
+private:
+    std::array<std::atomic<quint64>, LatencySnapshot::BUCKETS> counts{};
+    std::atomic<quint64> totalMicros{0};
+};
+
+/// \brief A snapshot of a link's counters.
+struct LinkMetricsSnapshot {
+    quint64 framesSent = 0;
+    quint64 framesReceived = 0;
+    /// \brief Message bytes sent, before framing and escaping.
+    quint64 payloadBytesSent = 0;
+    /// \brief Bytes written to the port.
+    quint64 wireBytesSent = 0;
+    /// \brief Message bytes received, after unescaping.
+    quint64 payloadBytesReceived = 0;
+    /// \brief Bytes read from the port.
+    quint64 wireBytesReceived = 0;
+    quint64 crcErrors = 0;
+    /// \brief Partial frames discarded because the rest didn't arrive.
+    quint64 readTimeouts = 0;
+    /// \brief Sends refused because a frame was already being written.
+    quint64 busyRejections = 0;
+    /// \brief Time from writing a data frame to its acknowledgement.
+    LatencySnapshot ackLatency;
+};
+
+/// \brief Counters kept by a Link and its Protocol as they run.
+///
+/// Every counter is written only from the link's thread, so updates are
+/// plain relaxed loads and stores with no locked instructions; reading
+/// them, from any thread, is left to whoever wants a snapshot.
+class LinkMetrics
+{
+public:
+    void frameSent(qint64 payloadBytes, qint64 wireBytes) {
+        bump(framesSent);
+        bump(payloadBytesSent, payloadBytes);
+        bump(wireBytesSent, wireBytes);
+    }
+    void frameReceived(qint64 payloadBytes) {
+        bump(framesReceived);
+        bump(payloadBytesReceived, payloadBytes);
+    }
+    void bytesRead(qint64 wireBytes) { bump(wireBytesReceived, wireBytes); }
+    void addCrcErrors(qint64 count) { bump(crcErrors, count); }
+    void readTimeout() { bump(readTimeouts); }
+    void busyRejection() { bump(busyRejections); }
+    void acknowledged(qint64 micros) { ackLatency.record(micros); }
+
+    LinkMetricsSnapshot snapshot() const;
+
+private:
+    /// \brief Add to a counter that only this thread writes.
+    static void bump(std::atomic<quint64> &counter, qint64 amount = 1) {
+        counter.store(counter.load(std::memory_order_relaxed)
+                      + static_cast<quint64>(amount),
+                      std::memory_order_relaxed);
+    }
+
+    std::atomic<quint64> framesSent{0};
+    std::atomic<quint64> framesReceived{0};
+    std::atomic<quint64> payloadBytesSent{0};
+    std::atomic<quint64> wireBytesSent{0};
+    std::atomic<quint64> payloadBytesReceived{0};
+    std::atomic<quint64> wireBytesReceived{0};
+    std::atomic<quint64> crcErrors{0};
+    std::atomic<quint64> readTimeouts{0};
+    std::atomic<quint64> busyRejections{0};
+    LatencyHistogram ackLatency;
+};
+}
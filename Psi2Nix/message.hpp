@@ -0,0 +1,43 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QByteArray>
+
+namespace CommsLink {
+
+/// \brief Minimum size of a complete frame on the wire.
+constexpr int MIN_MSG_SIZE = 0x009;
+/// \brief Maximum size of a complete frame on the wire, including
+/// byte-stuffing.
+constexpr int MAX_MSG_SIZE = 0x200;
+
+/// \brief The available packet types.
+enum struct PacketType : uint8_t {
+    acknowledge = 0,
+    disconnect  = 1,
+    linkRequest = 2,
+    data        = 3,
+    unknown     = 255
+};
+
+/// \brief A message to be transmitted over the link.
+///
+/// The CRC will be calculated automatically.
+struct Message {
+    /// \brief The message's type.
+    PacketType type;
+    /// \brief The message's sequence number (valid: 0..7).
+    uint8_t    sequenceNo = 0;
+    /// \brief The data to be sent.
+    ///
+    /// Byte-stuffing will be automatically added to sent messages and
+    /// removed from received messages.
+    QByteArray data;
+
+    Message(PacketType t, const QByteArray &d) :
+        type(t), data(d) {}
+    Message() : type(PacketType::unknown), data{} {}
+};
+}
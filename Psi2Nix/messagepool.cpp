@@ -0,0 +1,28 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "messagepool.hpp"
+
+namespace CommsLink {
+
+MessagePool::MessagePool()
+{
+    for (auto &slot : slots) {
+        slot = new PooledMessage;
+        slot->message.data.reserve(MAX_MSG_SIZE);
+    }
+}
+
+MessageRef MessagePool::acquire() {
+    for (int i = 0; i < SIZE; i++) {
+        auto &slot = slots[static_cast<size_t>((next + i) % SIZE)];
+        // Only the pool holds it, and only this thread hands it out.
+        if (slot->ref.loadAcquire() == 1) {
+            next = (next + i + 1) % SIZE;
+            return MessageRef(slot.data());
+        }
+    }
+    numOverflows++;
+    return MessageRef(new PooledMessage);
+}
+}
@@ -0,0 +1,67 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QExplicitlySharedDataPointer>
+#include <QMetaType>
+#include <QSharedData>
+
+#include <array>
+
+#include "message.hpp"
+
+namespace CommsLink {
+
+class Link;
+class MessagePool;
+
+/// \brief A received message in a pooled slot.
+struct PooledMessage : public QSharedData {
+    Message message;
+};
+
+/// \brief A cheap, shareable handle to a received message.
+///
+/// Copying a handle only bumps a reference count. The slot goes back to
+/// its pool once every handle to it has gone, so keep a handle only as
+/// long as the message is needed; copy the message out to keep it longer.
+class MessageRef
+{
+public:
+    MessageRef() = default;
+    const Message &operator*() const { return d->message; }
+    const Message *operator->() const { return &d->message; }
+    explicit operator bool() const { return d.data() != nullptr; }
+private:
+    friend class Link;
+    friend class MessagePool;
+    explicit MessageRef(PooledMessage *slot) : d(slot) {}
+    Message &message() { return d->message; }
+    QExplicitlySharedDataPointer<PooledMessage> d;
+};
+
+/// \brief A fixed set of message slots that received frames are decoded
+/// into, so that receiving doesn't allocate.
+///
+/// Only the owning thread may acquire slots; handles may be released on
+/// any thread.
+class MessagePool
+{
+public:
+    static constexpr int SIZE = 8;
+    MessagePool();
+    /// \brief Return a slot that nobody else holds a handle to; if every
+    /// slot is in use, return a new one from the heap instead.
+    MessageRef acquire();
+    /// \brief Return the number of times the pool ran dry.
+    quint64 overflows() const { return numOverflows; }
+private:
+    std::array<QExplicitlySharedDataPointer<PooledMessage>, SIZE> slots;
+    /// \brief Where to start looking for a free slot.
+    int next = 0;
+    quint64 numOverflows = 0;
+};
+}
+
+Q_DECLARE_METATYPE(CommsLink::MessageRef)
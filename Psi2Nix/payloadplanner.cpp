@@ -0,0 +1,78 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "payloadplanner.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace CommsLink {
+
+namespace {
+// The weight each frame's history keeps at the next; about the last 64
+// frames count.
+constexpr double DECAY = 63.0 / 64.0;
+// Clean wire bytes assumed on top of those seen, so that one unlucky frame
+// doesn't shrink the budget by itself.
+constexpr double PRIOR_BYTES = 8 * 1024;
+// Wire bytes each transmission costs besides its payload: the frame's
+// framing and the acknowledgement's.
+constexpr double OVERHEAD = 2 * MIN_MSG_SIZE;
+}
+
+void PayloadPlanner::frameAcknowledged(qint64 wireBytes,
+                                       int retransmissions) {
+    const auto attempts = 1 + retransmissions;
+    failures = failures * DECAY + retransmissions;
+    bytes = bytes * DECAY + attempts * (wireBytes + OVERHEAD);
+    const auto rate = errorRate();
+    if (rate <= 0) {
+        currentBudget = MAX_BUDGET;
+        return;
+    }
+    // A transmission of n wire bytes gets through with probability
+    // exp(-rate * n); the payload length L that minimises the wire bytes
+    // sent per byte delivered, (L + OVERHEAD) / (L exp(-rate (L +
+    // OVERHEAD))), solves L^2 + OVERHEAD L = OVERHEAD / rate.
+    const auto best = (std::sqrt(OVERHEAD * OVERHEAD + 4 * OVERHEAD / rate)
+                       - OVERHEAD) / 2;
+    currentBudget = best >= MAX_BUDGET
+            ? MAX_BUDGET : std::max(static_cast<qint64>(best), MIN_BUDGET);
+}
+
+double PayloadPlanner::errorRate() const {
+    return failures / (bytes + PRIOR_BYTES);
+}
+
+qint64 PayloadPlanner::chunkLength(const char *data, qint64 available,
+                                   qint64 budget, qint64 *wireBytes) {
+    // Take runs up to each 0x10, which costs two bytes on the wire.
+    const auto initialBudget = budget;
+    qint64 length = 0;
+    while (length < available && budget > 0) {
+        const auto searchLength = std::min(available - length, budget);
+        const auto dle = static_cast<const char *>(
+                    std::memchr(data + length, 0x10,
+                                static_cast<size_t>(searchLength)));
+        if (dle == nullptr) {
+            length += searchLength;
+            budget -= searchLength;
+            break;
+        }
+        const auto run = dle - (data + length);
+        if (run + 2 > budget) {
+            // The 0x10 and its escape don't both fit.
+            length += run;
+            budget -= run;
+            break;
+        }
+        length += run + 1;
+        budget -= run + 2;
+    }
+    if (wireBytes != nullptr) {
+        *wireBytes = initialBudget - budget;
+    }
+    return length;
+}
+}
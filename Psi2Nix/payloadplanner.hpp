@@ -0,0 +1,63 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QtGlobal>
+
+#include "message.hpp"
+
+namespace CommsLink {
+
+/// \brief Decides how much of a file goes in each data frame.
+///
+/// Every 0x10 costs two bytes on the wire, so each frame is filled as
+/// close to a budget of wire bytes as its escaping allows rather than with
+/// a fixed number of bytes. On a clean line the budget is the most a frame
+/// can carry, for the fewest frames. The longer a frame, though, the more
+/// likely it is to be corrupted and sent again, so as retransmissions show
+/// the line to be noisy the budget shrinks to the length that costs least
+/// on the wire per byte delivered, and it grows back as the line clears.
+class PayloadPlanner
+{
+public:
+    /// \brief Wire bytes available for data in a frame, after the framing
+    /// and the operation byte.
+    static constexpr qint64 MAX_BUDGET = MAX_MSG_SIZE - MIN_MSG_SIZE - 1;
+    /// \brief The smallest budget used, however noisy the line.
+    static constexpr qint64 MIN_BUDGET = 32;
+
+    /// \brief Return the number of wire bytes the next frame's data may
+    /// take.
+    qint64 budget() const { return currentBudget; }
+    /// \brief Return the number of bytes of \p data to put in the next
+    /// frame.
+    /// \param[out] wireBytes The number of wire bytes they take.
+    qint64 plan(const char *data, qint64 available, qint64 &wireBytes) const {
+        return chunkLength(data, available, currentBudget, &wireBytes);
+    }
+    /// \brief Note how a frame fared, and revise the budget.
+    /// \param wireBytes The wire bytes taken by the frame's payload.
+    /// \param retransmissions The number of times it was sent again
+    /// before being acknowledged.
+    void frameAcknowledged(qint64 wireBytes, int retransmissions);
+    /// \brief Return the estimated number of corrupted wire bytes per byte
+    /// sent.
+    double errorRate() const;
+    /// \brief Return the number of payload bytes that fit in one frame,
+    /// taking escaping into account.
+    /// \param data The data to be sent.
+    /// \param available The number of bytes available at \p data.
+    /// \param budget The number of wire bytes available.
+    /// \param[out] wireBytes If given, the number of wire bytes they take.
+    static qint64 chunkLength(const char *data, qint64 available,
+                              qint64 budget, qint64 *wireBytes = nullptr);
+
+private:
+    /// \brief Failed transmissions, decaying with each frame.
+    double failures = 0;
+    /// \brief Wire bytes transmitted, decaying with each frame.
+    double bytes = 0;
+    qint64 currentBudget = MAX_BUDGET;
+};
+}
@@ -0,0 +1,82 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "portmonitor.hpp"
+
+#include <QSerialPortInfo>
+#include <QtConcurrent>
+#include <QtDebug>
+
+namespace CommsLink {
+
+namespace {
+QMap<QString, QString> availablePorts() {
+    QMap<QString, QString> ports;
+    for (const auto &port : QSerialPortInfo::availablePorts()) {
+        ports.insert(port.portName(), port.description());
+    }
+    return ports;
+}
+}
+
+PortMonitor::PortMonitor(HotplugSource *aSource, QObject *parent) :
+    QObject(parent), source(aSource), scanner(availablePorts)
+{
+#ifdef Q_OS_LINUX
+    if (source == nullptr) {
+        source = new UeventHotplugSource;
+    }
+#endif
+    if (source != nullptr) {
+        source->setParent(this);
+        connect(source, &HotplugSource::portAdded, this, &PortMonitor::add);
+        connect(source, &HotplugSource::portRemoved,
+                this, &PortMonitor::remove);
+    }
+    connect(&watcher, &QFutureWatcher<QMap<QString, QString>>::finished,
+            this, &PortMonitor::scanned);
+}
+
+void PortMonitor::start() {
+    if (scanning || enumerated_) {
+        return;
+    }
+    // Watch first, so that nothing plugged in during the scan is missed.
+    if (source != nullptr && !source->start()) {
+        qWarning() << "Ports plugged in later won't be noticed";
+    }
+    scanning = true;
+    watcher.setFuture(QtConcurrent::run(scanner));
+}
+
+void PortMonitor::scanned() {
+    scanning = false;
+    const auto ports = watcher.result();
+    for (auto port = ports.cbegin(); port != ports.cend(); ++port) {
+        if (!removedDuringScan.contains(port.key())) {
+            add(port.key(), port.value());
+        }
+    }
+    removedDuringScan.clear();
+    enumerated_ = true;
+    emit enumerated();
+}
+
+void PortMonitor::add(const QString &name, const QString &description) {
+    removedDuringScan.remove(name);
+    if (known.contains(name)) {
+        return;
+    }
+    known.insert(name, description);
+    emit portAdded(name, description);
+}
+
+void PortMonitor::remove(const QString &name) {
+    if (scanning) {
+        removedDuringScan.insert(name);
+    }
+    if (known.remove(name) > 0) {
+        emit portRemoved(name);
+    }
+}
+}
@@ -0,0 +1,71 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QFutureWatcher>
+#include <QMap>
+#include <QObject>
+#include <QSet>
+#include <QStringList>
+
+#include <functional>
+
+#include "hotplugsource.hpp"
+
+namespace CommsLink {
+
+/// \brief Keeps track of the serial ports present, without ever making its
+/// thread wait for them to be scanned.
+///
+/// The ports already present are found on the global thread pool, since
+/// that can take seconds on some hosts; those coming and going afterwards
+/// are reported by a HotplugSource. Each port is reported once, as soon
+/// as it's known, whichever finds it first.
+class PortMonitor : public QObject
+{
+    Q_OBJECT
+public:
+    /// \brief Returns the descriptions of the ports present, by name.
+    using Scanner = std::function<QMap<QString, QString>()>;
+
+    /// \param source Reports ports coming and going; the monitor takes it
+    /// over. If null, the platform's own is used where there is one.
+    explicit PortMonitor(HotplugSource *source = nullptr,
+                         QObject *parent = nullptr);
+    /// \brief Start watching for ports, and scan for those present.
+    void start();
+    /// \brief Find the ports present with \p scanner rather than by asking
+    /// QSerialPortInfo; must be called before start().
+    void setScanner(Scanner aScanner) { scanner = std::move(aScanner); }
+    /// \brief Return the names of the ports known to be present.
+    QStringList ports() const { return known.keys(); }
+    /// \brief Return true iff the scan for the ports present has finished.
+    bool isEnumerated() const { return enumerated_; }
+
+signals:
+    /// \brief Emitted when a port is found.
+    void portAdded(const QString &name, const QString &description);
+    /// \brief Emitted when a port goes away.
+    void portRemoved(const QString &name);
+    /// \brief Emitted once the ports present have all been reported.
+    void enumerated();
+
+private:
+    /// \brief Called when the scan is done.
+    void scanned();
+    void add(const QString &name, const QString &description);
+    void remove(const QString &name);
+
+    HotplugSource *source;
+    Scanner scanner;
+    QFutureWatcher<QMap<QString, QString>> watcher;
+    /// \brief Descriptions of the ports present, by name.
+    QMap<QString, QString> known;
+    /// \brief Ports that went away while the scan was running, which it
+    /// may still have seen.
+    QSet<QString> removedDuringScan;
+    bool scanning = false;
+    bool enumerated_ = false;
+};
+}
@@ -4,41 +4,342 @@
 #include "protocol.hpp"
 
 #include <QMutexLocker>
+#include <QThread>
 #include <QtDebug>
 
+#include <algorithm>
+
 namespace CommsLink {
 
 const std::chrono::milliseconds connRequestInterval{1000};
+// Connection requests back off to no less often than this.
+const std::chrono::milliseconds maxConnRequestInterval{16000};
+// The number of times a data frame is retransmitted before giving up.
+constexpr int MAX_RETRIES = 5;
 
 const Message connRequest{ /*!< Connection request packet */
     PacketType::linkRequest,
     QByteArray{}
 };
 
-Protocol::Protocol(QObject *parent) : QObject(parent)
+const Message ackMessage{ /*!< Acknowledgement packet */
+    PacketType::acknowledge,
+    QByteArray{}
+};
+
+Protocol::Protocol(QObject *parent) : QObject(parent),
+    requestInterval(connRequestInterval)
 {
-    connect(&requestTimer, &QTimer::timeout,
+    createTimers();
+}
+
+Protocol::~Protocol() {
+    QQueue<PendingMessage> discarded;
+    {
+        QMutexLocker lock(&sendQueueMutex);
+        discarded.swap(sendQueue);
+    }
+    for (const auto &pending : discarded) {
+        if (pending.done) {
+            pending.done(false);
+        }
+    }
+}
+
+void Protocol::setClock(Clock &aClock) {
+    Q_ASSERT(myLink == nullptr);
+    clock = &aClock;
+    delete requestTimer;
+    delete retransmitTimer;
+    createTimers();
+}
+
+void Protocol::createTimers() {
+    // Requests are driven by events; the timer only paces the retries.
+    requestTimer = clock->createTimer(this);
+    connect(requestTimer, &ClockTimer::timeout,
             this, &Protocol::timeForRequest);
-    requestTimer.start(connRequestInterval);
+    retransmitTimer = clock->createTimer(this);
+    connect(retransmitTimer, &ClockTimer::timeout,
+            this, &Protocol::retransmitTimeout);
 }
 
 void Protocol::setLink(Link &aLink) {
     myLink = &aLink;
+    connect(myLink, &Link::frameWritten,
+            this, &Protocol::frameWritten);
+    connect(myLink, &Link::packetReceived,
+            this, &Protocol::packetReceived);
+    closing = false;
+    dispatch();
+    // Let the caller queue its own messages first; if it does, the first
+    // of them to be acknowledged will connect us without a request.
+    requestInterval = connRequestInterval;
+    requestTimer->start(std::chrono::milliseconds{0});
 }
 
 bool Protocol::isConnected() {
     return connected;
 }
 
-void Protocol::timeForRequest() {
+bool Protocol::enqueue(const Message &msg, SendCallback done) {
+    bool nowCongested = false;
+    {
+        QMutexLocker lock(&sendQueueMutex);
+        if (sendQueue.size() >= queueCapacity) {
+            return false;
+        }
+        sendQueue.enqueue({msg, std::move(done)});
+        if (!congested && sendQueue.size() >= highWatermark) {
+            congested = nowCongested = true;
+        }
+    }
+    if (nowCongested) {
+        emit backpressure(true);
+    }
+    if (QThread::currentThread() == thread()) {
+        dispatch();
+    } else {
+        QMetaObject::invokeMethod(this, &Protocol::dispatch,
+                                  Qt::QueuedConnection);
+    }
+    return true;
+}
+
+void Protocol::disconnectDevice(SendCallback done) {
+    closing = true;
+    requestTimer->stop();
+    requestPending = false;
+    const bool queued = enqueue(Message{PacketType::disconnect, QByteArray{}},
+                                [this, done](bool sent) {
+        if (sent) {
+            setConnected(false);
+        }
+        if (done) {
+            done(sent);
+        }
+    });
+    if (!queued && done) {
+        done(false);
+    }
+}
+
+int Protocol::queueLength() {
+    QMutexLocker lock(&sendQueueMutex);
+    return sendQueue.size();
+}
+
+void Protocol::setQueueLimits(int capacity, int low, int high) {
+    Q_ASSERT(low < high && high <= capacity);
     QMutexLocker lock(&sendQueueMutex);
-    if (!connected && (myLink != nullptr)
-            && sendQueue.isEmpty()) {
-        bool success = myLink->send(connRequest);
-        if (!success) {
-            qDebug() << "Tried to send conn request but link busy";
+    queueCapacity = capacity;
+    lowWatermark = low;
+    highWatermark = high;
+}
+
+void Protocol::dispatch() {
+    if (myLink == nullptr || sendState != SendState::idle) {
+        return;
+    }
+    Message next;
+    {
+        QMutexLocker lock(&sendQueueMutex);
+        if (sendQueue.isEmpty()) {
+            return;
         }
+        next = sendQueue.head().msg;
+    }
+    if (next.type == PacketType::data && !headSeqAssigned) {
+        headSeq = nextSeq;
+        headSeqAssigned = true;
+        nextSeq = (nextSeq + 1) % 8;
+    }
+    const auto seq = next.type == PacketType::data
+            ? headSeq : next.sequenceNo;
+    if (myLink->send(next, seq)) {
+        sendState = SendState::writing;
+    } else if (!myLink->isBusy()) {
+        qWarning() << "Discarding message that can't be sent";
+        completeHead(false);
+    }
+    // Otherwise someone else's frame is being written; we'll try again
+    // once it has been.
+}
+
+void Protocol::frameWritten() {
+    // An acknowledgement held back by the frame just written goes next,
+    // so that the device isn't kept waiting behind our own data.
+    if (pendingAck >= 0) {
+        const auto seq = static_cast<quint8>(pendingAck);
+        pendingAck = -1;
+        acknowledge(seq);
+    }
+    if (sendState != SendState::writing) {
+        dispatch();
+        return;
+    }
+    bool needsAck;
+    {
+        QMutexLocker lock(&sendQueueMutex);
+        needsAck = sendQueue.head().msg.type == PacketType::data;
+    }
+    if (!needsAck) {
+        completeHead(true);
+        return;
+    }
+    if (ackedWhileWriting) {
+        // The device answered before the write was reported complete; the
+        // time taken says nothing about the round trip, so isn't sampled.
+        completeHead(true);
+        return;
+    }
+    sendState = SendState::awaitingAck;
+    // Karn's algorithm: only time frames that haven't been retransmitted.
+    if (retries == 0) {
+        writtenAt = clock->now();
+    }
+    retransmitTimer->start(rtt.timeout());
+}
+
+void Protocol::packetReceived(MessageRef msg) {
+    switch (msg->type) {
+    case PacketType::acknowledge:
+        setConnected(true);
+        if (sendState == SendState::awaitingAck
+                && msg->sequenceNo == headSeq) {
+            retransmitTimer->stop();
+            if (retries == 0) {
+                const auto micros = std::chrono::duration_cast<
+                        std::chrono::microseconds>(clock->now() - writtenAt)
+                        .count();
+                rtt.addSample(std::chrono::microseconds{micros});
+                myLink->metrics().acknowledged(micros);
+            }
+            completeHead(true);
+        } else if (sendState == SendState::writing && headSeqAssigned
+                   && msg->sequenceNo == headSeq) {
+            // Finished with once the write is.
+            ackedWhileWriting = true;
+        } else {
+            qDebug() << "Ignoring acknowledgement of" << msg->sequenceNo;
+        }
+        break;
+    case PacketType::linkRequest:
+        // The device wants to talk; acknowledge it ahead of anything
+        // queued.
+        acknowledge(0);
+        lastReceivedSeq = -1;
+        closing = false;
+        setConnected(true);
+        break;
+    case PacketType::disconnect:
+        lastReceivedSeq = -1;
+        setConnected(false);
+        break;
+    case PacketType::data:
+        setConnected(true);
+        acknowledge(msg->sequenceNo);
+        // A repeat means our acknowledgement was lost; it's been sent
+        // again, and that's all.
+        if (msg->sequenceNo != lastReceivedSeq) {
+            lastReceivedSeq = msg->sequenceNo;
+            emit dataReceived(msg);
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+void Protocol::retransmitTimeout() {
+    if (sendState != SendState::awaitingAck) {
+        return;
+    }
+    if (++retries > MAX_RETRIES) {
+        qWarning() << "No acknowledgement after" << MAX_RETRIES
+                   << "retransmissions; giving up";
+        setConnected(false);
+        completeHead(false);
+        return;
+    }
+    qDebug() << "Retransmitting" << headSeq << "; attempt" << retries;
+    retransmitted++;
+    rtt.backoff();
+    sendState = SendState::idle;
+    dispatch();
+}
+
+void Protocol::completeHead(bool sent) {
+    PendingMessage head;
+    bool drained = false;
+    {
+        QMutexLocker lock(&sendQueueMutex);
+        head = sendQueue.dequeue();
+        if (congested && sendQueue.size() <= lowWatermark) {
+            congested = false;
+            drained = true;
+        }
+    }
+    sendState = SendState::idle;
+    headSeqAssigned = false;
+    ackedWhileWriting = false;
+    retries = 0;
+    // Start on the next frame before anything else, so that the line
+    // doesn't sit idle.
+    dispatch();
+    if (requestPending && queueLength() == 0) {
+        timeForRequest();
+    }
+    if (drained) {
+        emit backpressure(false);
+    }
+    if (head.done) {
+        head.done(sent);
+    }
+}
+
+void Protocol::setConnected(bool isConnected) {
+    if (connected == isConnected) {
+        return;
+    }
+    qDebug() << (isConnected ? "Device connected" : "Device disconnected");
+    connected = isConnected;
+    requestInterval = connRequestInterval;
+    requestPending = false;
+    if (connected) {
+        requestTimer->stop();
+    } else if (!closing) {
+        // Ask again straight away; the device may just have restarted.
+        requestTimer->start(std::chrono::milliseconds{0});
+    }
+    emit connectionChanged(connected);
+}
+
+void Protocol::acknowledge(quint8 seq) {
+    if (myLink == nullptr) {
+        return;
+    }
+    if (!myLink->send(ackMessage, seq)) {
+        // Only a newer frame can need acknowledging after this one.
+        pendingAck = seq;
+    }
+}
+
+void Protocol::timeForRequest() {
+    requestPending = false;
+    if (connected || closing || myLink == nullptr) {
+        return;
+    }
+    if (queueLength() > 0) {
+        // Whatever's queued may connect us anyway; if not, ask once it's
+        // gone.
+        requestPending = true;
+        return;
     }
+    enqueue(connRequest);
+    // Back off while nobody answers.
+    requestTimer->start(requestInterval);
+    requestInterval = std::min(requestInterval * 2, maxConnRequestInterval);
 }
 
 }
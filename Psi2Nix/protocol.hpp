@@ -5,9 +5,13 @@
 
 #include <QObject>
 #include <QMutex>
-#include <QTimer>
+#include <QQueue>
 
+#include <functional>
+
+#include "clock.hpp"
 #include "link.hpp"
+#include "rttestimator.hpp"
 
 namespace CommsLink {
 
@@ -20,33 +24,190 @@ class Protocol : public QObject
 {
     Q_OBJECT
 public:
+    /*!
+     \brief Callback reporting the outcome of an enqueued message.
+
+     \param sent true iff the message was sent; false if it was discarded.
+    */
+    using SendCallback = std::function<void(bool sent)>;
+
     explicit Protocol(QObject *parent = nullptr);
+    ~Protocol();
     /*!
      \brief Set this protocol's corresponding link object.
 
+     A connection request is sent as soon as control returns to the event
+     loop, unless there's something else to send first; any acknowledged
+     frame makes the connection.
+
      \param[in] aLink The link to use.
     */
     void setLink(Link &aLink);
+    /*!
+     \brief Time connection requests and retransmissions by \p clock,
+     which must outlive this Protocol, instead of the system clock.
+
+     Call before setLink().
+    */
+    void setClock(Clock &aClock);
     /*!
      \brief Return whether this Protocol is connected to a remote endpoint.
 
      \return true iff connected.
     */
     bool isConnected();
+    /*!
+     \brief Queue a message to be sent as soon as the link is free.
+
+     May be called from any thread. Each message is written as soon as the
+     one before it has completed, without waiting for a timer. Data messages
+     are given the next sequence number and complete when the device
+     acknowledges them, being retransmitted until it does; other messages
+     are sent as given and complete once written.
+
+     \param[in] msg The message to send.
+     \param[in] done Called on this object's thread once the message has
+     been sent (and acknowledged, for data) or discarded.
+     \return false if the queue is full, in which case \p done is not
+     called.
+    */
+    bool enqueue(const Message &msg, SendCallback done = {});
+    /*!
+     \brief Disconnect from the device once everything queued has been
+     sent.
+
+     No more connection requests are sent until the device asks to
+     connect again or setLink() is called.
+
+     \param[in] done Called once the disconnection has been written, or
+     with false if it couldn't be queued or was discarded.
+    */
+    void disconnectDevice(SendCallback done = {});
+    /*!
+     \brief Return the number of messages waiting to be sent, including
+     the one being written.
+    */
+    int queueLength();
+    /*!
+     \brief Set the send queue's capacity and watermarks.
+
+     \param[in] capacity The most messages that may be queued.
+     \param[in] low The length at or below which a full queue is considered
+     drained.
+     \param[in] high The length at which the queue is considered full.
+    */
+    void setQueueLimits(int capacity, int low, int high);
+    /*!
+     \brief Return the estimator used for retransmission timeouts.
+    */
+    const RttEstimator &rttEstimator() const { return rtt; }
+    /*!
+     \brief Return the number of data frames retransmitted so far.
+
+     Messages complete in order, so the count's increase between one
+     completing and the next is the number of times the latter was sent
+     again.
+    */
+    quint64 retransmissions() const { return retransmitted; }
 signals:
+    /*!
+     \brief Emitted with true when the send queue reaches its high
+     watermark, and with false when it drains back to its low watermark.
+    */
+    void backpressure(bool congested);
+    /*!
+     \brief Emitted when the device connects or disconnects.
+    */
+    void connectionChanged(bool connected);
+    /*!
+     \brief Emitted for each data frame from the device, once only however
+     often it's retransmitted.
+
+     The frame has already been acknowledged, without waiting for anything
+     connected to this signal. The handle refers to a pooled slot, so
+     receivers should copy what they need rather than keep it.
+    */
+    void dataReceived(CommsLink::MessageRef msg);
 
 private slots:
     /*!
-     \brief Slot that receives a once-per-second timer
-     to emit a connection request.
+     \brief Send a connection request if we're not connected, or as soon
+     as the queue is empty if it isn't; the interval before the next
+     doubles for each unanswered request.
     */
     void timeForRequest();
+    /*! \brief Send the next queued message if the link is free. */
+    void dispatch();
+    /*! \brief Start waiting for an acknowledgement of the frame just
+        written, or complete it if it doesn't need one. */
+    void frameWritten();
+    /*! \brief Handle a message received over the link. */
+    void packetReceived(CommsLink::MessageRef msg);
+    /*! \brief Retransmit the frame awaiting acknowledgement. */
+    void retransmitTimeout();
 
 private:
-    /*! sends conn request iff disconnected */
-    QTimer requestTimer;
+    /*! \brief A message waiting in the send queue. */
+    struct PendingMessage {
+        Message msg;
+        SendCallback done;
+    };
+    /*! \brief What's happening to the message at the head of sendQueue. */
+    enum struct SendState {
+        idle,       //!< Not yet sent
+        writing,    //!< Being written
+        awaitingAck //!< Written; waiting for an acknowledgement
+    };
+    /*! \brief Remove the message at the head of the queue, report its
+        outcome and start on the next. */
+    void completeHead(bool sent);
+    /*! \brief Note whether the device is answering us. */
+    void setConnected(bool isConnected);
+    /*! \brief Acknowledge a data frame or link request from the device,
+        ahead of anything queued, as soon as the link is free. */
+    void acknowledge(quint8 seq);
+
+    /*! \brief Create the timers from clock. */
+    void createTimers();
+
+    Clock *clock = &Clock::system();
+    /*! sends the next conn request while disconnected */
+    ClockTimer *requestTimer = nullptr;
+    /*! true iff a conn request is due as soon as the queue empties */
+    bool requestPending = false;
+    /*! true iff we've disconnected and shouldn't ask to connect again */
+    bool closing = false;
+    /*! the current interval between connection requests */
+    std::chrono::milliseconds requestInterval;
     QMutex sendQueueMutex;
-    QList<QByteArray> sendQueue;
+    QQueue<PendingMessage> sendQueue;
+    SendState sendState = SendState::idle;
+    /*! the sequence number of the next new data message (0..7) */
+    quint8 nextSeq = 1;
+    /*! the sequence number given to the message at the head of the queue */
+    quint8 headSeq = 0;
+    /*! true iff headSeq has been assigned */
+    bool headSeqAssigned = false;
+    /*! true iff the head was acknowledged before its write completed */
+    bool ackedWhileWriting = false;
+    /*! the number of times the head of the queue has been retransmitted */
+    int retries = 0;
+    /*! the number of data frames retransmitted since construction */
+    quint64 retransmitted = 0;
+    /*! when the data frame awaiting acknowledgement was first written */
+    std::chrono::nanoseconds writtenAt{0};
+    ClockTimer *retransmitTimer = nullptr;
+    RttEstimator rtt;
+    /*! the sequence number of the last data frame received, or -1 */
+    int lastReceivedSeq = -1;
+    /*! the sequence number of an acknowledgement waiting for the link to
+        be free, or -1 */
+    int pendingAck = -1;
+    /*! true iff backpressure(true) is in effect */
+    bool congested = false;
+    int queueCapacity = 32;
+    int lowWatermark = 8;
+    int highWatermark = 24;
     Link *myLink = nullptr;
     bool connected = false;
 };
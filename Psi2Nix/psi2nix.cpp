@@ -5,31 +5,52 @@
 #include "ui_psi2nix.h"
 
 #include <QDebug>
-#include <QSerialPortInfo>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QSignalBlocker>
+
+using CommsLink::SessionRequest;
+using CommsLink::SessionStatus;
 
 Psi2Nix::Psi2Nix(QWidget *parent) :
     QMainWindow(parent),
-    ui(new Ui::Psi2Nix)
+    ui(new Ui::Psi2Nix),
+    session(new CommsLink::Session(nullptr, this))
 {
+    // Whatever was on each device last time is shown until it's replaced.
+    catalogue.load();
+    session->setCatalogue(&catalogue);
+    connect(session, &CommsLink::Session::statusChanged,
+            this, &Psi2Nix::showStatus);
     ui->setupUi(this);
-    QList<QSerialPortInfo> ports = QSerialPortInfo::availablePorts();
-    auto comboBox = ui->serialPort;
-    for (auto port : ports) {
-        QVariant metadata(port.portName());
-        QString descr = port.portName();
-        descr.append(" (");
-        descr.append(port.description());
-        descr.append(")");
-        comboBox->addItem(descr, metadata);
-    }
-    if (ports.length() == 0) {
-        comboBox->setEnabled(false);
-    }
+    ui->deviceContents->sortByColumn(0, Qt::AscendingOrder);
+    connect(ui->deviceContents, &QTreeWidget::itemSelectionChanged,
+            this, [this] {
+        ui->action_RemoveFile->setEnabled(
+                    !ui->deviceContents->selectedItems().isEmpty());
+    });
+    // Ports turn up as they're found, rather than the window waiting for
+    // them all.
+    ui->serialPort->setEnabled(false);
+    connect(&portMonitor, &CommsLink::PortMonitor::portAdded,
+            this, &Psi2Nix::addPort);
+    connect(&portMonitor, &CommsLink::PortMonitor::portRemoved,
+            this, &Psi2Nix::removePort);
+    portMonitor.start();
+
+    metricsLabel = new QLabel(this);
+    statusBar()->addPermanentWidget(metricsLabel);
+    connect(&metricsTimer, &QTimer::timeout, this, &Psi2Nix::showMetrics);
+    metricsTimer.start(500);
+    showMetrics();
 
 }
 
 Psi2Nix::~Psi2Nix()
 {
+    // The session updates the catalogue until it's gone.
+    delete session;
+    catalogue.save();
     delete ui;
 }
 
@@ -40,6 +61,15 @@ void Psi2Nix::changeEvent(QEvent *e)
     case QEvent::LanguageChange:
         ui->retranslateUi(this);
         break;
+    case QEvent::WindowStateChange:
+        // Nobody's looking at the counters while we're minimised.
+        if (isMinimized()) {
+            metricsTimer.stop();
+        } else if (!metricsTimer.isActive()) {
+            metricsTimer.start(500);
+            showMetrics();
+        }
+        break;
     default:
         break;
     }
@@ -51,10 +81,168 @@ void Psi2Nix::on_action_Quit_triggered()
     QCoreApplication::quit();
 }
 
-void Psi2Nix::on_serialPort_currentIndexChanged(int index)
+void Psi2Nix::on_action_SendFile_triggered()
+{
+    const auto path = QFileDialog::getOpenFileName(this, tr("Send File"));
+    if (path.isEmpty()) {
+        return;
+    }
+    SessionRequest request;
+    request.type = SessionRequest::Type::sendFile;
+    request.path = path;
+    request.remoteName = QFileInfo(path).fileName().toUpper().toLatin1();
+    if (!session->post(request)) {
+        statusBar()->showMessage(tr("Too many requests pending"));
+    }
+}
+
+void Psi2Nix::on_action_RemoveFile_triggered()
+{
+    const auto selected = ui->deviceContents->selectedItems();
+    for (const auto *item : selected) {
+        SessionRequest request;
+        request.type = SessionRequest::Type::removeFile;
+        request.remoteName = item->text(0).toLatin1();
+        if (!session->post(request)) {
+            statusBar()->showMessage(tr("Too many requests pending"));
+            return;
+        }
+    }
+}
+
+void Psi2Nix::on_serialPort_activated(int index)
 {
+    // Only the user's choice opens a port; one turning up or going away
+    // moves the selection without opening anything.
     if (index >= 0) {
         qDebug() << "Selected port: "
                  << ui->serialPort->itemData(index).toString();
+        openSelectedPort();
+        showContents();
+    }
+}
+
+void Psi2Nix::on_baudRate_activated(int index)
+{
+    if (index >= 0 && ui->serialPort->currentIndex() >= 0) {
+        openSelectedPort();
+    }
+}
+
+void Psi2Nix::addPort(const QString &name, const QString &description)
+{
+    auto comboBox = ui->serialPort;
+    if (comboBox->findData(name) >= 0) {
+        return;
+    }
+    QString descr = name;
+    if (!description.isEmpty()) {
+        descr.append(" (");
+        descr.append(description);
+        descr.append(")");
+    }
+    {
+        const QSignalBlocker blocker(comboBox);
+        comboBox->addItem(descr, QVariant(name));
+    }
+    comboBox->setEnabled(true);
+    showContents();
+}
+
+void Psi2Nix::removePort(const QString &name)
+{
+    auto comboBox = ui->serialPort;
+    const auto index = comboBox->findData(name);
+    if (index < 0) {
+        return;
+    }
+    if (index == comboBox->currentIndex()) {
+        // The device is gone with it.
+        SessionRequest request;
+        request.type = SessionRequest::Type::close;
+        session->post(request);
+    }
+    {
+        const QSignalBlocker blocker(comboBox);
+        comboBox->removeItem(index);
+    }
+    comboBox->setEnabled(comboBox->count() > 0);
+    showContents();
+}
+
+void Psi2Nix::showStatus(SessionStatus status)
+{
+    QString message;
+    if (!status.portOpen) {
+        message = tr("Port closed");
+    } else if (status.baudRate == 0) {
+        message = tr("Finding baud rate…");
+    } else if (!status.connected) {
+        message = tr("Waiting for device");
+    } else if (status.transferring) {
+        message = tr("Sent %1 of %2 bytes")
+                .arg(status.bytesSent).arg(status.totalBytes);
+    } else {
+        message = tr("Connected at %1 baud").arg(status.baudRate);
+    }
+    statusBar()->showMessage(message);
+    showContents();
+}
+
+void Psi2Nix::showMetrics()
+{
+    const auto metrics = session->metrics();
+    const auto &ack = metrics.ackLatency;
+    metricsLabel->setText(
+                tr("Frames %1 out, %2 in; CRC errors %3; timeouts %4;"
+                   " busy %5; ACK p50 %6 ms, p99 %7 ms")
+                .arg(metrics.framesSent).arg(metrics.framesReceived)
+                .arg(metrics.crcErrors).arg(metrics.readTimeouts)
+                .arg(metrics.busyRejections)
+                .arg(ack.percentile(50) / 1000.0, 0, 'f', 1)
+                .arg(ack.percentile(99) / 1000.0, 0, 'f', 1));
+    metricsLabel->setToolTip(
+                tr("%1 bytes sent (%2 on the wire); %3 received (%4 on the"
+                   " wire)")
+                .arg(metrics.payloadBytesSent).arg(metrics.wireBytesSent)
+                .arg(metrics.payloadBytesReceived)
+                .arg(metrics.wireBytesReceived));
+}
+
+void Psi2Nix::showContents()
+{
+    const auto device = selectedDevice();
+    const auto revision = catalogue.revision();
+    if (device == shownDevice && revision == shownRevision) {
+        return;
+    }
+    if (revision != shownRevision) {
+        catalogue.save();
     }
+    shownDevice = device;
+    shownRevision = revision;
+    auto *view = ui->deviceContents;
+    view->clear();
+    for (const auto &entry : catalogue.entries(device)) {
+        auto *item = new QTreeWidgetItem(view);
+        item->setText(0, QString::fromLatin1(entry.name));
+        item->setData(1, Qt::DisplayRole, entry.size);
+        item->setTextAlignment(1, Qt::AlignRight);
+    }
+}
+
+QString Psi2Nix::selectedDevice() const
+{
+    return ui->serialPort->currentData().toString();
+}
+
+void Psi2Nix::openSelectedPort()
+{
+    SessionRequest request;
+    request.type = SessionRequest::Type::open;
+    request.portName = selectedDevice();
+    bool isNumber = false;
+    const auto rate = ui->baudRate->currentText().toInt(&isNumber);
+    request.baudRate = isNumber ? rate : SessionRequest::AUTO_BAUD;
+    session->post(request);
 }
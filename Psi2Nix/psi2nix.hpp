@@ -3,7 +3,13 @@
 
 #pragma once
 
+#include <QLabel>
 #include <QMainWindow>
+#include <QTimer>
+
+#include "devicecatalogue.hpp"
+#include "portmonitor.hpp"
+#include "session.hpp"
 
 namespace Ui {
 class Psi2Nix;
@@ -22,8 +28,39 @@ protected:
 
 private slots:
     void on_action_Quit_triggered();
-    void on_serialPort_currentIndexChanged(int index);
+    void on_action_SendFile_triggered();
+    void on_action_RemoveFile_triggered();
+    void on_serialPort_activated(int index);
+    void on_baudRate_activated(int index);
+    void showStatus(CommsLink::SessionStatus status);
+    /// \brief Refresh the link counters shown in the status bar.
+    void showMetrics();
+    /// \brief Show the selected port's device's contents, and keep them
+    /// for next time, if the catalogue has changed.
+    void showContents();
+    /// \brief Offer a port that's been found.
+    void addPort(const QString &name, const QString &description);
+    /// \brief Stop offering a port that's gone, closing it if it's open.
+    void removePort(const QString &name);
 
 private:
+    /// \brief Open the selected port at the selected rate.
+    void openSelectedPort();
+    /// \brief Return the name the catalogue knows the selected device by.
+    QString selectedDevice() const;
+
     Ui::Psi2Nix *ui;
+    /// \brief What's on each device, as far as we know; updated by the
+    /// session.
+    CommsLink::DeviceCatalogue catalogue;
+    /// \brief The catalogue's revision when showContents() last ran.
+    quint64 shownRevision = 0;
+    /// \brief The device whose contents are shown.
+    QString shownDevice;
+    CommsLink::Session *session;
+    /// \brief Finds the ports to offer, and notices them coming and going.
+    CommsLink::PortMonitor portMonitor;
+    QLabel *metricsLabel;
+    /// \brief Polls the session's counters while the window is open.
+    QTimer metricsTimer;
 };
@@ -0,0 +1,103 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "recordconverter.hpp"
+
+#if defined(__SSE2__) && (defined(__GNUC__) || defined(__clang__))
+#define PSI2NIX_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace CommsLink {
+
+qint64 RecordConverter::findLineEnd(const char *data, qint64 size) {
+    qint64 pos = 0;
+#ifdef PSI2NIX_HAVE_SSE2
+    // Compare sixteen bytes at a time against both CR and LF.
+    const auto cr = _mm_set1_epi8('\r');
+    const auto lf = _mm_set1_epi8('\n');
+    for (; pos + 16 <= size; pos += 16) {
+        const auto v = _mm_loadu_si128(
+                    reinterpret_cast<const __m128i *>(data + pos));
+        const auto mask = _mm_movemask_epi8(
+                    _mm_or_si128(_mm_cmpeq_epi8(v, cr),
+                                 _mm_cmpeq_epi8(v, lf)));
+        if (mask != 0) {
+            return pos + __builtin_ctz(static_cast<unsigned>(mask));
+        }
+    }
+#endif
+    for (; pos < size; pos++) {
+        if (data[pos] == '\r' || data[pos] == '\n') {
+            break;
+        }
+    }
+    return pos;
+}
+
+void RecordConverter::convert(const char *data, qint64 size,
+                              QVector<Record> &records) {
+    qint64 pos = 0;
+    if (afterCr && size > 0) {
+        // Finish off a CRLF split between pieces.
+        afterCr = false;
+        if (data[0] == '\n') {
+            pending++;
+            pos = 1;
+        }
+    }
+    while (pos < size) {
+        const auto end = pos + findLineEnd(data + pos, size - pos);
+        append(data + pos, end - pos, records);
+        if (end == size) {
+            break;
+        }
+        qint64 endingLength = 1;
+        if (data[end] == '\r') {
+            if (end + 1 == size) {
+                afterCr = true;
+            } else if (data[end + 1] == '\n') {
+                endingLength = 2;
+            }
+        }
+        pending += endingLength;
+        endRecord(records);
+        splitting = false;
+        pos = end + endingLength;
+    }
+}
+
+void RecordConverter::finish(QVector<Record> &records) {
+    if (!partial.isEmpty()) {
+        endRecord(records);
+    }
+    partial.clear();
+    pending = 0;
+    afterCr = false;
+    splitting = false;
+}
+
+void RecordConverter::append(const char *data, qint64 size,
+                             QVector<Record> &records) {
+    while (partial.size() + size > MAX_RECORD) {
+        const auto fill = MAX_RECORD - partial.size();
+        partial.append(data, fill);
+        pending += fill;
+        data += fill;
+        size -= fill;
+        if (!splitting) {
+            numSplit++;
+            splitting = true;
+        }
+        endRecord(records);
+    }
+    partial.append(data, static_cast<int>(size));
+    pending += size;
+}
+
+void RecordConverter::endRecord(QVector<Record> &records) {
+    records.append({partial, pending});
+    partial.clear();
+    pending = 0;
+}
+}
@@ -0,0 +1,62 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QByteArray>
+#include <QVector>
+
+namespace CommsLink {
+
+/// \brief How a host file is turned into what's sent to the device.
+enum struct Conversion : quint8 {
+    none, //!< Sent byte for byte
+    text  //!< Each line sent as one record
+};
+
+/// \brief A record for the device, converted from part of a host file.
+struct Record {
+    QByteArray data;
+    /// \brief The number of bytes of the host file that the record
+    /// accounts for, including any line ending.
+    qint64 sourceBytes = 0;
+};
+
+/// \brief Converts host text into Organiser records, a piece at a time.
+///
+/// Each line becomes a record; LF, CRLF and CR line endings are all
+/// accepted, even when a CRLF is split between pieces. Lines too long for
+/// one record are split across as many as they need.
+class RecordConverter
+{
+public:
+    /// \brief The longest record the Organiser accepts.
+    static constexpr int MAX_RECORD = 254;
+    /// \brief Convert the next piece of the file, appending each record
+    /// completed by it to \p records.
+    void convert(const char *data, qint64 size, QVector<Record> &records);
+    /// \brief Append the last line if it had no line ending, and start
+    /// again for a new file.
+    void finish(QVector<Record> &records);
+    /// \brief Return the number of lines that had to be split.
+    qint64 splitLines() const { return numSplit; }
+    /// \brief Return the offset of the first CR or LF in \p data, or
+    /// \p size if there isn't one; uses SSE2 where it's available.
+    static qint64 findLineEnd(const char *data, qint64 size);
+private:
+    /// \brief Add part of a line to the current record, starting new ones
+    /// as each fills up.
+    void append(const char *data, qint64 size, QVector<Record> &records);
+    void endRecord(QVector<Record> &records);
+    /// \brief The record being built from the current line.
+    QByteArray partial;
+    /// \brief Bytes read since the last record was completed.
+    qint64 pending = 0;
+    /// \brief true iff the last piece ended in a CR, which may be the
+    /// first half of a CRLF.
+    bool afterCr = false;
+    /// \brief true iff the current line has already been split.
+    bool splitting = false;
+    qint64 numSplit = 0;
+};
+}
@@ -0,0 +1,93 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "recordstream.hpp"
+
+#include <QtConcurrent>
+
+namespace CommsLink {
+
+RecordStream::RecordStream(QIODevice &aSource, QObject *parent) :
+    QObject(parent), source(aSource)
+{
+    connect(&watcher, &QFutureWatcher<Batch>::finished,
+            this, &RecordStream::converted);
+}
+
+RecordStream::~RecordStream() {
+    watcher.waitForFinished();
+}
+
+void RecordStream::start() {
+    launch();
+}
+
+bool RecordStream::isReady() {
+    if (next == current.size() && converting && watcher.isFinished()) {
+        adopt();
+    }
+    return next < current.size() || atEnd();
+}
+
+bool RecordStream::take(Record &record) {
+    if (!isReady() || next == current.size()) {
+        return false;
+    }
+    // Shares the record's data rather than copying it.
+    record = current.at(next++);
+    return true;
+}
+
+void RecordStream::untake() {
+    Q_ASSERT(next > 0);
+    next--;
+}
+
+bool RecordStream::atEnd() const {
+    return next == current.size() && !converting && (sourceDone || failed);
+}
+
+RecordStream::Batch RecordStream::convertNext() {
+    Batch batch;
+    chunk.resize(static_cast<int>(CHUNK_SIZE));
+    const auto n = source.read(chunk.data(), CHUNK_SIZE);
+    if (n < 0) {
+        batch.error = true;
+        return batch;
+    }
+    converter.convert(chunk.constData(), n, batch.records);
+    if (n == 0 || source.atEnd()) {
+        converter.finish(batch.records);
+        batch.atEnd = true;
+    }
+    return batch;
+}
+
+void RecordStream::launch() {
+    if (sourceDone || failed) {
+        return;
+    }
+    converting = true;
+    watcher.setFuture(QtConcurrent::run([this] { return convertNext(); }));
+}
+
+void RecordStream::adopt() {
+    auto batch = watcher.result();
+    converting = false;
+    current = std::move(batch.records);
+    next = 0;
+    sourceDone = batch.atEnd;
+    failed = batch.error;
+    // Convert the next piece while these records are sent.
+    launch();
+}
+
+void RecordStream::converted() {
+    if (!converting || !watcher.isFinished() || next < current.size()) {
+        // Either already adopted, or there's no hurry.
+        return;
+    }
+    adopt();
+    emit recordsReady();
+}
+}
@@ -0,0 +1,82 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QFutureWatcher>
+#include <QIODevice>
+#include <QObject>
+
+#include "recordconverter.hpp"
+
+namespace CommsLink {
+
+/// \brief A pipeline stage that reads a host file and converts it into
+/// records on the global thread pool.
+///
+/// The next piece of the file is converted while the records from the
+/// last one are being sent, so at most two pieces' worth of records are
+/// held at once however long the file is.
+class RecordStream : public QObject
+{
+    Q_OBJECT
+public:
+    /// \brief The number of bytes of the file converted at a time.
+    static constexpr qint64 CHUNK_SIZE = 16 * 1024;
+    /// \param source The file to convert, which must stay open until the
+    /// stream is destroyed and mustn't be touched by anything else.
+    explicit RecordStream(QIODevice &source, QObject *parent = nullptr);
+    /// \brief Wait for any conversion in progress to finish.
+    ~RecordStream();
+    /// \brief Start converting the first piece of the file.
+    void start();
+    /// \brief Return true iff take() will return a record or atEnd() is
+    /// true.
+    bool isReady();
+    /// \brief Take the next record, if one has been converted.
+    /// \return false if none is ready yet.
+    bool take(Record &record);
+    /// \brief Put back the record just taken, to be taken again.
+    void untake();
+    /// \brief Return true iff every record has been taken, or the file
+    /// couldn't be read.
+    bool atEnd() const;
+    /// \brief Return true iff the file couldn't be read.
+    bool hasError() const { return failed; }
+    /// \brief Return the number of lines too long for one record.
+    qint64 splitLines() const { return converter.splitLines(); }
+
+signals:
+    /// \brief Emitted when records that weren't ready have become ready.
+    void recordsReady();
+
+private:
+    /// \brief The records from one piece of the file.
+    struct Batch {
+        QVector<Record> records;
+        bool atEnd = false;
+        bool error = false;
+    };
+    /// \brief Read and convert the next piece; runs on the thread pool.
+    Batch convertNext();
+    /// \brief Start converting the next piece, unless there isn't one.
+    void launch();
+    /// \brief Take over the records from the piece just converted.
+    void adopt();
+    /// \brief Called when the piece being converted is done.
+    void converted();
+
+    QIODevice &source;
+    /// \brief Used only by the conversion in progress.
+    RecordConverter converter;
+    QByteArray chunk;
+    QFutureWatcher<Batch> watcher;
+    /// \brief true iff a piece is being converted, or has been converted
+    /// but not adopted.
+    bool converting = false;
+    QVector<Record> current;
+    int next = 0;
+    bool sourceDone = false;
+    bool failed = false;
+};
+}
@@ -0,0 +1,42 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "rttestimator.hpp"
+
+#include <algorithm>
+
+namespace CommsLink {
+
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+RttEstimator::RttEstimator(milliseconds initialTimeout,
+                           milliseconds aMinTimeout,
+                           milliseconds aMaxTimeout) :
+    minTimeout(aMinTimeout), maxTimeout(aMaxTimeout), rto(initialTimeout)
+{
+}
+
+void RttEstimator::addSample(microseconds rtt) {
+    if (!haveSample) {
+        srtt = rtt;
+        rttvar = rtt / 2;
+        haveSample = true;
+    } else {
+        // RTTVAR <- 3/4 RTTVAR + 1/4 |SRTT - R'|; SRTT <- 7/8 SRTT + 1/8 R'
+        const auto delta = srtt > rtt ? srtt - rtt : rtt - srtt;
+        rttvar = (3 * rttvar + delta) / 4;
+        srtt = (7 * srtt + rtt) / 8;
+    }
+    rto = std::clamp(srtt + 4 * rttvar, minTimeout, maxTimeout);
+}
+
+void RttEstimator::backoff() {
+    rto = std::min(rto * 2, maxTimeout);
+}
+
+milliseconds RttEstimator::timeout() const {
+    // Round up, so that a timeout is never shorter than estimated.
+    return std::chrono::ceil<milliseconds>(rto);
+}
+}
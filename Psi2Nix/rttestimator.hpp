@@ -0,0 +1,41 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <chrono>
+
+namespace CommsLink {
+
+/// \brief Estimates the retransmission timeout from measured round-trip
+/// times, as TCP does (Jacobson's algorithm, with Karn's backoff).
+///
+/// Samples must only be taken from frames that weren't retransmitted, as
+/// the acknowledgement of a retransmitted frame can't be matched to a
+/// particular transmission.
+class RttEstimator
+{
+public:
+    explicit RttEstimator(
+            std::chrono::milliseconds initialTimeout = std::chrono::milliseconds{1000},
+            std::chrono::milliseconds minTimeout = std::chrono::milliseconds{50},
+            std::chrono::milliseconds maxTimeout = std::chrono::milliseconds{8000});
+    /// \brief Add a round-trip time measurement.
+    void addSample(std::chrono::microseconds rtt);
+    /// \brief Double the timeout after a retransmission; the next sample
+    /// will reset it.
+    void backoff();
+    /// \brief Return the current retransmission timeout.
+    std::chrono::milliseconds timeout() const;
+    /// \brief Return the smoothed round-trip time, or zero if there have
+    /// been no samples.
+    std::chrono::microseconds smoothedRtt() const { return srtt; }
+private:
+    std::chrono::microseconds minTimeout;
+    std::chrono::microseconds maxTimeout;
+    std::chrono::microseconds srtt{0};
+    std::chrono::microseconds rttvar{0};
+    std::chrono::microseconds rto;
+    bool haveSample = false;
+};
+}
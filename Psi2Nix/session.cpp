@@ -0,0 +1,72 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "session.hpp"
+#include "sessionworker.hpp"
+
+namespace CommsLink {
+
+Session::Session(QThread *aThread, QObject *parent) : QObject(parent),
+    ioThread(aThread)
+{
+    qRegisterMetaType<CommsLink::SessionStatus>();
+    if (ioThread == nullptr) {
+        ioThread = new QThread;
+        ownsThread = true;
+        ioThread->start();
+    }
+    worker = new SessionWorker(*this);
+    worker->moveToThread(ioThread);
+    connect(worker, &SessionWorker::statusReady,
+            this, &Session::publishStatus, Qt::QueuedConnection);
+}
+
+Session::~Session() {
+    // The worker refers to this session until it has been shut down, which
+    // has to happen on its own thread.
+    if (QThread::currentThread() == ioThread) {
+        worker->shutdown();
+    } else {
+        QMetaObject::invokeMethod(worker, &SessionWorker::shutdown,
+                                  Qt::BlockingQueuedConnection);
+    }
+    worker->deleteLater();
+    if (ownsThread) {
+        ioThread->quit();
+        ioThread->wait();
+        delete ioThread;
+    }
+}
+
+bool Session::post(SessionRequest request) {
+    Q_ASSERT(QThread::currentThread() == thread());
+    if (!requests.push(std::move(request))) {
+        return false;
+    }
+    // One wakeup drains everything posted before the worker gets to it.
+    if (!wakeupPending.exchange(true)) {
+        QMetaObject::invokeMethod(worker, &SessionWorker::drainRequests,
+                                  Qt::QueuedConnection);
+    }
+    return true;
+}
+
+SessionStatus Session::status() const {
+    SessionStatus status;
+    status.portOpen = shared.portOpen.load();
+    status.connected = shared.connected.load();
+    status.baudRate = shared.baudRate.load();
+    status.transferring = shared.transferring.load();
+    status.lastTransferSucceeded = shared.lastTransferSucceeded.load();
+    status.bytesSent = shared.bytesSent.load();
+    status.totalBytes = shared.totalBytes.load();
+    status.filesPending = shared.filesPending.load();
+    status.filesSent = shared.filesSent.load();
+    status.filesFailed = shared.filesFailed.load();
+    return status;
+}
+
+void Session::publishStatus() {
+    emit statusChanged(status());
+}
+}
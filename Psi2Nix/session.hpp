@@ -0,0 +1,150 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QMetaType>
+#include <QObject>
+#include <QString>
+#include <QThread>
+
+#include <atomic>
+#include <functional>
+
+#include "linkmetrics.hpp"
+#include "recordconverter.hpp"
+#include "spscqueue.hpp"
+
+namespace CommsLink {
+
+/// \brief A request from the owner of a Session to its I/O thread.
+struct SessionRequest {
+    enum struct Type : quint8 {
+        open,      //!< Open portName at baudRate, or probe for one
+        close,     //!< Close the port
+        sendFile,  //!< Send path to the device as remoteName
+        removeFile //!< Delete remoteName from the device
+    };
+    /// \brief A baudRate asking for the fastest reliable rate to be found.
+    static constexpr qint32 AUTO_BAUD = 0;
+    Type type = Type::close;
+    QString portName;
+    qint32 baudRate = 9600;
+    QString path;
+    QByteArray remoteName;
+    Conversion conversion = Conversion::none;
+};
+
+/// \brief A snapshot of a Session's state.
+struct SessionStatus {
+    bool portOpen = false;
+    bool connected = false;
+    /// \brief The port's rate; 0 while it's being probed or is closed.
+    qint32 baudRate = 0;
+    bool transferring = false;
+    /// \brief Result of the last transfer to finish; meaningless until one
+    /// has.
+    bool lastTransferSucceeded = false;
+    qint64 bytesSent = 0;
+    qint64 totalBytes = 0;
+    /// \brief Files waiting to be sent, including any being sent.
+    int filesPending = 0;
+    /// \brief Files sent since the session was created.
+    int filesSent = 0;
+    /// \brief Files that couldn't be sent since the session was created.
+    int filesFailed = 0;
+};
+
+class DeviceCatalogue;
+class SessionWorker;
+
+/// \brief Runs a Link and Protocol on an I/O thread, away from the thread
+/// that owns the Session.
+///
+/// Requests are handed to the I/O thread through a lock-free queue, and
+/// status comes back as notifications that are coalesced so that no more
+/// than ten a second reach the owning thread however busy the line is.
+class Session : public QObject
+{
+    Q_OBJECT
+public:
+    /// \brief Returns a new device for the named port, which the session
+    /// takes over, or nullptr if there's none.
+    using PortFactory = std::function<QIODevice *(const QString &portName)>;
+
+    /// \brief Create a session.
+    /// \param ioThread The thread to run the link on, which must be
+    /// running; if nullptr, the session starts a thread of its own.
+    explicit Session(QThread *ioThread = nullptr, QObject *parent = nullptr);
+    ~Session();
+    /// \brief Pass a request to the I/O thread.
+    ///
+    /// Must only be called from the thread that owns this Session.
+    /// \return false if too many requests are already waiting.
+    bool post(SessionRequest request);
+    /// \brief Return the latest status, without waiting for the I/O thread.
+    SessionStatus status() const;
+    /// \brief Keep \p catalogue up to date with the files written to and
+    /// deleted from the device, which it knows by the port's name.
+    ///
+    /// Must be called before the first request is posted; \p catalogue
+    /// must outlive the session.
+    void setCatalogue(DeviceCatalogue *catalogue) {
+        deviceCatalogue = catalogue;
+    }
+    /// \brief Open ports with \p factory rather than as serial ports.
+    ///
+    /// Must be called before the first request is posted; \p factory is
+    /// called on the I/O thread.
+    void setPortFactory(PortFactory factory) {
+        portFactory = std::move(factory);
+    }
+    /// \brief Return the link's counters, accumulated over every port the
+    /// session has opened; cheap enough to poll.
+    LinkMetricsSnapshot metrics() const { return linkMetrics.snapshot(); }
+
+signals:
+    /// \brief Emitted, at a limited rate, when the status has changed.
+    void statusChanged(CommsLink::SessionStatus status);
+
+private slots:
+    /// \brief Read the status published by the I/O thread and pass it on.
+    void publishStatus();
+
+private:
+    friend class SessionWorker;
+    /// \brief Status fields written by the I/O thread and read from any.
+    struct SharedStatus {
+        std::atomic<bool> portOpen{false};
+        std::atomic<bool> connected{false};
+        std::atomic<qint32> baudRate{0};
+        std::atomic<bool> transferring{false};
+        std::atomic<bool> lastTransferSucceeded{false};
+        std::atomic<qint64> bytesSent{0};
+        std::atomic<qint64> totalBytes{0};
+        std::atomic<int> filesPending{0};
+        std::atomic<int> filesSent{0};
+        std::atomic<int> filesFailed{0};
+    };
+
+    SpscQueue<SessionRequest, 64> requests;
+    /// \brief true iff the I/O thread has been asked to drain requests and
+    /// hasn't yet started to.
+    std::atomic<bool> wakeupPending{false};
+    SharedStatus shared;
+    /// \brief Updated by the I/O thread's Link and Protocol.
+    LinkMetrics linkMetrics;
+    QThread *ioThread = nullptr;
+    /// \brief true iff ioThread was started by, and belongs to, this session.
+    bool ownsThread = false;
+    SessionWorker *worker = nullptr;
+    /// \brief Updated by the I/O thread, if set.
+    DeviceCatalogue *deviceCatalogue = nullptr;
+    /// \brief Used by the I/O thread to open ports, if set.
+    PortFactory portFactory;
+};
+}
+
+Q_DECLARE_METATYPE(CommsLink::SessionStatus)
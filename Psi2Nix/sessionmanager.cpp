@@ -0,0 +1,103 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "sessionmanager.hpp"
+
+#include <QSerialPortInfo>
+
+#include <algorithm>
+
+namespace CommsLink {
+
+// The most I/O threads started by default; the link is slow enough that a
+// few threads can keep many ports busy.
+constexpr int MAX_DEFAULT_THREADS = 4;
+
+SessionManager::SessionManager(int threadCount, QObject *parent) :
+    QObject(parent)
+{
+    if (threadCount <= 0) {
+        threadCount = std::clamp(QThread::idealThreadCount(),
+                                 1, MAX_DEFAULT_THREADS);
+    }
+    for (int i = 0; i < threadCount; i++) {
+        auto thread = new QThread(this);
+        thread->setObjectName(QString("Psi2Nix I/O %1").arg(i));
+        thread->start();
+        threads.append(thread);
+    }
+}
+
+SessionManager::~SessionManager() {
+    // Sessions shut down on their threads, so they have to go first.
+    qDeleteAll(sessions);
+    sessions.clear();
+    for (auto thread : threads) {
+        thread->quit();
+    }
+    for (auto thread : threads) {
+        thread->wait();
+    }
+}
+
+Session *SessionManager::open(const QString &portName, qint32 baudRate) {
+    close(portName);
+    auto thread = leastLoadedThread();
+    auto session = new Session(thread);
+    session->setPortFactory(portFactory);
+    connect(session, &Session::statusChanged,
+            this, [this, portName](SessionStatus status) {
+        emit statusChanged(portName, status);
+    });
+    sessions.insert(portName, session);
+    assignments.insert(portName, thread);
+    SessionRequest request;
+    request.type = SessionRequest::Type::open;
+    request.portName = portName;
+    request.baudRate = baudRate;
+    session->post(request);
+    return session;
+}
+
+int SessionManager::openAll(qint32 baudRate) {
+    const auto ports = QSerialPortInfo::availablePorts();
+    for (const auto &port : ports) {
+        open(port.portName(), baudRate);
+    }
+    return ports.size();
+}
+
+void SessionManager::close(const QString &portName) {
+    delete sessions.take(portName);
+    assignments.remove(portName);
+}
+
+bool SessionManager::sendFile(const QString &path,
+                              const QByteArray &remoteName,
+                              Conversion conversion) {
+    SessionRequest request;
+    request.type = SessionRequest::Type::sendFile;
+    request.path = path;
+    request.remoteName = remoteName;
+    request.conversion = conversion;
+    bool allQueued = true;
+    for (auto session : sessions) {
+        allQueued &= session->post(request);
+    }
+    return allQueued;
+}
+
+QThread *SessionManager::leastLoadedThread() const {
+    QThread *best = nullptr;
+    int bestLoad = 0;
+    for (auto thread : threads) {
+        const auto load = std::count(assignments.cbegin(),
+                                     assignments.cend(), thread);
+        if (best == nullptr || load < bestLoad) {
+            best = thread;
+            bestLoad = static_cast<int>(load);
+        }
+    }
+    return best;
+}
+}
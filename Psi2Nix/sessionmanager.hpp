@@ -0,0 +1,75 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QByteArray>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+#include <QVector>
+
+#include "session.hpp"
+
+namespace CommsLink {
+
+/// \brief Drives a Session for each of a number of ports, spread across a
+/// small pool of I/O threads.
+///
+/// Everything a Session does on its thread is event-driven, so a slow or
+/// stalled device only holds up its own transfers and never its
+/// neighbours'; the pool just keeps one thread from doing all the
+/// framing and checksumming.
+class SessionManager : public QObject
+{
+    Q_OBJECT
+public:
+    /// \brief Create a manager.
+    /// \param threadCount The number of I/O threads; if 0, one per core up
+    /// to four.
+    explicit SessionManager(int threadCount = 0, QObject *parent = nullptr);
+    ~SessionManager();
+    /// \brief Open a port, replacing any session already using it.
+    /// \return The port's session.
+    Session *open(const QString &portName, qint32 baudRate);
+    /// \brief Open every serial port on the system.
+    /// \return The number of ports opened.
+    int openAll(qint32 baudRate);
+    /// \brief Close a port and destroy its session.
+    void close(const QString &portName);
+    /// \brief Return the names of the ports being managed.
+    QStringList portNames() const { return sessions.keys(); }
+    /// \brief Return the session using a port, or nullptr if there isn't one.
+    Session *session(const QString &portName) const {
+        return sessions.value(portName);
+    }
+    /// \brief Queue a file to be sent to every device.
+    /// \return false if any session had too many requests waiting.
+    bool sendFile(const QString &path, const QByteArray &remoteName,
+                  Conversion conversion = Conversion::none);
+    /// \brief Open ports opened from now on with \p factory rather than
+    /// as serial ports; see Session::setPortFactory().
+    void setPortFactory(Session::PortFactory factory) {
+        portFactory = std::move(factory);
+    }
+    /// \brief Return the number of I/O threads.
+    int threadCount() const { return threads.size(); }
+
+signals:
+    /// \brief Emitted, at a limited rate, when a port's status has changed.
+    void statusChanged(const QString &portName,
+                       CommsLink::SessionStatus status);
+
+private:
+    /// \brief Return the thread running the fewest sessions.
+    QThread *leastLoadedThread() const;
+
+    QVector<QThread *> threads;
+    QMap<QString, Session *> sessions;
+    /// \brief The thread each port's session runs on.
+    QMap<QString, QThread *> assignments;
+    Session::PortFactory portFactory;
+};
+}
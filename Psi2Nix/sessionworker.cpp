@@ -0,0 +1,285 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "sessionworker.hpp"
+
+#include <QSerialPort>
+#include <QtDebug>
+
+#include <algorithm>
+
+#include "devicecatalogue.hpp"
+
+namespace CommsLink {
+
+// The minimum time between status notifications.
+constexpr qint64 NOTIFY_INTERVAL_MS = 100;
+// The rate used if probing finds none that's reliable.
+constexpr qint32 FALLBACK_BAUD = 9600;
+
+SessionWorker::SessionWorker(Session &aSession) : session(&aSession)
+{
+    notifyTimer = new QTimer(this);
+    notifyTimer->setSingleShot(true);
+    connect(notifyTimer, &QTimer::timeout, this, &SessionWorker::notify);
+}
+
+SessionWorker::~SessionWorker() {
+    closePort();
+}
+
+void SessionWorker::drainRequests() {
+    if (session == nullptr) {
+        return;
+    }
+    // Clear the flag first, so that anything posted from here on gets a
+    // wakeup of its own.
+    session->wakeupPending.store(false);
+    SessionRequest request;
+    while (session->requests.pop(request)) {
+        handle(request);
+    }
+}
+
+void SessionWorker::shutdown() {
+    closePort();
+    notifyTimer->stop();
+    session = nullptr;
+}
+
+void SessionWorker::handle(const SessionRequest &request) {
+    switch (request.type) {
+    case SessionRequest::Type::open:
+        openPort(request.portName, request.baudRate);
+        break;
+    case SessionRequest::Type::close:
+        closePort();
+        break;
+    case SessionRequest::Type::sendFile:
+        pendingFiles.enqueue(request);
+        session->shared.filesPending.fetch_add(1);
+        startNextFile();
+        break;
+    case SessionRequest::Type::removeFile:
+        // Queued behind the files before it, so that it can't come between
+        // a file's open and its close.
+        pendingFiles.enqueue(request);
+        startNextFile();
+        break;
+    }
+}
+
+void SessionWorker::openPort(const QString &name, qint32 baudRate) {
+    closePort();
+    portName = name;
+    if (session->portFactory) {
+        port.reset(session->portFactory(name));
+        if (!port) {
+            qWarning() << "No device for" << name;
+            closePort();
+            return;
+        }
+    } else {
+        port = std::make_unique<QSerialPort>(name);
+    }
+    if (baudRate != SessionRequest::AUTO_BAUD) {
+        setPortRate(baudRate);
+    }
+    link = std::make_unique<Link>();
+    link->setMetrics(session->linkMetrics);
+    link->setPort(*port);
+    if (!port->isOpen()) {
+        qWarning() << "Unable to open" << name << ":" << port->errorString();
+        closePort();
+        return;
+    }
+    session->shared.portOpen.store(true);
+    if (baudRate != SessionRequest::AUTO_BAUD) {
+        session->shared.baudRate.store(baudRate);
+        attachProtocol();
+        return;
+    }
+    // Find a rate before the protocol starts using the link.
+    statusTouched();
+    prober = new BaudProber(*link, [this](qint32 rate) {
+        return setPortRate(rate);
+    }, this);
+    connect(prober, &BaudProber::finished, this, [this](qint32 rate) {
+        prober->deleteLater();
+        prober = nullptr;
+        if (rate == 0) {
+            qWarning() << "No reliable rate found; using" << FALLBACK_BAUD;
+            rate = FALLBACK_BAUD;
+            setPortRate(rate);
+        }
+        session->shared.baudRate.store(rate);
+        attachProtocol();
+        startNextFile();
+    });
+    prober->start(BaudProber::supportedRates());
+}
+
+void SessionWorker::attachProtocol() {
+    protocol = std::make_unique<Protocol>();
+    protocol->setLink(*link);
+    connect(protocol.get(), &Protocol::connectionChanged,
+            this, [this](bool connected) {
+        session->shared.connected.store(connected);
+        statusTouched();
+    });
+    statusTouched();
+}
+
+void SessionWorker::closePort() {
+    // Whatever hasn't been sent yet won't be.
+    const int abandoned = static_cast<int>(
+                std::count_if(pendingFiles.begin(), pendingFiles.end(),
+                              [](const SessionRequest &request) {
+        return request.type == SessionRequest::Type::sendFile;
+    })) + (transfer != nullptr ? 1 : 0);
+    if (transfer != nullptr) {
+        transfer->disconnect(this);
+        delete transfer;
+        transfer = nullptr;
+    }
+    pendingFiles.clear();
+    // Any deletion in progress is abandoned with the protocol.
+    removing = false;
+    delete prober;
+    prober = nullptr;
+    protocol.reset();
+    link.reset();
+    port.reset();
+    if (session != nullptr) {
+        session->shared.filesPending.fetch_sub(abandoned);
+        session->shared.filesFailed.fetch_add(abandoned);
+        session->shared.portOpen.store(false);
+        session->shared.baudRate.store(0);
+        session->shared.connected.store(false);
+        session->shared.transferring.store(false);
+        statusTouched();
+    }
+}
+
+bool SessionWorker::setPortRate(qint32 rate) {
+    // Anything but a serial port runs at whatever rate it likes.
+    auto *serialPort = qobject_cast<QSerialPort *>(port.get());
+    return serialPort == nullptr || serialPort->setBaudRate(rate);
+}
+
+void SessionWorker::startNextFile() {
+    // While the rate is being probed, files wait for the protocol.
+    if (transfer != nullptr || removing || prober != nullptr
+            || pendingFiles.isEmpty()) {
+        return;
+    }
+    const auto request = pendingFiles.dequeue();
+    if (request.type == SessionRequest::Type::removeFile) {
+        removeFile(request.remoteName);
+        return;
+    }
+    auto &shared = session->shared;
+    if (!protocol) {
+        qWarning() << "Can't send" << request.path << "; no port open";
+        fileDone(false);
+        startNextFile();
+        return;
+    }
+    transfer = new FileTransfer(*protocol, this);
+    connect(transfer, &FileTransfer::progress,
+            this, [this](qint64 bytesSent, qint64 totalBytes) {
+        session->shared.bytesSent.store(bytesSent);
+        session->shared.totalBytes.store(totalBytes);
+        statusTouched();
+    });
+    connect(transfer, &FileTransfer::finished,
+            this, [this, remoteName = request.remoteName](bool success) {
+        if (success && session->deviceCatalogue != nullptr) {
+            session->deviceCatalogue->recordWritten(
+                        portName, remoteName, transfer->bytesStored());
+        }
+        transfer->deleteLater();
+        transfer = nullptr;
+        fileDone(success);
+        startNextFile();
+    });
+    shared.bytesSent.store(0);
+    shared.totalBytes.store(0);
+    shared.transferring.store(true);
+    // The transfer may finish (and be replaced) before start() returns.
+    const auto started = transfer;
+    if (!started->start(request.path, request.remoteName,
+                        request.conversion)) {
+        delete started;
+        transfer = nullptr;
+        fileDone(false);
+        startNextFile();
+        return;
+    }
+    if (transfer == started) {
+        shared.totalBytes.store(started->totalBytes());
+    }
+    statusTouched();
+}
+
+void SessionWorker::removeFile(const QByteArray &remoteName) {
+    if (!protocol) {
+        qWarning() << "Can't delete" << remoteName << "; no port open";
+        startNextFile();
+        return;
+    }
+    QByteArray payload;
+    payload.reserve(1 + remoteName.size());
+    payload.append(static_cast<char>(FileOp::remove));
+    payload.append(remoteName);
+    removing = true;
+    const bool queued = protocol->enqueue(
+                Message{PacketType::data, payload},
+                [this, remoteName](bool sent) {
+        if (!removing) {
+            // The port has been closed.
+            return;
+        }
+        removing = false;
+        if (!sent) {
+            qWarning() << "Unable to delete" << remoteName;
+        } else if (session->deviceCatalogue != nullptr) {
+            session->deviceCatalogue->recordRemoved(portName, remoteName);
+        }
+        statusTouched();
+        startNextFile();
+    });
+    if (!queued) {
+        qWarning() << "Unable to delete" << remoteName << "; queue full";
+        removing = false;
+        startNextFile();
+    }
+}
+
+void SessionWorker::fileDone(bool success) {
+    auto &shared = session->shared;
+    shared.transferring.store(false);
+    shared.lastTransferSucceeded.store(success);
+    (success ? shared.filesSent : shared.filesFailed).fetch_add(1);
+    shared.filesPending.fetch_sub(1);
+    statusTouched();
+}
+
+void SessionWorker::statusTouched() {
+    if (session == nullptr || notifyTimer->isActive()) {
+        return;
+    }
+    const auto elapsed = sinceNotify.isValid()
+            ? sinceNotify.elapsed() : NOTIFY_INTERVAL_MS;
+    if (elapsed >= NOTIFY_INTERVAL_MS) {
+        notify();
+    } else {
+        notifyTimer->start(static_cast<int>(NOTIFY_INTERVAL_MS - elapsed));
+    }
+}
+
+void SessionWorker::notify() {
+    sinceNotify.start();
+    emit statusReady();
+}
+}
@@ -0,0 +1,79 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QObject>
+#include <QQueue>
+#include <QTimer>
+
+#include <memory>
+
+#include "baudprober.hpp"
+#include "filetransfer.hpp"
+#include "link.hpp"
+#include "protocol.hpp"
+#include "session.hpp"
+
+namespace CommsLink {
+
+/// \brief The part of a Session that lives on its I/O thread.
+class SessionWorker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SessionWorker(Session &session);
+    ~SessionWorker();
+
+public slots:
+    /// \brief Handle every request waiting in the session's queue.
+    void drainRequests();
+    /// \brief Close the port and detach from the session, which is about
+    /// to be destroyed.
+    void shutdown();
+
+signals:
+    /// \brief Emitted, at a limited rate, when the shared status changes.
+    void statusReady();
+
+private:
+    void handle(const SessionRequest &request);
+    void openPort(const QString &name, qint32 baudRate);
+    void closePort();
+    /// \brief Set the port's rate, if it has one.
+    bool setPortRate(qint32 rate);
+    /// \brief Start the protocol on the open link.
+    void attachProtocol();
+    /// \brief Start the next queued file, if nothing is being sent.
+    void startNextFile();
+    /// \brief Ask the device to delete a file.
+    void removeFile(const QByteArray &remoteName);
+    /// \brief Record the outcome of the file dequeued last.
+    void fileDone(bool success);
+    /// \brief Note that the shared status has changed, and notify the
+    /// session unless it was notified too recently.
+    void statusTouched();
+    void notify();
+
+    Session *session;
+    std::unique_ptr<QIODevice> port;
+    std::unique_ptr<Link> link;
+    std::unique_ptr<Protocol> protocol;
+    /// \brief Finding the port's rate, if that's in progress.
+    BaudProber *prober = nullptr;
+    /// \brief The transfer in progress, if any.
+    FileTransfer *transfer = nullptr;
+    /// \brief Files waiting to be sent or deleted after the current one.
+    QQueue<SessionRequest> pendingFiles;
+    /// \brief true iff a file is being deleted.
+    bool removing = false;
+    /// \brief The name of the open port.
+    QString portName;
+    /// \brief Fires when a notification held back by the rate limit is due.
+    QTimer *notifyTimer;
+    /// \brief Time since the last notification.
+    QElapsedTimer sinceNotify;
+};
+}
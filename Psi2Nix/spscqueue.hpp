@@ -0,0 +1,65 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace CommsLink {
+
+/// \brief A bounded, lock-free queue for passing values from exactly one
+/// producer thread to exactly one consumer thread.
+///
+/// \tparam T The element type; must be default-constructible and
+/// move-assignable.
+/// \tparam Capacity The number of elements; must be a power of two.
+template <typename T, size_t Capacity>
+class SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+public:
+    /// \brief Add a value to the queue; call from the producer only.
+    /// \return false if the queue is full.
+    bool push(T value) {
+        const auto t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == Capacity) {
+            return false;
+        }
+        slots[t & (Capacity - 1)] = std::move(value);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+    /// \brief Remove the oldest value from the queue; call from the
+    /// consumer only.
+    /// \return false if the queue is empty.
+    bool pop(T &value) {
+        const auto h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        value = std::move(slots[h & (Capacity - 1)]);
+        // Don't keep the moved-from value's resources alive.
+        slots[h & (Capacity - 1)] = T{};
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+    /// \brief Return true iff the queue is empty; exact only when called
+    /// from the consumer.
+    bool isEmpty() const {
+        return head.load(std::memory_order_acquire)
+                == tail.load(std::memory_order_acquire);
+    }
+private:
+    std::array<T, Capacity> slots{};
+    /// \brief The index of the next value to be popped; written only by
+    /// the consumer.
+    alignas(64) std::atomic<size_t> head{0};
+    /// \brief The index of the next slot to be filled; written only by
+    /// the producer.
+    alignas(64) std::atomic<size_t> tail{0};
+};
+}
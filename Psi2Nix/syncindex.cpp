@@ -0,0 +1,178 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "syncindex.hpp"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QtConcurrent>
+#include <QtDebug>
+
+namespace CommsLink {
+
+namespace {
+constexpr int INDEX_VERSION = 1;
+}
+
+SyncIndex::SyncIndex(QString path) : indexPath(std::move(path))
+{
+}
+
+QString SyncIndex::defaultPath() {
+    return QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)
+            + "/sync-index.json";
+}
+
+bool SyncIndex::load() {
+    hashes.clear();
+    devices.clear();
+    QFile file(indexPath);
+    if (!file.exists()) {
+        return true;
+    }
+    if (!file.open(QIODevice::ReadOnly)) {
+        qWarning() << "Unable to read" << indexPath << ":"
+                   << file.errorString();
+        return false;
+    }
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson(file.readAll(), &error);
+    if (doc.isNull() || doc.object().value("version").toInt()
+            != INDEX_VERSION) {
+        qWarning() << "Ignoring unreadable index" << indexPath << ":"
+                   << error.errorString();
+        return false;
+    }
+    const auto files = doc.object().value("files").toObject();
+    for (auto it = files.begin(); it != files.end(); ++it) {
+        const auto entry = it.value().toObject();
+        hashes.insert(it.key(), {
+                          static_cast<qint64>(entry.value("size").toDouble()),
+                          static_cast<qint64>(entry.value("modified").toDouble()),
+                          entry.value("hash").toString().toLatin1()
+                      });
+    }
+    const auto devs = doc.object().value("devices").toObject();
+    for (auto dev = devs.begin(); dev != devs.end(); ++dev) {
+        auto &sent = devices[dev.key()];
+        const auto entries = dev.value().toObject();
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            const auto entry = it.value().toObject();
+            sent.insert(it.key().toLatin1(), {
+                            entry.value("hash").toString().toLatin1(),
+                            static_cast<qint64>(entry.value("size").toDouble()),
+                            static_cast<qint64>(entry.value("sent").toDouble())
+                        });
+        }
+    }
+    return true;
+}
+
+bool SyncIndex::save() const {
+    QJsonObject files;
+    for (auto it = hashes.begin(); it != hashes.end(); ++it) {
+        files.insert(it.key(), QJsonObject{
+                         {"size", static_cast<double>(it->size)},
+                         {"modified", static_cast<double>(it->modified)},
+                         {"hash", QString::fromLatin1(it->hash)}
+                     });
+    }
+    QJsonObject devs;
+    for (auto dev = devices.begin(); dev != devices.end(); ++dev) {
+        QJsonObject entries;
+        for (auto it = dev->begin(); it != dev->end(); ++it) {
+            entries.insert(QString::fromLatin1(it.key()), QJsonObject{
+                               {"hash", QString::fromLatin1(it->hash)},
+                               {"size", static_cast<double>(it->size)},
+                               {"sent", static_cast<double>(it->sent)}
+                           });
+        }
+        devs.insert(dev.key(), entries);
+    }
+    const QJsonObject root{
+        {"version", INDEX_VERSION},
+        {"files", files},
+        {"devices", devs}
+    };
+    QDir().mkpath(QFileInfo(indexPath).absolutePath());
+    QSaveFile file(indexPath);
+    if (!file.open(QIODevice::WriteOnly)
+            || file.write(QJsonDocument(root).toJson(QJsonDocument::Compact))
+            < 0
+            || !file.commit()) {
+        qWarning() << "Unable to write" << indexPath << ":"
+                   << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+void SyncIndex::refresh(QVector<SyncFile> &files) {
+    // Only files that have changed since they were last hashed need
+    // reading.
+    QVector<int> stale;
+    auto *data = files.data();
+    for (int i = 0; i < files.size(); i++) {
+        auto &file = data[i];
+        const QFileInfo info(file.path);
+        file.hash.clear();
+        if (!info.isFile()) {
+            continue;
+        }
+        file.size = info.size();
+        file.modified = info.lastModified().toMSecsSinceEpoch();
+        const auto cached = hashes.constFind(info.absoluteFilePath());
+        if (cached != hashes.constEnd() && cached->size == file.size
+                && cached->modified == file.modified) {
+            file.hash = cached->hash;
+        } else {
+            stale.append(i);
+        }
+    }
+    QtConcurrent::blockingMap(stale, [data](int i) {
+        data[i].hash = hashFile(data[i].path);
+    });
+    numHashed = stale.size();
+    for (int i : stale) {
+        const auto &file = data[i];
+        if (!file.hash.isEmpty()) {
+            hashes.insert(QFileInfo(file.path).absoluteFilePath(),
+                          {file.size, file.modified, file.hash});
+        }
+    }
+}
+
+bool SyncIndex::needsSending(const QString &device,
+                             const SyncFile &file) const {
+    const auto dev = devices.constFind(device);
+    if (dev == devices.constEnd()) {
+        return true;
+    }
+    const auto sent = dev->constFind(file.remoteName);
+    return sent == dev->constEnd() || file.hash.isEmpty()
+            || sent->hash != file.hash || sent->size != file.size;
+}
+
+void SyncIndex::recordSent(const QString &device, const SyncFile &file) {
+    devices[device].insert(file.remoteName, {
+                               file.hash, file.size,
+                               QDateTime::currentMSecsSinceEpoch()
+                           });
+}
+
+QByteArray SyncIndex::hashFile(const QString &path) {
+    QFile file(path);
+    QCryptographicHash hash(QCryptographicHash::Sha256);
+    if (!file.open(QIODevice::ReadOnly) || !hash.addData(&file)) {
+        return {};
+    }
+    return hash.result().toHex();
+}
+}
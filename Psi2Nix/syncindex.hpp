@@ -0,0 +1,86 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QByteArray>
+#include <QHash>
+#include <QString>
+#include <QVector>
+
+namespace CommsLink {
+
+/// \brief A file on the host that may need sending to a device.
+struct SyncFile {
+    QString path;
+    /// \brief The name the file is given on the device.
+    QByteArray remoteName;
+    /// \brief The hex SHA-256 of the file's contents; empty if it couldn't
+    /// be read.
+    QByteArray hash;
+    qint64 size = 0;
+    /// \brief Modification time, in milliseconds since the epoch.
+    qint64 modified = 0;
+};
+
+/// \brief A persistent record of what was last sent to each device, so
+/// that only new or changed files need sending again.
+///
+/// Devices are told apart by a name chosen by the caller, such as the
+/// port they're connected to. Files are compared by the hash of their
+/// contents; hashes are kept between runs and a file is only hashed again
+/// once its size or modification time changes.
+class SyncIndex
+{
+public:
+    /// \param path The file in which the index is kept.
+    explicit SyncIndex(QString path = defaultPath());
+    /// \brief Return the index file used unless another is given.
+    static QString defaultPath();
+    QString path() const { return indexPath; }
+    /// \brief Read the index file; a missing one gives an empty index.
+    /// \return false if the file exists but couldn't be read.
+    bool load();
+    /// \brief Write the index file, replacing it atomically.
+    bool save() const;
+    /// \brief Fill in the hash, size and time of each file.
+    ///
+    /// Files that have changed since they were last hashed are hashed in
+    /// parallel on the global thread pool.
+    void refresh(QVector<SyncFile> &files);
+    /// \brief Return true iff \p device doesn't already hold \p file as it
+    /// is now; refresh() must have been called on it.
+    bool needsSending(const QString &device, const SyncFile &file) const;
+    /// \brief Note that \p file has been sent to \p device.
+    void recordSent(const QString &device, const SyncFile &file);
+    /// \brief Forget everything sent to \p device, as after it's wiped.
+    void forgetDevice(const QString &device) { devices.remove(device); }
+    /// \brief Return the number of files hashed by the last refresh().
+    int lastHashed() const { return numHashed; }
+    /// \brief Return the hex SHA-256 of a file's contents, or an empty
+    /// array if it can't be read.
+    static QByteArray hashFile(const QString &path);
+
+private:
+    /// \brief A host file as it was when last hashed.
+    struct HashedFile {
+        qint64 size = 0;
+        qint64 modified = 0;
+        QByteArray hash;
+    };
+    /// \brief A file as it was when last sent to a device.
+    struct SentFile {
+        QByteArray hash;
+        qint64 size = 0;
+        /// \brief When it was sent, in milliseconds since the epoch.
+        qint64 sent = 0;
+    };
+
+    QString indexPath;
+    /// \brief Keyed by absolute path.
+    QHash<QString, HashedFile> hashes;
+    /// \brief Keyed by device, then by name on the device.
+    QHash<QString, QHash<QByteArray, SentFile>> devices;
+    int numHashed = 0;
+};
+}
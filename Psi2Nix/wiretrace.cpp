@@ -0,0 +1,184 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "wiretrace.hpp"
+
+#include <cstring>
+
+#include "framedecoder.hpp"
+
+namespace CommsLink {
+
+namespace {
+const char TRACE_MAGIC[4]{'P', '2', 'N', 'T'};
+constexpr char TRACE_VERSION = 1;
+// The largest record a reader will accept; anything bigger is corruption.
+constexpr quint64 MAX_RECORD_SIZE = 1 << 20;
+
+// Append value to buf as unsigned LEB128, returning the new end.
+char *putVarint(char *buf, quint64 value) {
+    do {
+        auto b = static_cast<quint8>(value & 0x7f);
+        value >>= 7;
+        if (value != 0) {
+            b |= 0x80;
+        }
+        *buf++ = static_cast<char>(b);
+    } while (value != 0);
+    return buf;
+}
+
+// Feed data to decoder, passing each frame it completes to handle.
+template <typename Handler>
+void decodeFrames(FrameDecoder &decoder, const QByteArray &data,
+                  Handler handle) {
+    const char *pos = data.constData();
+    qint64 remaining = data.size();
+    while (remaining > 0) {
+        const auto consumed = decoder.decode(pos, remaining);
+        pos += consumed;
+        remaining -= consumed;
+        if (decoder.hasMessage()) {
+            handle(decoder.takeMessage());
+        }
+    }
+}
+}
+
+WireTraceWriter::WireTraceWriter(QIODevice &anOut) : out(anOut) {}
+
+bool WireTraceWriter::start() {
+    clock.start();
+    lastTimestamp = 0;
+    return out.write(TRACE_MAGIC, sizeof(TRACE_MAGIC)) == sizeof(TRACE_MAGIC)
+            && out.putChar(TRACE_VERSION);
+}
+
+void WireTraceWriter::record(TraceDirection direction,
+                             const char *data, qint64 size) {
+    record(direction, clock.nsecsElapsed() / 1000, data, size);
+}
+
+void WireTraceWriter::record(TraceDirection direction, qint64 timestamp,
+                             const char *data, qint64 size) {
+    Q_ASSERT(timestamp >= lastTimestamp);
+    // Two ten-byte varints at most.
+    char header[20];
+    auto end = putVarint(header,
+                         static_cast<quint64>(timestamp - lastTimestamp));
+    end = putVarint(end, static_cast<quint64>(size) << 1
+                    | static_cast<quint8>(direction));
+    out.write(header, end - header);
+    out.write(data, size);
+    lastTimestamp = timestamp;
+}
+
+WireTraceReader::WireTraceReader(QIODevice &anIn) : in(anIn) {}
+
+bool WireTraceReader::start() {
+    char header[sizeof(TRACE_MAGIC) + 1];
+    lastTimestamp = 0;
+    corrupt = in.read(header, sizeof(header)) != sizeof(header)
+            || std::memcmp(header, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0
+            || header[sizeof(TRACE_MAGIC)] != TRACE_VERSION;
+    return !corrupt;
+}
+
+bool WireTraceReader::next(TraceRecord &record) {
+    if (corrupt || in.atEnd()) {
+        return false;
+    }
+    quint64 delta, lengthAndDirection;
+    if (!readVarint(delta) || !readVarint(lengthAndDirection)
+            || (lengthAndDirection >> 1) > MAX_RECORD_SIZE) {
+        corrupt = true;
+        return false;
+    }
+    const auto size = static_cast<int>(lengthAndDirection >> 1);
+    record.direction = (lengthAndDirection & 1)
+            ? TraceDirection::sent : TraceDirection::received;
+    record.timestamp = lastTimestamp += static_cast<qint64>(delta);
+    record.data.resize(size);
+    if (in.read(record.data.data(), size) != size) {
+        corrupt = true;
+        return false;
+    }
+    return true;
+}
+
+QVector<TraceRecord> WireTraceReader::readAll() {
+    QVector<TraceRecord> records;
+    TraceRecord record;
+    while (next(record)) {
+        records.append(record);
+    }
+    return records;
+}
+
+bool WireTraceReader::readVarint(quint64 &value) {
+    value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        char c;
+        if (!in.getChar(&c)) {
+            return false;
+        }
+        const auto b = static_cast<quint8>(c);
+        value |= static_cast<quint64>(b & 0x7f) << shift;
+        if ((b & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+QVector<TraceAnomaly> findTraceAnomalies(const QVector<TraceRecord> &records,
+                                         qint64 frameTimeout,
+                                         qint64 responseTimeout) {
+    QVector<TraceAnomaly> anomalies;
+    FrameDecoder decoder;
+    FrameDecoder sentDecoder;
+    // The time of the last write not yet answered, or -1.
+    qint64 awaitingSince = -1;
+    qint64 lastReceived = 0;
+    // The sequence number of the last data frame sent and not yet
+    // acknowledged, or -1.
+    int unacknowledged = -1;
+    for (int i = 0; i < records.size(); i++) {
+        const auto &record = records.at(i);
+        if (record.direction == TraceDirection::sent) {
+            decodeFrames(sentDecoder, record.data, [&](const Message &msg) {
+                if (msg.type != PacketType::data) {
+                    return;
+                }
+                // The same frame again, with nothing to say it arrived.
+                if (msg.sequenceNo == unacknowledged) {
+                    anomalies.append(
+                                {TraceAnomaly::Kind::retransmission, i, 0});
+                }
+                unacknowledged = msg.sequenceNo;
+            });
+            awaitingSince = record.timestamp;
+            continue;
+        }
+        if (!decoder.isIdle()
+                && record.timestamp - lastReceived > frameTimeout) {
+            anomalies.append({TraceAnomaly::Kind::stalledFrame, i,
+                              record.timestamp - lastReceived});
+        }
+        if (awaitingSince >= 0
+                && record.timestamp - awaitingSince > responseTimeout) {
+            anomalies.append({TraceAnomaly::Kind::slowResponse, i,
+                              record.timestamp - awaitingSince});
+        }
+        awaitingSince = -1;
+        lastReceived = record.timestamp;
+        decodeFrames(decoder, record.data, [&](const Message &msg) {
+            if (msg.type == PacketType::acknowledge
+                    && msg.sequenceNo == unacknowledged) {
+                unacknowledged = -1;
+            }
+        });
+    }
+    return anomalies;
+}
+}
@@ -0,0 +1,100 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QIODevice>
+#include <QVector>
+
+namespace CommsLink {
+
+/// \brief The direction of traffic in a wire trace.
+enum struct TraceDirection : quint8 {
+    received = 0, //!< Read from the port
+    sent = 1      //!< Written to the port
+};
+
+/// \brief One read from, or write to, the port.
+struct TraceRecord {
+    TraceDirection direction = TraceDirection::received;
+    /// \brief Microseconds since the trace started.
+    qint64 timestamp = 0;
+    QByteArray data;
+};
+
+/// \brief Something odd about the timing of a trace.
+struct TraceAnomaly {
+    enum struct Kind : quint8 {
+        stalledFrame,   //!< A received frame stopped mid-way for too long
+        slowResponse,   //!< The device took too long to answer a frame
+        retransmission  //!< A data frame was resent without an ACK
+    };
+    Kind kind;
+    /// \brief The index of the record at which the anomaly was noticed.
+    int record;
+    /// \brief The delay involved, in microseconds; 0 for retransmissions.
+    qint64 delay;
+};
+
+/// \brief Writes a compact binary trace of a link's traffic.
+///
+/// A trace is the magic bytes "P2NT" and a version byte, followed by a
+/// record for each read or write: the microseconds since the previous
+/// record and then (length << 1 | direction), both as unsigned LEB128,
+/// then the bytes themselves.
+class WireTraceWriter
+{
+public:
+    /// \brief Write a trace to \p out, which must be open for writing.
+    explicit WireTraceWriter(QIODevice &out);
+    /// \brief Write the trace header and start the clock.
+    /// \return false if the header couldn't be written.
+    bool start();
+    /// \brief Record traffic; timestamped from the monotonic clock.
+    void record(TraceDirection direction, const char *data, qint64 size);
+    /// \brief Record traffic with an explicit timestamp, in microseconds
+    /// since the trace started; timestamps must not go backwards.
+    void record(TraceDirection direction, qint64 timestamp,
+                const char *data, qint64 size);
+private:
+    QIODevice &out;
+    QElapsedTimer clock;
+    /// \brief The timestamp of the last record written.
+    qint64 lastTimestamp = 0;
+};
+
+/// \brief Reads a trace written by WireTraceWriter.
+class WireTraceReader
+{
+public:
+    /// \brief Read a trace from \p in, which must be open for reading.
+    explicit WireTraceReader(QIODevice &in);
+    /// \brief Read and check the trace header.
+    bool start();
+    /// \brief Read the next record.
+    /// \return false at the end of the trace or if it's corrupt; see
+    /// isCorrupt().
+    bool next(TraceRecord &record);
+    /// \brief Return true iff reading stopped at something that isn't a
+    /// valid record.
+    bool isCorrupt() const { return corrupt; }
+    /// \brief Read every remaining record.
+    QVector<TraceRecord> readAll();
+private:
+    bool readVarint(quint64 &value);
+    QIODevice &in;
+    qint64 lastTimestamp = 0;
+    bool corrupt = false;
+};
+
+/// \brief Look for timing problems in a trace.
+/// \param records The trace.
+/// \param frameTimeout The longest gap expected within a received frame.
+/// \param responseTimeout The longest the device is expected to take to
+/// start answering a frame.
+QVector<TraceAnomaly> findTraceAnomalies(
+        const QVector<TraceRecord> &records,
+        qint64 frameTimeout = 250000, qint64 responseTimeout = 1000000);
+}
@@ -0,0 +1,42 @@
+QT += testlib
+QT += core serialport
+QT -= gui
+
+CONFIG += qt warn_on depend_includepath c++17
+
+# Benchmarks should measure the code, not the logging.
+DEFINES += QT_NO_DEBUG_OUTPUT
+
+TEMPLATE = app
+TARGET = Psi2NixBench
+
+include(../psi2nix-src.pri)
+APPPATH=../Psi2Nix
+TESTPATH=../Psi2NixTest
+INCLUDEPATH += $$APPPATH $$TESTPATH
+DEPENDPATH += $$APPPATH $$TESTPATH
+
+SOURCES +=  \
+    $$TESTPATH/mockserial.cpp \
+    $$TESTPATH/simulatedorganiser.cpp \
+    $$TESTPATH/tracereplayer.cpp \
+    allocationcounter.cpp \
+    benchcrc16.cpp \
+    benchlink.cpp \
+    benchrecordconverter.cpp \
+    benchreplay.cpp \
+    benchsyncindex.cpp \
+    benchtransfer.cpp \
+    main.cpp
+
+HEADERS += \
+    $$TESTPATH/mockserial.hpp \
+    $$TESTPATH/simulatedorganiser.hpp \
+    $$TESTPATH/tracereplayer.hpp \
+    allocationcounter.hpp \
+    benchcrc16.hpp \
+    benchlink.hpp \
+    benchrecordconverter.hpp \
+    benchreplay.hpp \
+    benchsyncindex.hpp \
+    benchtransfer.hpp
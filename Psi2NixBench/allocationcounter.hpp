@@ -0,0 +1,14 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QtGlobal>
+
+namespace Bench {
+/// \brief Return the number of heap allocations made by this process so far.
+///
+/// On glibc this counts every malloc, calloc and realloc, including those
+/// made by Qt's containers; elsewhere only operator new is counted.
+quint64 allocationCount();
+}
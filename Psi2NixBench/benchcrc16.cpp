@@ -0,0 +1,75 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QElapsedTimer>
+#include <QtTest>
+
+#include "crc16.hpp"
+
+#include "benchcrc16.hpp"
+
+using namespace CommsLink;
+
+namespace {
+using Crc16Function = quint16 (*)(quint16, const char *, qint64);
+
+// The original implementation: one crc16table lookup per byte.
+quint16 crc16Reference(quint16 checksum, const char *data, qint64 size) {
+    for (qint64 i = 0; i < size; i++) {
+        checksum = crc16Update(checksum, static_cast<quint8>(data[i]));
+    }
+    return checksum;
+}
+
+// How long to run each variant for.
+constexpr qint64 RUN_TIME_MS = 250;
+// Keeps results live so that the measured loops can't be discarded.
+volatile quint16 sink;
+}
+
+Q_DECLARE_METATYPE(Crc16Function)
+
+void BenchCrc16::throughput_data() {
+    QTest::addColumn<Crc16Function>("function");
+    QTest::addColumn<int>("size");
+    const std::pair<const char *, Crc16Function> variants[]{
+        {"reference", crc16Reference},
+        {"bytewise", crc16Bytewise},
+        {"sliced", crc16Sliced},
+        {"clmul", crc16Clmul},
+        {"dispatched", crc16}
+    };
+    for (const auto &variant : variants) {
+        for (int size : {16, 64, 0x200, 0x10000}) {
+            QTest::newRow(qPrintable(QString("%1/%2")
+                                     .arg(variant.first).arg(size)))
+                    << variant.second << size;
+        }
+    }
+}
+
+void BenchCrc16::throughput() {
+    QFETCH(Crc16Function, function);
+    QFETCH(int, size);
+    QByteArray data(size, '\0');
+    for (int i = 0; i < size; i++) {
+        data[i] = static_cast<char>((i * 0x9d) & 0xff);
+    }
+    // Every variant must agree with the table it replaces.
+    QCOMPARE(function(0x1234, data.constData(), size),
+             crc16Reference(0x1234, data.constData(), size));
+
+    quint16 checksum = 0;
+    qint64 bytes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    do {
+        for (int i = 0; i < 64; i++) {
+            checksum = function(checksum, data.constData(), size);
+        }
+        bytes += qint64{64} * size;
+    } while (timer.elapsed() < RUN_TIME_MS);
+    const auto elapsed = timer.nsecsElapsed();
+    sink = checksum;
+    QTest::setBenchmarkResult(bytes * 1e9 / elapsed, QTest::BytesPerSecond);
+}
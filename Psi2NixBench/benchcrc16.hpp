@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QObject>
+
+class BenchCrc16 : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void throughput_data();
+    void throughput();
+};
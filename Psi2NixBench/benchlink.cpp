@@ -0,0 +1,213 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QtTest>
+
+#include "frameencoder.hpp"
+#include "link.hpp"
+#include "mockserial.hpp"
+
+#include "allocationcounter.hpp"
+#include "benchlink.hpp"
+
+using namespace CommsLink;
+
+namespace {
+// How long to run each microbenchmark for.
+constexpr qint64 RUN_TIME_MS = 250;
+// Number of frames sent around the loopback.
+constexpr int LOOPBACK_FRAMES = 2000;
+// Frames decoded per call to parseMessage.
+constexpr int FRAMES_PER_READ = 16;
+
+enum struct Metric {
+    frames,
+    bytes,
+    allocations
+};
+
+// Build a payload in which roughly percent% of the bytes are 0x10.
+QByteArray makePayload(int size, int percent) {
+    QByteArray payload(size, '\0');
+    for (int i = 0; i < size; i++) {
+        payload[i] = ((i * 37) % 100 < percent)
+                ? char{0x10} : static_cast<char>('A' + i % 26);
+    }
+    return payload;
+}
+
+// Add a row per payload size and 0x10 density, skipping those whose
+// escaped frame wouldn't fit in MAX_MSG_SIZE.
+void addPayloadRows() {
+    QTest::addColumn<QByteArray>("payload");
+    for (int size : {0x000, 0x020, 0x080, 0x100, 0x1f0}) {
+        for (int percent : {0, 10, 50, 100}) {
+            auto payload = makePayload(size, percent);
+            FrameEncoder encoder;
+            if (!encoder.encode(PacketType::data, 0, payload.constData(),
+                                payload.size())) {
+                continue;
+            }
+            QTest::newRow(qPrintable(QString("%1 bytes/%2% 0x10")
+                                     .arg(size).arg(percent)))
+                    << payload;
+        }
+    }
+}
+
+volatile qint64 sink;
+}
+
+void BenchLink::encode_data() {
+    addPayloadRows();
+}
+
+void BenchLink::encode() {
+    QFETCH(QByteArray, payload);
+    FrameEncoder encoder;
+    qint64 frames = 0;
+    QElapsedTimer timer;
+    timer.start();
+    do {
+        for (int i = 0; i < 64; i++) {
+            encoder.encode(PacketType::data, static_cast<quint8>(i),
+                           payload.constData(), payload.size());
+        }
+        frames += 64;
+    } while (timer.elapsed() < RUN_TIME_MS);
+    const auto elapsed = timer.nsecsElapsed();
+    sink = encoder.size();
+    QTest::setBenchmarkResult(frames * 1e9 / elapsed,
+                              QTest::FramesPerSecond);
+}
+
+void BenchLink::parseMessage_data() {
+    addPayloadRows();
+}
+
+void BenchLink::parseMessage() {
+    QFETCH(QByteArray, payload);
+    FrameEncoder encoder;
+    QByteArray wire;
+    for (int i = 0; i < FRAMES_PER_READ; i++) {
+        encoder.encode(PacketType::data, static_cast<quint8>(i),
+                       payload.constData(), payload.size());
+        wire.append(encoder.data(), static_cast<int>(encoder.size()));
+    }
+    Link link;
+    qint64 frames = 0;
+    connect(&link, &Link::packetReceived, [&](const MessageRef &) { frames++; });
+    QElapsedTimer timer;
+    timer.start();
+    do {
+        for (int i = 0; i < 16; i++) {
+            link.readBuf = wire;
+            link.parseMessage();
+        }
+    } while (timer.elapsed() < RUN_TIME_MS);
+    const auto elapsed = timer.nsecsElapsed();
+    QVERIFY(frames > 0);
+    QCOMPARE(frames % FRAMES_PER_READ, qint64{0});
+    QTest::setBenchmarkResult(frames * 1e9 / elapsed,
+                              QTest::FramesPerSecond);
+}
+
+void BenchLink::receiveAllocations_data() {
+    addPayloadRows();
+}
+
+void BenchLink::receiveAllocations() {
+    QFETCH(QByteArray, payload);
+    FrameEncoder encoder;
+    QByteArray wire;
+    for (int i = 0; i < FRAMES_PER_READ; i++) {
+        encoder.encode(PacketType::data, static_cast<quint8>(i),
+                       payload.constData(), payload.size());
+        wire.append(encoder.data(), static_cast<int>(encoder.size()));
+    }
+    Link link;
+    qint64 frames = 0;
+    connect(&link, &Link::packetReceived, [&](const MessageRef &) { frames++; });
+    // Copy into the link's buffer as readyRead does, rather than sharing
+    // wire's; the first pass warms the buffers up.
+    const auto feed = [&] {
+        link.readBuf.append(wire);
+        link.parseMessage();
+    };
+    feed();
+    const auto framesBefore = frames;
+    const auto allocationsBefore = Bench::allocationCount();
+    for (int i = 0; i < 64; i++) {
+        feed();
+    }
+    const auto allocations = Bench::allocationCount() - allocationsBefore;
+    QCOMPARE(frames - framesBefore, qint64{64 * FRAMES_PER_READ});
+    QTest::setBenchmarkResult(static_cast<qreal>(allocations)
+                              / (frames - framesBefore), QTest::Events);
+}
+
+void BenchLink::loopback_data() {
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("metric");
+    for (int size : {0x000, 0x040, 0x100, 0x1f0}) {
+        QTest::newRow(qPrintable(QString("%1 bytes/frames").arg(size)))
+                << size << static_cast<int>(Metric::frames);
+        QTest::newRow(qPrintable(QString("%1 bytes/bytes").arg(size)))
+                << size << static_cast<int>(Metric::bytes);
+        QTest::newRow(qPrintable(QString("%1 bytes/allocations").arg(size)))
+                << size << static_cast<int>(Metric::allocations);
+    }
+}
+
+void BenchLink::loopback() {
+    QFETCH(int, size);
+    QFETCH(int, metric);
+    // Each frame written to the mock port is fed straight back in; the
+    // next frame is sent as soon as the previous one has been received.
+    MockSerial port;
+    Link link;
+    link.setPort(port);
+    const Message msg{PacketType::data, makePayload(size, 10)};
+    int received = 0;
+    QEventLoop loop;
+    connect(&port, &QIODevice::bytesWritten, [&](qint64) {
+        port.sendData(port.sendBuf.buffer());
+        port.sendBuf.buffer().resize(0);
+        port.sendBuf.seek(0);
+    });
+    connect(&link, &Link::packetReceived, [&](const MessageRef &) {
+        if (++received == LOOPBACK_FRAMES) {
+            loop.quit();
+        } else {
+            link.send(msg);
+        }
+    });
+    QTimer::singleShot(60000, &loop, &QEventLoop::quit);
+
+    QElapsedTimer timer;
+    timer.start();
+    const auto allocationsBefore = Bench::allocationCount();
+    QVERIFY(link.send(msg));
+    loop.exec();
+    const auto allocations = Bench::allocationCount() - allocationsBefore;
+    const auto elapsed = timer.nsecsElapsed();
+    QCOMPARE(received, LOOPBACK_FRAMES);
+
+    switch (static_cast<Metric>(metric)) {
+    case Metric::frames:
+        QTest::setBenchmarkResult(received * 1e9 / elapsed,
+                                  QTest::FramesPerSecond);
+        break;
+    case Metric::bytes:
+        QTest::setBenchmarkResult(qint64{received} * size * 1e9 / elapsed,
+                                  QTest::BytesPerSecond);
+        break;
+    case Metric::allocations:
+        // Includes the mock port's own buffer handling.
+        QTest::setBenchmarkResult(static_cast<qreal>(allocations) / received,
+                                  QTest::Events);
+        break;
+    }
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <QObject>
+
+class BenchLink : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void encode_data();
+    void encode();
+    void parseMessage_data();
+    void parseMessage();
+    void receiveAllocations_data();
+    void receiveAllocations();
+    void loopback_data();
+    void loopback();
+};
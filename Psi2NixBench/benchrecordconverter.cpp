@@ -0,0 +1,46 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QElapsedTimer>
+#include <QtTest>
+
+#include "recordconverter.hpp"
+#include "recordstream.hpp"
+
+#include "benchrecordconverter.hpp"
+
+using namespace CommsLink;
+
+namespace {
+// How long to run each case for.
+constexpr qint64 RUN_TIME_MS = 250;
+}
+
+void BenchRecordConverter::convert_data() {
+    QTest::addColumn<int>("lineLength");
+    for (int lineLength : {8, 40, 200}) {
+        QTest::newRow(qPrintable(QString("%1-byte lines").arg(lineLength)))
+                << lineLength;
+    }
+}
+
+void BenchRecordConverter::convert() {
+    QFETCH(int, lineLength);
+    QByteArray text;
+    while (text.size() < RecordStream::CHUNK_SIZE) {
+        text.append(QByteArray(lineLength, 'x')).append("\r\n");
+    }
+    RecordConverter converter;
+    QVector<Record> records;
+    qint64 bytes = 0;
+    QElapsedTimer timer;
+    timer.start();
+    do {
+        records.clear();
+        converter.convert(text.constData(), text.size(), records);
+        bytes += text.size();
+    } while (timer.elapsed() < RUN_TIME_MS);
+    const auto elapsed = timer.nsecsElapsed();
+    QVERIFY(!records.isEmpty());
+    QTest::setBenchmarkResult(bytes * 1e9 / elapsed, QTest::BytesPerSecond);
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QObject>
+
+class BenchRecordConverter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void convert_data();
+    void convert();
+};
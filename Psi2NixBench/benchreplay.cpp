@@ -0,0 +1,81 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QFile>
+#include <QtTest>
+
+#include "frameencoder.hpp"
+#include "link.hpp"
+#include "mockserial.hpp"
+#include "tracereplayer.hpp"
+#include "wiretrace.hpp"
+
+#include "benchreplay.hpp"
+
+using namespace CommsLink;
+
+namespace {
+// Frames in the synthetic trace used when none is given.
+constexpr int SYNTHETIC_FRAMES = 2000;
+
+// A trace of full-sized data frames, each answering an acknowledgement.
+QVector<TraceRecord> syntheticTrace() {
+    QVector<TraceRecord> records;
+    FrameEncoder encoder;
+    for (int i = 0; i < SYNTHETIC_FRAMES; i++) {
+        const auto seq = static_cast<quint8>(i % 8);
+        encoder.encode(PacketType::acknowledge, seq, nullptr, 0);
+        records.append({TraceDirection::sent, i * 1000LL,
+                        QByteArray(encoder.data(),
+                                   static_cast<int>(encoder.size()))});
+        const QByteArray payload(0x1f0, static_cast<char>('A' + i % 26));
+        encoder.encode(PacketType::data, seq, payload.constData(),
+                       payload.size());
+        records.append({TraceDirection::received, i * 1000LL + 500,
+                        QByteArray(encoder.data(),
+                                   static_cast<int>(encoder.size()))});
+    }
+    return records;
+}
+}
+
+void BenchReplay::replay_data() {
+    QTest::addColumn<bool>("bytes");
+    QTest::newRow("frames") << false;
+    QTest::newRow("bytes") << true;
+}
+
+void BenchReplay::replay() {
+    QFETCH(bool, bytes);
+    // Replay a captured trace if we're given one, so that regressions can be
+    // measured against real traffic.
+    QVector<TraceRecord> records;
+    const auto tracePath = qEnvironmentVariable("PSI2NIX_TRACE");
+    if (tracePath.isEmpty()) {
+        records = syntheticTrace();
+    } else {
+        QFile file(tracePath);
+        QVERIFY2(file.open(QIODevice::ReadOnly),
+                 qPrintable(file.errorString()));
+        WireTraceReader reader(file);
+        QVERIFY(reader.start());
+        records = reader.readAll();
+        QVERIFY(!reader.isCorrupt());
+    }
+    MockSerial port;
+    Link link;
+    link.setPort(port);
+    TraceReplayer replayer(port, link);
+    const auto report = replayer.replay(records);
+    QVERIFY(report.frames > 0);
+    if (!report.anomalies.isEmpty()) {
+        qWarning() << report.anomalies.size() << "timing anomalies in trace";
+    }
+    if (bytes) {
+        QTest::setBenchmarkResult(report.bytesPerSecond(),
+                                  QTest::BytesPerSecond);
+    } else {
+        QTest::setBenchmarkResult(report.framesPerSecond(),
+                                  QTest::FramesPerSecond);
+    }
+}
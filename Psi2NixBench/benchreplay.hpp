@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QObject>
+
+class BenchReplay : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void replay_data();
+    void replay();
+};
@@ -0,0 +1,53 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include <QtTest>
+
+#include "syncindex.hpp"
+
+#include "benchsyncindex.hpp"
+
+using namespace CommsLink;
+
+namespace {
+// Comfortably more than fits on any datapak.
+constexpr int FILE_COUNT = 256;
+constexpr int FILE_SIZE = 64 * 1024;
+}
+
+void BenchSyncIndex::refresh_data() {
+    QTest::addColumn<bool>("warm");
+    QTest::newRow("cold") << false;
+    QTest::newRow("warm") << true;
+}
+
+void BenchSyncIndex::refresh() {
+    QFETCH(bool, warm);
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    QVector<SyncFile> files;
+    QByteArray contents(FILE_SIZE, '\0');
+    for (int i = 0; i < FILE_COUNT; i++) {
+        contents[0] = static_cast<char>(i);
+        const auto path = dir.filePath(QString::number(i));
+        QFile file(path);
+        QVERIFY(file.open(QIODevice::WriteOnly));
+        QVERIFY(file.write(contents) == FILE_SIZE);
+        files.append({path, QByteArray::number(i), {}, 0, 0});
+    }
+    SyncIndex index(dir.filePath("index.json"));
+    if (warm) {
+        // Every hash is already known; only the files' sizes and times
+        // need checking.
+        index.refresh(files);
+    }
+    QElapsedTimer timer;
+    timer.start();
+    index.refresh(files);
+    const auto elapsed = timer.nsecsElapsed();
+    QCOMPARE(index.lastHashed(), warm ? 0 : FILE_COUNT);
+    QTest::setBenchmarkResult(FILE_COUNT * 1e9 / elapsed,
+                              QTest::Events);
+}
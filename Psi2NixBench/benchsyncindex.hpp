@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QObject>
+
+class BenchSyncIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void refresh_data();
+    void refresh();
+};
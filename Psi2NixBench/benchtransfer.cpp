@@ -0,0 +1,81 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QSignalSpy>
+#include <QTemporaryFile>
+#include <QtTest>
+
+#include "clock.hpp"
+#include "filetransfer.hpp"
+#include "link.hpp"
+#include "protocol.hpp"
+#include "simulatedorganiser.hpp"
+
+#include "benchtransfer.hpp"
+
+using namespace CommsLink;
+
+void BenchTransfer::sendFile_data() {
+    QTest::addColumn<int>("size");
+    QTest::addColumn<int>("baudRate");
+    QTest::addColumn<int>("turnaroundUs");
+    QTest::addColumn<double>("bitErrorRate");
+    // Unpaced, this measures the host's own overhead in real time; paced,
+    // it runs on a virtual clock and measures what a protocol change would
+    // mean for real transfer times, without waiting for them.
+    QTest::newRow("unpaced/64 KiB") << 64 * 1024 << 0 << 0 << 0.0;
+    QTest::newRow("115200 baud/256 KiB")
+            << 256 * 1024 << 115200 << 2000 << 0.0;
+    QTest::newRow("9600 baud/256 KiB") << 256 * 1024 << 9600 << 5000 << 0.0;
+    QTest::newRow("9600 baud/256 KiB/BER 1e-5")
+            << 256 * 1024 << 9600 << 5000 << 1e-5;
+}
+
+void BenchTransfer::sendFile() {
+    QFETCH(int, size);
+    QFETCH(int, baudRate);
+    QFETCH(int, turnaroundUs);
+    QFETCH(double, bitErrorRate);
+    QTemporaryFile source;
+    QVERIFY(source.open());
+    QByteArray contents(size, '\0');
+    for (int i = 0; i < size; i++) {
+        contents[i] = static_cast<char>((i * 31) & 0xff);
+    }
+    source.write(contents);
+    source.flush();
+
+    SimulatedOrganiser::Config config;
+    config.baudRate = baudRate;
+    config.turnaround = std::chrono::microseconds{turnaroundUs};
+    config.bitErrorRate = bitErrorRate;
+    config.capacity = size;
+    VirtualClock virtualClock;
+    const bool paced = baudRate != 0;
+    Clock &clock = paced ? static_cast<Clock &>(virtualClock)
+                         : Clock::system();
+    SimulatedOrganiser device(config);
+    device.setClock(clock);
+    Link link;
+    link.setClock(clock);
+    link.setPort(device);
+    Protocol protocol;
+    protocol.setClock(clock);
+    protocol.setLink(link);
+    FileTransfer transfer(protocol);
+    QSignalSpy finished(&transfer, &FileTransfer::finished);
+
+    const auto start = clock.now();
+    QVERIFY(transfer.start(source.fileName(), "BENCH.ODB"));
+    if (paced) {
+        QVERIFY(virtualClock.runUntil([&finished] {
+            return finished.count() > 0;
+        }, std::chrono::hours{1}));
+    } else {
+        QVERIFY(finished.wait(120000));
+    }
+    const auto elapsed = (clock.now() - start).count();
+    QVERIFY(finished.at(0).at(0).toBool());
+    QCOMPARE(device.files().value("BENCH.ODB"), contents);
+    QTest::setBenchmarkResult(size * 1e9 / elapsed, QTest::BytesPerSecond);
+}
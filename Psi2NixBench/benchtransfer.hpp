@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QObject>
+
+class BenchTransfer : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void sendFile_data();
+    void sendFile();
+};
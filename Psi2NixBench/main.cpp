@@ -0,0 +1,59 @@
+#include <QCoreApplication>
+#include <QTest>
+
+// Benchmark fixture includes
+#include "benchcrc16.hpp"
+#include "benchlink.hpp"
+#include "benchrecordconverter.hpp"
+#include "benchreplay.hpp"
+#include "benchsyncindex.hpp"
+#include "benchtransfer.hpp"
+
+namespace {
+// Return arguments with each file given to "-o" renamed for fixture, since
+// each fixture would otherwise overwrite the one before's results:
+// "-o results.xml,xml" writes results-BenchCrc16.xml and so on.
+QStringList argumentsFor(const QStringList &arguments,
+                         const QObject &fixture)
+{
+    const auto suffix = QString("-") + fixture.metaObject()->className();
+    auto result = arguments;
+    for (int i = 1; i + 1 < result.size(); ++i) {
+        if (result.at(i) != "-o") {
+            continue;
+        }
+        auto &output = result[++i];
+        const auto comma = output.lastIndexOf(',');
+        auto file = comma >= 0 ? output.left(comma) : output;
+        if (file == "-") {
+            // Standard output is shared anyway.
+            continue;
+        }
+        auto dot = file.lastIndexOf('.');
+        if (dot <= file.lastIndexOf('/')) {
+            dot = file.size();
+        }
+        file.insert(dot, suffix);
+        output = comma >= 0 ? file + output.mid(comma) : file;
+    }
+    return result;
+}
+}
+
+int main(int argc, char **argv)
+{
+    // As in Psi2NixTest, QTEST_MAIN with multi-fixture support. Pass
+    // e.g. "-o results.xml,xml" or "-csv" for machine-readable results.
+    QCoreApplication app(argc, argv);
+    const auto arguments = app.arguments();
+    const auto exec = [&arguments](QObject *fixture) {
+        return QTest::qExec(fixture, argumentsFor(arguments, *fixture));
+    };
+    auto result = exec(new BenchCrc16);
+    result |= exec(new BenchLink);
+    result |= exec(new BenchRecordConverter);
+    result |= exec(new BenchReplay);
+    result |= exec(new BenchSyncIndex);
+    result |= exec(new BenchTransfer);
+    return result;
+}
@@ -0,0 +1,30 @@
+# A headless front end for scripted transfers; it doesn't load QtGui or
+# QtWidgets, so it starts quickly.
+QT = core serialport
+
+CONFIG += console c++17
+CONFIG -= app_bundle
+CONFIG(release, debug|release):DEFINES += QT_NO_DEBUG_OUTPUT
+
+TARGET = psi2nix-cli
+TEMPLATE = app
+
+DEFINES += QT_DEPRECATED_WARNINGS
+
+include(../psi2nix-src.pri)
+APPPATH=../Psi2Nix
+INCLUDEPATH += $$APPPATH
+DEPENDPATH += $$APPPATH
+
+SOURCES += \
+    batch.cpp \
+    fleet.cpp \
+    main.cpp
+
+HEADERS += \
+    batch.hpp \
+    fleet.hpp
+
+qnx: target.path = /tmp/$${TARGET}/bin
+else: unix:!android: target.path = /opt/Psi2Nix/bin
+!isEmpty(target.path): INSTALLS += target
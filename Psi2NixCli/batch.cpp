@@ -0,0 +1,193 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "batch.hpp"
+
+#include <QFileInfo>
+
+#include <cstdio>
+
+#include "baudprober.hpp"
+
+using namespace CommsLink;
+
+namespace {
+
+/// \brief Format a throughput for the report.
+QString rate(qint64 bytes, qint64 nsecs) {
+    const double seconds = nsecs / 1e9;
+    return QString("%1 bytes in %2 s (%3 bytes/s)")
+            .arg(bytes)
+            .arg(seconds, 0, 'f', 2)
+            .arg(seconds > 0 ? bytes / seconds : 0.0, 0, 'f', 0);
+}
+}
+
+Batch::Batch(QList<BatchItem> someItems,
+             std::chrono::milliseconds connectTimeout, QObject *parent) :
+    QObject(parent), items(std::move(someItems)),
+    out(stdout), err(stderr)
+{
+    connectTimer.setSingleShot(true);
+    connectTimer.setInterval(connectTimeout);
+    connect(&connectTimer, &QTimer::timeout, this, [this] {
+        err << "No answer from the device" << Qt::endl;
+        finish(exitNoDevice);
+    });
+    idleTimer.setSingleShot(true);
+    idleTimer.setInterval(connectTimeout);
+    connect(&idleTimer, &QTimer::timeout, this, [this] {
+        out << "No more files from the device" << Qt::endl;
+        finishIfIdle();
+    });
+    connect(&protocol, &Protocol::connectionChanged,
+            this, [this](bool connected) {
+        if (connected && current < 0) {
+            connectTimer.stop();
+            batchTimer.start();
+            sendNext();
+        } else if (!connected && receiver != nullptr
+                   && current >= items.size()) {
+            finishIfIdle();
+        }
+    });
+}
+
+void Batch::setReceiveDirectory(const QString &directory) {
+    Q_ASSERT(receiver == nullptr);
+    receiver = new FileReceiver(protocol, directory, this);
+    connect(receiver, &FileReceiver::fileStarted,
+            this, [this](const QByteArray &remoteName) {
+        idleTimer.stop();
+        receiveTimer.start();
+        out << "Receiving " << remoteName << Qt::endl;
+    });
+    connect(receiver, &FileReceiver::fileReceived,
+            this, &Batch::fileReceived);
+}
+
+bool Batch::start(const QString &portName, qint32 baudRate) {
+    port.setPortName(portName);
+    if (baudRate != 0) {
+        port.setBaudRate(baudRate);
+    }
+    link.setPort(port);
+    if (!port.isOpen()) {
+        err << "Unable to open " << portName << ": " << port.errorString()
+            << Qt::endl;
+        return false;
+    }
+    connectTimer.start();
+    if (baudRate != 0) {
+        protocol.setLink(link);
+        return true;
+    }
+    auto prober = new BaudProber(link, [this](qint32 rate) {
+        return port.setBaudRate(rate);
+    }, this);
+    connect(prober, &BaudProber::finished, this, [this, prober](qint32 rate) {
+        prober->deleteLater();
+        if (rate == 0) {
+            err << "No baud rate works reliably" << Qt::endl;
+            finish(exitNoDevice);
+            return;
+        }
+        out << "Using " << rate << " baud" << Qt::endl;
+        protocol.setLink(link);
+    });
+    prober->start(BaudProber::supportedRates());
+    return true;
+}
+
+void Batch::sendNext() {
+    while (++current < items.size()) {
+        const auto &item = items.at(current);
+        transfer = new FileTransfer(protocol, this);
+        connect(transfer, &FileTransfer::finished,
+                this, &Batch::fileFinished);
+        fileTimer.start();
+        if (transfer->start(item.path, item.remoteName, item.conversion)) {
+            return;
+        }
+        err << item.path << ": unable to open" << Qt::endl;
+        failures++;
+        delete transfer;
+        transfer = nullptr;
+    }
+    if (receiver != nullptr) {
+        // Leave the device to send what it will.
+        if (!receiver->isReceiving()) {
+            idleTimer.start();
+        }
+        return;
+    }
+    const auto elapsed = batchTimer.nsecsElapsed();
+    out << "Total: " << (items.size() - failures) << " of " << items.size()
+        << " file(s), " << rate(batchBytes, elapsed) << Qt::endl;
+    finish(failures == 0 ? exitSuccess : exitTransferFailed);
+}
+
+void Batch::fileFinished(bool success) {
+    const auto elapsed = fileTimer.nsecsElapsed();
+    const auto &item = items.at(current);
+    if (success) {
+        batchBytes += transfer->bytesSent();
+        out << item.path << ": " << rate(transfer->bytesSent(), elapsed)
+            << Qt::endl;
+        emit fileSent(current);
+    } else {
+        failures++;
+        err << item.path << ": failed after "
+            << transfer->bytesSent() << " bytes" << Qt::endl;
+    }
+    // We're inside one of the transfer's signals.
+    transfer->deleteLater();
+    transfer = nullptr;
+    sendNext();
+}
+
+void Batch::fileReceived(const QString &path, bool success) {
+    received++;
+    if (success) {
+        const auto size = QFileInfo(path).size();
+        batchBytes += size;
+        out << path << ": received "
+            << rate(size, receiveTimer.nsecsElapsed()) << Qt::endl;
+    } else {
+        failures++;
+        err << path << ": not received" << Qt::endl;
+    }
+    if (current < items.size() || receiver->isReceiving()) {
+        return;
+    }
+    if (protocol.isConnected()) {
+        idleTimer.start();
+    } else {
+        finishIfIdle();
+    }
+}
+
+void Batch::finishIfIdle() {
+    if (receiver->isReceiving()) {
+        // The device will carry on, or the link will give up.
+        return;
+    }
+    idleTimer.stop();
+    const auto elapsed = batchTimer.nsecsElapsed();
+    out << "Total: " << (items.size() + received - failures) << " of "
+        << (items.size() + received) << " file(s) sent or received, "
+        << rate(batchBytes, elapsed) << Qt::endl;
+    finish(failures == 0 ? exitSuccess : exitTransferFailed);
+}
+
+void Batch::finish(int exitStatus) {
+    connectTimer.stop();
+    if (!protocol.isConnected()) {
+        emit finished(exitStatus);
+        return;
+    }
+    // Tell the device we're done, so that it needn't wait to find out.
+    protocol.disconnectDevice([this, exitStatus](bool) {
+        emit finished(exitStatus);
+    });
+}
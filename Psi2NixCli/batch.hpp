@@ -0,0 +1,100 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QObject>
+#include <QSerialPort>
+#include <QTextStream>
+#include <QTimer>
+
+#include <chrono>
+
+#include "filereceiver.hpp"
+#include "filetransfer.hpp"
+#include "link.hpp"
+#include "protocol.hpp"
+
+/// \brief Process exit statuses, for scripts that drive psi2nix-cli.
+enum ExitStatus {
+    exitSuccess = 0,       ///< Every file was sent
+    exitTransferFailed = 1,///< At least one file wasn't sent
+    exitUsage = 2,         ///< Bad command line or manifest
+    exitPortFailed = 3,    ///< The port couldn't be opened
+    exitNoDevice = 4       ///< The device didn't answer in time
+};
+
+/// \brief A file to be sent, and the name to give it on the device.
+struct BatchItem {
+    QString path;
+    QByteArray remoteName;
+    CommsLink::Conversion conversion = CommsLink::Conversion::none;
+};
+
+/// \brief Sends a list of files back to back over one connection, reporting
+/// the throughput of each; can also save the files the device sends.
+class Batch : public QObject
+{
+    Q_OBJECT
+public:
+    /// \param items The files to send, in order.
+    /// \param connectTimeout How long to wait for the device to answer.
+    Batch(QList<BatchItem> items, std::chrono::milliseconds connectTimeout,
+          QObject *parent = nullptr);
+    /// \brief Open the port and start sending once the device answers.
+    /// \param baudRate The rate to use, or 0 to find the fastest that
+    /// works.
+    /// \return false if the port couldn't be opened.
+    bool start(const QString &portName, qint32 baudRate);
+    /// \brief Record the link's traffic to \p trace.
+    void setTrace(CommsLink::WireTraceWriter *trace) { link.setTrace(trace); }
+    /// \brief Save files sent by the device into \p directory, and once
+    /// every item has been sent, carry on until the device disconnects or
+    /// has sent nothing for the connect timeout.
+    void setReceiveDirectory(const QString &directory);
+
+signals:
+    /// \brief Emitted once every file has been dealt with, or the device
+    /// didn't answer.
+    void finished(int exitStatus);
+    /// \brief Emitted when a file has been sent successfully.
+    /// \param index The file's position in the list of items.
+    void fileSent(int index);
+
+private:
+    /// \brief Send the next file, or finish if there are none left.
+    void sendNext();
+    /// \brief Report on the file just sent and move on to the next.
+    void fileFinished(bool success);
+    /// \brief Report on a file received from the device.
+    void fileReceived(const QString &path, bool success);
+    /// \brief Finish once nothing more is being sent or received.
+    void finishIfIdle();
+    void finish(int exitStatus);
+
+    QList<BatchItem> items;
+    int current = -1;
+    int failures = 0;
+    QSerialPort port;
+    CommsLink::Link link;
+    CommsLink::Protocol protocol;
+    CommsLink::FileTransfer *transfer = nullptr;
+    /// \brief Saving files from the device, if they're wanted.
+    CommsLink::FileReceiver *receiver = nullptr;
+    /// \brief The number of files received, successfully or otherwise.
+    int received = 0;
+    QTimer connectTimer;
+    /// \brief Fires when the device has sent nothing for a while.
+    QTimer idleTimer;
+    /// \brief Times the file being received.
+    QElapsedTimer receiveTimer;
+    /// \brief Times the current file.
+    QElapsedTimer fileTimer;
+    /// \brief Times the whole batch, from the device answering.
+    QElapsedTimer batchTimer;
+    qint64 batchBytes = 0;
+    QTextStream out;
+    QTextStream err;
+};
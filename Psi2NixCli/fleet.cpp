@@ -0,0 +1,110 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "fleet.hpp"
+
+#include <cstdio>
+
+using namespace CommsLink;
+
+Fleet::Fleet(QList<BatchItem> someItems,
+             std::chrono::milliseconds connectTimeout, QObject *parent) :
+    QObject(parent), items(std::move(someItems)), out(stdout)
+{
+    connect(&manager, &SessionManager::statusChanged,
+            this, &Fleet::statusChanged);
+    connectTimer.setSingleShot(true);
+    connectTimer.setInterval(connectTimeout);
+    connect(&connectTimer, &QTimer::timeout, this, &Fleet::connectTimedOut);
+}
+
+bool Fleet::start(const QStringList &portNames, qint32 baudRate) {
+    if (portNames.isEmpty()) {
+        manager.openAll(baudRate);
+    } else {
+        for (const auto &portName : portNames) {
+            manager.open(portName, baudRate);
+        }
+    }
+    devicesRemaining = manager.portNames().size();
+    if (devicesRemaining == 0) {
+        QTextStream(stderr) << "No serial ports found" << '\n';
+        return false;
+    }
+    timer.start();
+    for (const auto &portName : manager.portNames()) {
+        progress.insert(portName, Progress{});
+        feed(portName);
+    }
+    connectTimer.start();
+    return true;
+}
+
+void Fleet::feed(const QString &portName) {
+    // A session only takes so many requests at once; the rest are posted
+    // as it gets through them.
+    auto *session = manager.session(portName);
+    auto &port = progress[portName];
+    while (session != nullptr && port.queued < items.size()) {
+        const auto &item = items.at(port.queued);
+        SessionRequest request;
+        request.type = SessionRequest::Type::sendFile;
+        request.path = item.path;
+        request.remoteName = item.remoteName;
+        request.conversion = item.conversion;
+        if (!session->post(request)) {
+            return;
+        }
+        port.queued++;
+    }
+}
+
+void Fleet::connectTimedOut() {
+    QStringList silent;
+    for (auto port = progress.cbegin(); port != progress.cend(); ++port) {
+        if (!port->connected && !port->finished) {
+            silent.append(port.key());
+        }
+    }
+    for (const auto &portName : silent) {
+        auto &port = progress[portName];
+        port.finished = true;
+        QTextStream(stderr) << portName << ": no answer from the device; "
+                            << (items.size() - port.done)
+                            << " file(s) not sent" << '\n';
+        manager.close(portName);
+        portFinished(true);
+    }
+}
+
+void Fleet::portFinished(bool failed) {
+    anyFailed |= failed;
+    if (--devicesRemaining == 0) {
+        connectTimer.stop();
+        emit finished(anyFailed ? exitTransferFailed : exitSuccess);
+    }
+}
+
+void Fleet::statusChanged(const QString &portName, SessionStatus status) {
+    auto &port = progress[portName];
+    if (port.finished) {
+        return;
+    }
+    port.connected |= status.connected;
+    feed(portName);
+    const int done = status.filesSent + status.filesFailed;
+    if (done == port.done) {
+        return;
+    }
+    port.done = done;
+    out << portName << ": " << done << " of " << items.size()
+        << " file(s) done, " << status.filesFailed << " failed" << Qt::endl;
+    if (done < items.size()) {
+        return;
+    }
+    out << portName << ": finished in "
+        << QString::number(timer.nsecsElapsed() / 1e9, 'f', 2) << " s"
+        << Qt::endl;
+    port.finished = true;
+    portFinished(status.filesFailed > 0);
+}
@@ -0,0 +1,67 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QStringList>
+#include <QTextStream>
+#include <QTimer>
+
+#include <chrono>
+
+#include "batch.hpp"
+#include "sessionmanager.hpp"
+
+/// \brief Sends the same files to several devices at once, one session per
+/// port.
+class Fleet : public QObject
+{
+    Q_OBJECT
+public:
+    /// \param items The files to send to each device, in order.
+    /// \param connectTimeout How long to wait for each device to answer;
+    /// the files for any that doesn't are counted as failed.
+    Fleet(QList<BatchItem> items, std::chrono::milliseconds connectTimeout,
+          QObject *parent = nullptr);
+    /// \brief Open the ports and queue the files on each.
+    /// \param portNames The ports to use; if empty, every port there is.
+    /// \return false if there were no ports to use.
+    bool start(const QStringList &portNames, qint32 baudRate);
+
+signals:
+    /// \brief Emitted once every device has been dealt with.
+    void finished(int exitStatus);
+
+private:
+    /// \brief How far one port has got.
+    struct Progress {
+        /// \brief The number of items posted to its session.
+        int queued = 0;
+        /// \brief The number of files it has finished with.
+        int done = 0;
+        bool connected = false;
+        bool finished = false;
+    };
+
+    void statusChanged(const QString &portName,
+                       CommsLink::SessionStatus status);
+    /// \brief Post as many of the remaining items to a port's session as
+    /// it will take.
+    void feed(const QString &portName);
+    /// \brief Give up on the ports whose devices haven't answered.
+    void connectTimedOut();
+    void portFinished(bool failed);
+
+    QList<BatchItem> items;
+    CommsLink::SessionManager manager;
+    QHash<QString, Progress> progress;
+    QTimer connectTimer;
+    int devicesRemaining = 0;
+    bool anyFailed = false;
+    QElapsedTimer timer;
+    QTextStream out;
+};
@@ -0,0 +1,258 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+
+#include <cstdio>
+
+#include "batch.hpp"
+#include "eventtrace.hpp"
+#include "eventtracedumper.hpp"
+#include "fleet.hpp"
+#include "syncindex.hpp"
+#include "wiretrace.hpp"
+
+namespace {
+
+/// \brief The name a file is given on the device if the manifest doesn't
+/// say otherwise.
+QByteArray defaultRemoteName(const QString &path) {
+    return QFileInfo(path).fileName().toUpper().toLatin1();
+}
+
+/// \brief Read a manifest: one file per line, optionally followed by a tab
+/// and the name to give it on the device. Blank lines and lines starting
+/// with # are ignored.
+bool readManifest(const QString &manifestPath, QList<BatchItem> &items) {
+    QFile manifest(manifestPath);
+    if (!manifest.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream(stderr) << "Unable to open " << manifestPath << ": "
+                            << manifest.errorString() << '\n';
+        return false;
+    }
+    QTextStream in(&manifest);
+    QString line;
+    while (in.readLineInto(&line)) {
+        if (line.trimmed().isEmpty() || line.startsWith('#')) {
+            continue;
+        }
+        const auto fields = line.split('\t');
+        BatchItem item{fields.at(0), {}};
+        item.remoteName = fields.size() > 1
+                ? fields.at(1).trimmed().toLatin1()
+                : defaultRemoteName(item.path);
+        items.append(item);
+    }
+    return true;
+}
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("psi2nix-cli");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(
+                "Send files to a Psion Organiser II over a serial port.");
+    parser.addHelpOption();
+    const QCommandLineOption portOption(
+    {"p", "port"}, "Serial port a device is connected to; give more than"
+                   " once to send to several devices at once.", "port");
+    const QCommandLineOption allPortsOption(
+                "all-ports", "Send to a device on every serial port.");
+    const QCommandLineOption baudOption(
+    {"b", "baud"}, "Baud rate, or \"auto\" to use the fastest that works"
+                   " (default 9600).", "rate", "9600");
+    const QCommandLineOption manifestOption(
+    {"m", "manifest"}, "Read the files to send from a manifest.", "file");
+    const QCommandLineOption timeoutOption(
+    {"t", "timeout"}, "Seconds to wait for the device to answer"
+                      " (default 30).", "seconds", "30");
+    const QCommandLineOption traceOption(
+                "trace", "Record the traffic on a single port to a wire trace.",
+                "file");
+    const QCommandLineOption textOption(
+                "text", "Convert the files from host text into records, one"
+                        " per line, as they're sent.");
+    const QCommandLineOption syncOption(
+                "sync", "Only send files that are new or have changed since"
+                        " they were last sent to the device.");
+    const QCommandLineOption deviceOption(
+                "device", "The name the sync index knows the device by"
+                          " (default: the port's name).", "name");
+    const QCommandLineOption syncIndexOption(
+                "sync-index", "The sync index to use (default "
+                + CommsLink::SyncIndex::defaultPath() + ").", "file",
+                CommsLink::SyncIndex::defaultPath());
+    const QCommandLineOption receiveOption(
+                "receive", "Save the files the device sends into a directory,"
+                           " until it disconnects or has sent nothing for"
+                           " the timeout.", "directory");
+    const QCommandLineOption eventLogOption(
+                "event-log", "Write the events recorded during the run to a"
+                             " text file when it finishes.", "file");
+    const QCommandLineOption eventLevelOption(
+                "event-level", "The least severe events to record: debug,"
+                               " info, warning or off (default debug).",
+                "level", "debug");
+    parser.addOptions({portOption, allPortsOption, baudOption, manifestOption,
+                       timeoutOption, traceOption, textOption, syncOption,
+                       deviceOption, syncIndexOption, receiveOption,
+                       eventLogOption, eventLevelOption});
+    parser.addPositionalArgument("files", "Files to send.", "[files...]");
+    parser.process(app);
+
+    QTextStream err(stderr);
+    bool baudOk = false, timeoutOk = false;
+    auto baudRate = parser.value(baudOption).toInt(&baudOk);
+    if (parser.value(baudOption) == "auto") {
+        baudRate = 0;
+        baudOk = true;
+    }
+    const auto timeout = parser.value(timeoutOption).toInt(&timeoutOk);
+    CommsLink::TraceLevel eventLevel;
+    const bool eventLevelOk = CommsLink::EventTrace::levelFromName(
+                parser.value(eventLevelOption), eventLevel);
+    const auto portNames = parser.values(portOption);
+    const bool allPorts = parser.isSet(allPortsOption);
+    const bool portsOk = allPorts ? portNames.isEmpty() : !portNames.isEmpty();
+    if (!portsOk || !baudOk || baudRate < 0
+            || !timeoutOk || timeout <= 0 || !eventLevelOk) {
+        err << parser.helpText();
+        return exitUsage;
+    }
+
+    QList<BatchItem> items;
+    if (parser.isSet(manifestOption)
+            && !readManifest(parser.value(manifestOption), items)) {
+        return exitUsage;
+    }
+    for (const auto &path : parser.positionalArguments()) {
+        items.append({path, defaultRemoteName(path)});
+    }
+    const auto receiveDirectory = parser.value(receiveOption);
+    if (items.isEmpty() && receiveDirectory.isEmpty()) {
+        err << "No files to send" << Qt::endl;
+        return exitUsage;
+    }
+    if (!receiveDirectory.isEmpty() && !QDir(receiveDirectory).exists()) {
+        err << "No such directory " << receiveDirectory << Qt::endl;
+        return exitUsage;
+    }
+    if (parser.isSet(textOption)) {
+        for (auto &item : items) {
+            item.conversion = CommsLink::Conversion::text;
+        }
+    }
+
+    CommsLink::EventTrace::setLevel(eventLevel);
+    // Events are turned into text on the dumper's thread, once the run has
+    // finished.
+    CommsLink::EventTraceDumper dumper;
+    const auto eventLog = parser.value(eventLogOption);
+    const auto finish = [&app, &dumper, &eventLog, &err](int status) {
+        if (eventLog.isEmpty()) {
+            app.exit(status);
+            return;
+        }
+        QObject::connect(&dumper, &CommsLink::EventTraceDumper::dumped, &app,
+                         [&app, &err, status](const QString &path, int,
+                                              bool ok) {
+            if (!ok) {
+                err << "Unable to write " << path << Qt::endl;
+            }
+            app.exit(status);
+        });
+        dumper.dump(eventLog);
+    };
+
+    const bool severalPorts = allPorts || portNames.size() > 1;
+    if (severalPorts && parser.isSet(traceOption)) {
+        err << "--trace can only be used with a single port" << Qt::endl;
+        return exitUsage;
+    }
+    if (severalPorts && parser.isSet(syncOption)) {
+        err << "--sync can only be used with a single port" << Qt::endl;
+        return exitUsage;
+    }
+    if (severalPorts && parser.isSet(receiveOption)) {
+        err << "--receive can only be used with a single port" << Qt::endl;
+        return exitUsage;
+    }
+    if (severalPorts) {
+        // Each device gets its own session, so a slow one doesn't hold up
+        // the rest.
+        Fleet fleet(items, std::chrono::seconds{timeout});
+        QObject::connect(&fleet, &Fleet::finished, &app, finish,
+                         Qt::QueuedConnection);
+        if (!fleet.start(portNames, baudRate)) {
+            return exitPortFailed;
+        }
+        return app.exec();
+    }
+
+    // Decide what needs sending before touching the port.
+    CommsLink::SyncIndex index(parser.value(syncIndexOption));
+    QVector<CommsLink::SyncFile> syncFiles;
+    const auto device = parser.isSet(deviceOption)
+            ? parser.value(deviceOption) : portNames.first();
+    if (parser.isSet(syncOption)) {
+        index.load();
+        for (const auto &item : items) {
+            syncFiles.append({item.path, item.remoteName, {}, 0, 0});
+        }
+        index.refresh(syncFiles);
+        QList<BatchItem> changed;
+        QVector<CommsLink::SyncFile> changedFiles;
+        for (int i = 0; i < items.size(); i++) {
+            if (index.needsSending(device, syncFiles.at(i))) {
+                changed.append(items.at(i));
+                changedFiles.append(syncFiles.at(i));
+            }
+        }
+        QTextStream(stdout) << (items.size() - changed.size()) << " of "
+                            << items.size() << " file(s) unchanged on "
+                            << device << '\n';
+        if (changed.isEmpty() && receiveDirectory.isEmpty()) {
+            return exitSuccess;
+        }
+        items = changed;
+        syncFiles = changedFiles;
+    }
+
+    Batch batch(items, std::chrono::seconds{timeout});
+    if (!receiveDirectory.isEmpty()) {
+        batch.setReceiveDirectory(receiveDirectory);
+    }
+    if (parser.isSet(syncOption)) {
+        // Save as each file arrives, so an interrupted run isn't wasted.
+        QObject::connect(&batch, &Batch::fileSent,
+                         [&index, &syncFiles, &device](int i) {
+            index.recordSent(device, syncFiles.at(i));
+            index.save();
+        });
+    }
+    QFile traceFile;
+    CommsLink::WireTraceWriter trace(traceFile);
+    if (parser.isSet(traceOption)) {
+        traceFile.setFileName(parser.value(traceOption));
+        if (!traceFile.open(QIODevice::WriteOnly) || !trace.start()) {
+            err << "Unable to write " << traceFile.fileName() << ": "
+                << traceFile.errorString() << Qt::endl;
+            return exitUsage;
+        }
+        batch.setTrace(&trace);
+    }
+    QObject::connect(&batch, &Batch::finished, &app, finish,
+                     Qt::QueuedConnection);
+    if (!batch.start(portNames.first(), baudRate)) {
+        return exitPortFailed;
+    }
+    return app.exec();
+}
@@ -13,11 +13,43 @@ DEPENDPATH += $$APPPATH
 
 SOURCES +=  \
     mockserial.cpp \
+    simulatedorganiser.cpp \
     main.cpp \
+    testbaudprober.cpp \
+    testclock.cpp \
+    testcrc16.cpp \
+    testdevicecatalogue.cpp \
+    testeventtrace.cpp \
+    testfilereceiver.cpp \
+    testfiletransfer.cpp \
     testlink.cpp \
-    testprotocol.cpp
+    testportmonitor.cpp \
+    testprotocol.cpp \
+    testrecordconverter.cpp \
+    testsessionmanager.cpp \
+    testsimulatedorganiser.cpp \
+    testspscqueue.cpp \
+    testsyncindex.cpp \
+    testwiretrace.cpp \
+    tracereplayer.cpp
 
 HEADERS += \
     mockserial.hpp \
+    simulatedorganiser.hpp \
+    testbaudprober.hpp \
+    testclock.hpp \
+    testcrc16.hpp \
+    testdevicecatalogue.hpp \
+    testeventtrace.hpp \
+    testfilereceiver.hpp \
+    testfiletransfer.hpp \
     testlink.hpp \
-    testprotocol.hpp
+    testportmonitor.hpp \
+    testprotocol.hpp \
+    testrecordconverter.hpp \
+    testsessionmanager.hpp \
+    testsimulatedorganiser.hpp \
+    testspscqueue.hpp \
+    testsyncindex.hpp \
+    testwiretrace.hpp \
+    tracereplayer.hpp
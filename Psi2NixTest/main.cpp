@@ -2,8 +2,22 @@
 #include <QTest>
 
 // Test fixture includes
+#include "testbaudprober.hpp"
+#include "testclock.hpp"
+#include "testcrc16.hpp"
+#include "testdevicecatalogue.hpp"
+#include "testeventtrace.hpp"
+#include "testfilereceiver.hpp"
+#include "testfiletransfer.hpp"
 #include "testlink.hpp"
+#include "testportmonitor.hpp"
 #include "testprotocol.hpp"
+#include "testrecordconverter.hpp"
+#include "testsessionmanager.hpp"
+#include "testsimulatedorganiser.hpp"
+#include "testspscqueue.hpp"
+#include "testsyncindex.hpp"
+#include "testwiretrace.hpp"
 
 int main(int argc, char **argv)
 {
@@ -16,7 +30,21 @@ int main(int argc, char **argv)
 #else
     QTest::setMainSourcePath(__FILE__);
 #endif
-    auto result = QTest::qExec(new TestLink, argc, argv);
+    auto result = QTest::qExec(new TestCrc16, argc, argv);
+    result |= QTest::qExec(new TestClock, argc, argv);
+    result |= QTest::qExec(new TestBaudProber, argc, argv);
+    result |= QTest::qExec(new TestLink, argc, argv);
     result |= QTest::qExec(new TestProtocol, argc, argv);
+    result |= QTest::qExec(new TestRecordConverter, argc, argv);
+    result |= QTest::qExec(new TestEventTrace, argc, argv);
+    result |= QTest::qExec(new TestDeviceCatalogue, argc, argv);
+    result |= QTest::qExec(new TestFileTransfer, argc, argv);
+    result |= QTest::qExec(new TestFileReceiver, argc, argv);
+    result |= QTest::qExec(new TestSessionManager, argc, argv);
+    result |= QTest::qExec(new TestPortMonitor, argc, argv);
+    result |= QTest::qExec(new TestSimulatedOrganiser, argc, argv);
+    result |= QTest::qExec(new TestSpscQueue, argc, argv);
+    result |= QTest::qExec(new TestSyncIndex, argc, argv);
+    result |= QTest::qExec(new TestWireTrace, argc, argv);
     return result;
 }
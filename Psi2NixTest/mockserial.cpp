@@ -4,7 +4,8 @@
 #include "mockserial.hpp"
 
 #include <cstring>
-#include <QDebug>
+
+#include "eventtrace.hpp"
 
 MockSerial::MockSerial(QObject *parent) : QIODevice(parent)
 {
@@ -17,8 +18,6 @@ MockSerial::MockSerial(QObject *parent) : QIODevice(parent)
 }
 
 qint64 MockSerial::readData(char *data, qint64 maxSize) {
-    qDebug() << "MockSerial::readData called with maxSize"
-             << maxSize;
     if (maxSize == 0) {
         return 0;
     }
@@ -26,10 +25,9 @@ qint64 MockSerial::readData(char *data, qint64 maxSize) {
         return -1;
     }
     recvBuf.seek(0);
-    qDebug() << "recvBuf pos" << recvBuf.pos()
-             << "; available " << recvBuf.bytesAvailable();
     auto actualReadLength = recvBuf.read(data, maxSize);
-    qDebug() << "Actual read length:" << actualReadLength;
+    CommsLink::traceEvent<CommsLink::TraceLevel::debug>(
+                CommsLink::TraceEventId::mockRead, maxSize, actualReadLength);
     // drop the bytes we read
     recvBuf.buffer().remove(0, static_cast<int>(actualReadLength));
     recvBuf.seek(0);
@@ -37,7 +35,38 @@ qint64 MockSerial::readData(char *data, qint64 maxSize) {
 }
 
 qint64 MockSerial::writeData(const char *data, qint64 maxSize) {
-    return sendBuf.write(data, maxSize);
+    const auto written = sendBuf.write(data, maxSize);
+    if (autoAcknowledge) {
+        // What the device actually hears.
+        const char *heard = data;
+        qint64 heardSize = written;
+        QByteArray survivors;
+        if (isLossy()) {
+            survivors = overLine(data, written);
+            heard = survivors.constData();
+            heardSize = survivors.size();
+        }
+        QByteArray acks;
+        qint64 pos = 0;
+        while (pos < heardSize) {
+            pos += ackDecoder.decode(heard + pos, heardSize - pos);
+            if (!ackDecoder.hasMessage()) {
+                continue;
+            }
+            const auto msg = ackDecoder.takeMessage();
+            if (msg.type == CommsLink::PacketType::data
+                    || msg.type == CommsLink::PacketType::linkRequest) {
+                ackEncoder.encode(CommsLink::PacketType::acknowledge,
+                                  msg.sequenceNo, nullptr, 0);
+                acks.append(ackEncoder.data(),
+                            static_cast<int>(ackEncoder.size()));
+            }
+        }
+        if (!acks.isEmpty()) {
+            sendData(acks);
+        }
+    }
+    return written;
 }
 
 void MockSerial::sendData(const QByteArray &data) {
@@ -45,15 +74,28 @@ void MockSerial::sendData(const QByteArray &data) {
 }
 
 void MockSerial::sendData(const char *data, qint64 size) {
-    qDebug() << "sendData called with size" << size;
-    auto bytesWritten = recvBuf.write(data, size);
-    qDebug() << "bytes written:" << bytesWritten
-             << "; pos: " << recvBuf.pos();
+    QByteArray received;
+    if (isLossy()) {
+        received = overLine(data, size);
+        data = received.constData();
+        size = received.size();
+    }
+    const auto bytesWritten = recvBuf.write(data, size);
+    CommsLink::traceEvent<CommsLink::TraceLevel::debug>(
+                CommsLink::TraceEventId::mockReceived, bytesWritten);
     emit readyRead();
-    qDebug() << "readyRead emitted.";
 }
 
 qint64 MockSerial::bytesAvailable() const {
     return recvBuf.bytesAvailable();
 }
 
+QByteArray MockSerial::overLine(const char *data, qint64 size) {
+    QByteArray survivors;
+    for (qint64 i = 0; i < size; i++) {
+        if (++lossCounter % 4 != 0) {
+            survivors.append(data[i]);
+        }
+    }
+    return survivors;
+}
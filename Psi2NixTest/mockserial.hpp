@@ -7,6 +7,9 @@
 #include <QIODevice>
 #include <QObject>
 
+#include "framedecoder.hpp"
+#include "frameencoder.hpp"
+
 /// \brief A mock serial port to be used for testing.
 class MockSerial : public QIODevice
 {
@@ -25,6 +28,14 @@ public:
     void sendData(const char *data, qint64 size);
     /// \brief Return the number of bytes available to read.
     qint64 bytesAvailable() const override;
+    /// \brief If true, acknowledge each link request and data frame
+    /// written to this port, as the device would.
+    void setAutoAcknowledge(bool enable) { autoAcknowledge = enable; }
+    /// \brief Set the rate the port is running at.
+    bool setBaudRate(qint32 rate) { baudRate = rate; return true; }
+    /// \brief Simulate a device that loses bytes in both directions when
+    /// the port runs faster than \p rate; 0 for a perfect line.
+    void setMaxReliableRate(qint32 rate) { maxReliableRate = rate; }
 protected:
     qint64 readData(char *data, qint64 maxSize) override;
     qint64 writeData(const char *data, qint64 maxSize) override;
@@ -32,4 +43,18 @@ protected:
 signals:
     void bytesWritten(qint64 bytes);
     void readyRead();
+
+private:
+    bool autoAcknowledge = false;
+    qint32 baudRate = 9600;
+    qint32 maxReliableRate = 0;
+    /// \brief Bytes seen while the line is lossy; every fourth is dropped.
+    quint64 lossCounter = 0;
+    bool isLossy() const {
+        return maxReliableRate != 0 && baudRate > maxReliableRate;
+    }
+    /// \brief Return data as it survives a lossy line.
+    QByteArray overLine(const char *data, qint64 size);
+    CommsLink::FrameDecoder ackDecoder;
+    CommsLink::FrameEncoder ackEncoder;
 };
@@ -0,0 +1,212 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "simulatedorganiser.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "filetransfer.hpp"
+
+using namespace CommsLink;
+
+namespace {
+// How long the device waits for an acknowledgement before retransmitting.
+constexpr std::chrono::milliseconds RETRANSMIT_TIME{500};
+}
+
+SimulatedOrganiser::SimulatedOrganiser(const Config &aConfig,
+                                       QObject *parent) :
+    QIODevice(parent), config(aConfig), random(aConfig.seed)
+{
+    setClock(*clock);
+}
+
+void SimulatedOrganiser::setClock(Clock &aClock) {
+    clock = &aClock;
+    delete retransmitTimer;
+    retransmitTimer = clock->createTimer(this);
+    connect(retransmitTimer, &ClockTimer::timeout,
+            this, &SimulatedOrganiser::sendOutgoing);
+}
+
+qint64 SimulatedOrganiser::micros() const {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+                clock->now()).count();
+}
+
+void SimulatedOrganiser::transmit(const QByteArray &name,
+                                  const QByteArray &contents) {
+    const bool idle = outgoing.isEmpty();
+    outgoing.enqueue(static_cast<char>(FileOp::open) + name);
+    qint64 pos = 0;
+    while (pos < contents.size()) {
+        const auto length = PayloadPlanner::chunkLength(
+                    contents.constData() + pos, contents.size() - pos,
+                    PayloadPlanner::MAX_BUDGET);
+        outgoing.enqueue(static_cast<char>(FileOp::data)
+                         + contents.mid(static_cast<int>(pos),
+                                        static_cast<int>(length)));
+        pos += length;
+    }
+    outgoing.enqueue(QByteArray(1, static_cast<char>(FileOp::close)));
+    if (idle) {
+        sendOutgoing();
+    }
+}
+
+void SimulatedOrganiser::sendOutgoing() {
+    if (outgoing.isEmpty()) {
+        return;
+    }
+    reply(PacketType::data, outgoingSeq, outgoing.head());
+    retransmitTimer->start(RETRANSMIT_TIME);
+}
+
+qint64 SimulatedOrganiser::bytesAvailable() const {
+    return received.size() + QIODevice::bytesAvailable();
+}
+
+qint64 SimulatedOrganiser::readData(char *data, qint64 maxSize) {
+    const auto size = std::min<qint64>(maxSize, received.size());
+    std::copy_n(received.constData(), size, data);
+    received.remove(0, static_cast<int>(size));
+    return size;
+}
+
+qint64 SimulatedOrganiser::writeData(const char *data, qint64 maxSize) {
+    QByteArray sent(data, static_cast<int>(maxSize));
+    corrupt(sent);
+    // The bytes go out after anything already queued on the line.
+    const auto now = micros();
+    hostLineFree = std::max(hostLineFree, now) + lineTime(maxSize);
+    after(hostLineFree - now, [this, sent, maxSize] {
+        emit bytesWritten(maxSize);
+        deviceReceive(sent);
+    });
+    return maxSize;
+}
+
+qint64 SimulatedOrganiser::lineTime(qint64 size) const {
+    // A start bit, eight data bits and a stop bit per byte.
+    return config.baudRate == 0 ? 0 : size * 10 * 1000000 / config.baudRate;
+}
+
+void SimulatedOrganiser::corrupt(QByteArray &data) {
+    if (config.bitErrorRate <= 0) {
+        return;
+    }
+    const double byteErrorRate = 1 - std::pow(1 - config.bitErrorRate, 8);
+    std::bernoulli_distribution hit(byteErrorRate);
+    std::uniform_int_distribution<int> bit(0, 7);
+    for (auto &c : data) {
+        if (hit(random)) {
+            c = static_cast<char>(c ^ (1 << bit(random)));
+        }
+    }
+}
+
+void SimulatedOrganiser::after(qint64 delay, std::function<void()> action) {
+    clock->callAfter(std::chrono::microseconds{std::max<qint64>(delay, 0)},
+                     this, std::move(action));
+}
+
+void SimulatedOrganiser::deviceReceive(const QByteArray &data) {
+    const char *pos = data.constData();
+    qint64 remaining = data.size();
+    while (remaining > 0) {
+        const auto consumed = decoder.decode(pos, remaining);
+        pos += consumed;
+        remaining -= consumed;
+        if (decoder.hasMessage()) {
+            handleMessage(decoder.takeMessage());
+        }
+    }
+}
+
+void SimulatedOrganiser::handleMessage(const Message &msg) {
+    switch (msg.type) {
+    case PacketType::linkRequest:
+        lastSeq = -1;
+        reply(PacketType::acknowledge, 0);
+        break;
+    case PacketType::data:
+        // A retransmission means our acknowledgement was lost; just send
+        // it again.
+        if (msg.sequenceNo != lastSeq) {
+            if (!handleFileOp(msg.data)) {
+                // Say nothing; the host will give up.
+                return;
+            }
+            lastSeq = msg.sequenceNo;
+        }
+        reply(PacketType::acknowledge, msg.sequenceNo);
+        break;
+    case PacketType::acknowledge:
+        if (!outgoing.isEmpty() && msg.sequenceNo == outgoingSeq) {
+            retransmitTimer->stop();
+            outgoing.dequeue();
+            outgoingSeq = (outgoingSeq + 1) % 8;
+            sendOutgoing();
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+bool SimulatedOrganiser::handleFileOp(const QByteArray &payload) {
+    if (payload.isEmpty()) {
+        return false;
+    }
+    switch (static_cast<FileOp>(payload.at(0))) {
+    case FileOp::open:
+        // Whatever was being written before is abandoned.
+        stored -= openContents.size();
+        openName = payload.mid(1);
+        openContents.clear();
+        fileOpen = true;
+        return true;
+    case FileOp::data:
+        if (!fileOpen || stored + payload.size() - 1 > config.capacity) {
+            return false;
+        }
+        openContents.append(payload.constData() + 1, payload.size() - 1);
+        stored += payload.size() - 1;
+        return true;
+    case FileOp::close:
+        if (!fileOpen) {
+            return false;
+        }
+        // A file of the same name is replaced.
+        stored -= storedFiles.value(openName).size();
+        storedFiles.insert(openName, openContents);
+        openContents.clear();
+        fileOpen = false;
+        return true;
+    case FileOp::remove: {
+        const auto it = storedFiles.find(payload.mid(1));
+        if (it == storedFiles.end()) {
+            return false;
+        }
+        stored -= it->size();
+        storedFiles.erase(it);
+        return true;
+    }
+    }
+    return false;
+}
+
+void SimulatedOrganiser::reply(PacketType type, quint8 seq,
+                               const QByteArray &payload) {
+    encoder.encode(type, seq, payload.constData(), payload.size());
+    QByteArray frame(encoder.data(), static_cast<int>(encoder.size()));
+    corrupt(frame);
+    const auto now = micros();
+    deviceLineFree = std::max(deviceLineFree, now + config.turnaround.count())
+            + lineTime(frame.size());
+    after(deviceLineFree - now, [this, frame] {
+        received.append(frame);
+        emit readyRead();
+    });
+}
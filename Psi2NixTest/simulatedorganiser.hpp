@@ -0,0 +1,119 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QMap>
+#include <QQueue>
+
+#include <chrono>
+#include <functional>
+#include <random>
+
+#include "clock.hpp"
+#include "framedecoder.hpp"
+#include "frameencoder.hpp"
+
+/// \brief A simulated Organiser at the other end of a serial line.
+///
+/// Written bytes reach the device, and its replies come back, only after
+/// the time they'd take at the configured rate. The device answers link
+/// requests, acknowledges data frames (once each, however often they're
+/// retransmitted) and stores the files sent through the file layer,
+/// deleting them again when asked. It can also transmit files to the host,
+/// waiting for each frame to be acknowledged and retransmitting it if it
+/// isn't. Bits may be flipped in either direction at random.
+///
+/// On a VirtualClock, hours on the line take no time at all.
+class SimulatedOrganiser : public QIODevice
+{
+    Q_OBJECT
+public:
+    struct Config {
+        /// \brief The line rate; 0 for no pacing at all.
+        qint32 baudRate = 9600;
+        /// \brief How long the device takes to start answering a frame.
+        std::chrono::microseconds turnaround{2000};
+        /// \brief The probability of each bit on the line being flipped.
+        double bitErrorRate = 0;
+        /// \brief The bytes of file data the device can store.
+        qint64 capacity = 32 * 1024;
+        /// \brief Seed for the bit errors, so that runs can be repeated.
+        quint32 seed = 1;
+    };
+
+    explicit SimulatedOrganiser(const Config &config,
+                                QObject *parent = nullptr);
+    /// \brief Time the line by \p clock, which must outlive this device,
+    /// instead of the system clock; call before any traffic.
+    void setClock(CommsLink::Clock &clock);
+    bool isSequential() const override { return true; }
+    qint64 bytesAvailable() const override;
+    /// \brief Return the files closed on the device, by name.
+    const QMap<QByteArray, QByteArray> &files() const { return storedFiles; }
+    /// \brief Return the bytes of file data stored, including any file
+    /// still open.
+    qint64 bytesStored() const { return stored; }
+    /// \brief Return the number of frames the device discarded for a bad
+    /// CRC.
+    quint64 crcErrors() const { return decoder.crcErrors(); }
+    /// \brief Send a file to the host through the file layer, as the
+    /// Organiser's own transmit command does; files are sent in turn.
+    void transmit(const QByteArray &name, const QByteArray &contents);
+    /// \brief Return true iff everything transmitted has been
+    /// acknowledged.
+    bool transmitDone() const { return outgoing.isEmpty(); }
+
+protected:
+    qint64 readData(char *data, qint64 maxSize) override;
+    qint64 writeData(const char *data, qint64 maxSize) override;
+
+private:
+    /// \brief Return the time on clock, in microseconds.
+    qint64 micros() const;
+    /// \brief Return the microseconds \p size bytes take on the line.
+    qint64 lineTime(qint64 size) const;
+    /// \brief Flip bits in \p data at the configured rate.
+    void corrupt(QByteArray &data);
+    /// \brief Run \p action \p delay microseconds from now.
+    void after(qint64 delay, std::function<void()> action);
+    /// \brief Handle bytes that have reached the device.
+    void deviceReceive(const QByteArray &data);
+    void handleMessage(const CommsLink::Message &msg);
+    /// \brief Handle a file-layer operation; false if it can't be done.
+    bool handleFileOp(const QByteArray &payload);
+    /// \brief Send a frame from the device to the host.
+    void reply(CommsLink::PacketType type, quint8 seq,
+               const QByteArray &payload = {});
+    /// \brief Send the next frame being transmitted, and wait for it to be
+    /// acknowledged.
+    void sendOutgoing();
+
+    Config config;
+    std::mt19937 random;
+    CommsLink::Clock *clock = &CommsLink::Clock::system();
+    /// \brief When each direction of the line will next be free, in
+    /// microseconds on clock.
+    qint64 hostLineFree = 0;
+    qint64 deviceLineFree = 0;
+    /// \brief Bytes that have reached the host and not yet been read.
+    QByteArray received;
+    CommsLink::FrameDecoder decoder;
+    CommsLink::FrameEncoder encoder;
+    /// \brief The sequence number of the last data frame acted on, or -1.
+    int lastSeq = -1;
+    QByteArray openName;
+    QByteArray openContents;
+    bool fileOpen = false;
+    qint64 stored = 0;
+    QMap<QByteArray, QByteArray> storedFiles;
+    /// \brief The payloads of data frames still to be transmitted; the
+    /// head is waiting for an acknowledgement.
+    QQueue<QByteArray> outgoing;
+    /// \brief The sequence number of the frame at the head of outgoing.
+    quint8 outgoingSeq = 0;
+    /// \brief Resends the head of outgoing if it isn't acknowledged.
+    CommsLink::ClockTimer *retransmitTimer = nullptr;
+};
@@ -0,0 +1,69 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QtTest>
+#include <QSignalSpy>
+
+#include "baudprober.hpp"
+
+#include "testbaudprober.hpp"
+
+using namespace CommsLink;
+
+using std::chrono::milliseconds;
+
+void TestBaudProber::init() {
+    clock = std::make_unique<VirtualClock>();
+    port = std::make_unique<MockSerial>();
+    port->setAutoAcknowledge(true);
+    link = std::make_unique<Link>();
+    link->setClock(*clock);
+    link->setPort(*port);
+}
+
+void TestBaudProber::cleanup() {
+    link.reset();
+    port.reset();
+    clock.reset();
+}
+
+void TestBaudProber::testPicksFastestReliableRate() {
+    // The simulated device loses bytes above 2400 baud.
+    port->setMaxReliableRate(2400);
+    BaudProber prober(*link, [this](qint32 rate) {
+        return port->setBaudRate(rate);
+    });
+    prober.setClock(*clock);
+    prober.setReplyTimeout(milliseconds{50});
+    QSignalSpy spy(&prober, &BaudProber::finished);
+    prober.start({1200, 2400, 4800, 9600});
+    QVERIFY(clock->runUntil([&spy] { return spy.count() > 0; },
+                            milliseconds{2000}));
+    QCOMPARE(spy.at(0).at(0).toInt(), 2400);
+    const auto &results = prober.results();
+    QCOMPARE(results.size(), 3);
+    QCOMPARE(results.at(0).rate, 9600);
+    QVERIFY(!results.at(0).reliable);
+    QCOMPARE(results.at(0).acknowledged, 0);
+    QCOMPARE(results.at(1).rate, 4800);
+    QVERIFY(!results.at(1).reliable);
+    QCOMPARE(results.at(2).rate, 2400);
+    QVERIFY(results.at(2).reliable);
+    QCOMPARE(results.at(2).probesSent, 4);
+    QCOMPARE(results.at(2).acknowledged, 4);
+}
+
+void TestBaudProber::testNoReliableRate() {
+    port->setMaxReliableRate(600);
+    BaudProber prober(*link, [this](qint32 rate) {
+        return port->setBaudRate(rate);
+    });
+    prober.setClock(*clock);
+    prober.setReplyTimeout(milliseconds{50});
+    QSignalSpy spy(&prober, &BaudProber::finished);
+    prober.start({1200, 9600});
+    QVERIFY(clock->runUntil([&spy] { return spy.count() > 0; },
+                            milliseconds{2000}));
+    QCOMPARE(spy.at(0).at(0).toInt(), 0);
+    QCOMPARE(prober.results().size(), 2);
+}
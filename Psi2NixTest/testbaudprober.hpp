@@ -0,0 +1,23 @@
+#pragma once
+
+#include <memory>
+#include <QObject>
+
+#include "clock.hpp"
+#include "link.hpp"
+#include "mockserial.hpp"
+
+class TestBaudProber : public QObject
+{
+    Q_OBJECT
+private:
+    std::unique_ptr<CommsLink::VirtualClock> clock;
+    std::unique_ptr<MockSerial> port;
+    std::unique_ptr<CommsLink::Link> link;
+
+private slots:
+    void init();
+    void cleanup();
+    void testPicksFastestReliableRate();
+    void testNoReliableRate();
+};
@@ -0,0 +1,117 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QtTest>
+
+#include "clock.hpp"
+
+#include "testclock.hpp"
+
+using namespace CommsLink;
+using std::chrono::microseconds;
+using std::chrono::milliseconds;
+
+void TestClock::testTimersFireInOrder() {
+    VirtualClock clock;
+    QObject owner;
+    QStringList fired;
+    auto *late = clock.createTimer(&owner);
+    auto *early = clock.createTimer(&owner);
+    auto *tied = clock.createTimer(&owner);
+    QObject::connect(late, &ClockTimer::timeout, [&] {
+        fired << QString("late@%1").arg(clock.now().count());
+    });
+    QObject::connect(early, &ClockTimer::timeout, [&] {
+        fired << QString("early@%1").arg(clock.now().count());
+        // Restarting from a timeout counts from then.
+        if (fired.size() == 1) {
+            early->start(milliseconds{20});
+        }
+    });
+    QObject::connect(tied, &ClockTimer::timeout, [&] {
+        fired << QString("tied@%1").arg(clock.now().count());
+    });
+    late->start(milliseconds{30});
+    early->start(milliseconds{10});
+    // Started after late, with the same deadline.
+    tied->start(milliseconds{30});
+    QVERIFY(early->isActive());
+
+    clock.advance(milliseconds{29});
+    QCOMPARE(fired, QStringList{"early@10000000"});
+    QVERIFY(early->isActive());
+    clock.advance(milliseconds{1});
+    QCOMPARE(fired, (QStringList{"early@10000000", "late@30000000",
+                                 "tied@30000000", "early@30000000"}));
+    QVERIFY(!early->isActive());
+    QVERIFY(clock.now() == milliseconds{30});
+
+    // Stopped timers don't fire, and there's nothing to move on to.
+    late->start(milliseconds{5});
+    late->stop();
+    QVERIFY(!clock.advanceToNext());
+    QVERIFY(clock.now() == milliseconds{30});
+}
+
+void TestClock::testCallAfter() {
+    VirtualClock clock;
+    QObject owner;
+    std::chrono::nanoseconds calledAt{-1};
+    clock.callAfter(microseconds{1500}, &owner, [&] {
+        calledAt = clock.now();
+    });
+    // Called to the microsecond, not rounded to a millisecond.
+    QVERIFY(clock.advanceToNext());
+    QVERIFY(calledAt == microseconds{1500});
+
+    // Not at all if the context has gone.
+    bool called = false;
+    auto *context = new QObject;
+    clock.callAfter(microseconds{10}, context, [&called] { called = true; });
+    delete context;
+    clock.advance(milliseconds{1});
+    QVERIFY(!called);
+}
+
+void TestClock::testRunUntil() {
+    VirtualClock clock;
+    QObject owner;
+    int ticks = 0;
+    auto *timer = clock.createTimer(&owner);
+    QObject::connect(timer, &ClockTimer::timeout, [&] {
+        if (++ticks < 100) {
+            timer->start(milliseconds{1000});
+        }
+    });
+    timer->start(milliseconds{1000});
+    // A hundred seconds go by at once.
+    QVERIFY(clock.runUntil([&ticks] { return ticks == 100; },
+                           milliseconds{200000}));
+    QVERIFY(clock.now() == milliseconds{100000});
+
+    // Events posted meanwhile are delivered before time moves on.
+    bool posted = false;
+    QMetaObject::invokeMethod(&owner, [&posted] { posted = true; },
+                              Qt::QueuedConnection);
+    timer->start(milliseconds{1000});
+    QVERIFY(clock.runUntil([&posted] { return posted; },
+                           milliseconds{5000}));
+    QVERIFY(clock.now() == milliseconds{100000});
+
+    // Giving up once the limit has passed, with the clock at the limit.
+    QVERIFY(!clock.runUntil([] { return false; }, milliseconds{500}));
+    QVERIFY(clock.now() == milliseconds{100500});
+}
+
+void TestClock::testOutlivedByTimers() {
+    QObject owner;
+    ClockTimer *timer = nullptr;
+    {
+        VirtualClock clock;
+        timer = clock.createTimer(&owner);
+        timer->start(milliseconds{10});
+    }
+    // A timer whose clock has gone is inert rather than dangling.
+    timer->start(milliseconds{10});
+    delete timer;
+}
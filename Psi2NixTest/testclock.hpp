@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QObject>
+
+class TestClock : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testTimersFireInOrder();
+    void testCallAfter();
+    void testRunUntil();
+    void testOutlivedByTimers();
+};
@@ -0,0 +1,49 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QtTest>
+
+#include "crc16.hpp"
+
+#include "testcrc16.hpp"
+
+using namespace CommsLink;
+
+void TestCrc16::testVariantsMatchTable_data() {
+    QTest::addColumn<QByteArray>("data");
+    QTest::addColumn<quint16>("initial");
+    // Cover every residue mod 16, on both sides of the folding threshold.
+    for (int size : {0, 1, 7, 8, 15, 16, 17, 31, 63, 64, 65, 100, 511, 512}) {
+        QByteArray data(size, '\0');
+        for (int i = 0; i < size; i++) {
+            data[i] = static_cast<char>((i * 0x9d + size) & 0xff);
+        }
+        QTest::newRow(qPrintable(QString("%1 bytes").arg(size)))
+                << data << quint16{0x0000};
+        QTest::newRow(qPrintable(QString("%1 bytes, running").arg(size)))
+                << data << quint16{0xbeef};
+    }
+}
+
+void TestCrc16::testVariantsMatchTable() {
+    QFETCH(QByteArray, data);
+    QFETCH(quint16, initial);
+    quint16 expected = initial;
+    for (auto b : data) {
+        expected = crc16Update(expected, static_cast<quint8>(b));
+    }
+    QCOMPARE(crc16Bytewise(initial, data.constData(), data.size()), expected);
+    QCOMPARE(crc16Sliced(initial, data.constData(), data.size()), expected);
+    QCOMPARE(crc16Clmul(initial, data.constData(), data.size()), expected);
+    QCOMPARE(crc16(initial, data.constData(), data.size()), expected);
+}
+
+void TestCrc16::testUnescaped() {
+    // Channel, type and data of the frame in TestLink::testSendEscaped.
+    const char stuffed[]{0x01, 0x19, 0x41, 0x10, 0x10, 0x42,
+                         0x10, 0x10, 0x10, 0x10};
+    const char plain[]{0x01, 0x19, 0x41, 0x10, 0x42, 0x10, 0x10};
+    QCOMPARE(crc16Unescaped(0x0000, stuffed, sizeof(stuffed)),
+             quint16{0x861e});
+    QCOMPARE(crc16(0x0000, plain, sizeof(plain)), quint16{0x861e});
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <QObject>
+
+class TestCrc16 : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testVariantsMatchTable_data();
+    void testVariantsMatchTable();
+    void testUnescaped();
+};
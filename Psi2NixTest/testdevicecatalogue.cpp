@@ -0,0 +1,118 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include "devicecatalogue.hpp"
+
+#include "testdevicecatalogue.hpp"
+
+using namespace CommsLink;
+
+void TestDeviceCatalogue::testUpdatedInPlace() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    DeviceCatalogue catalogue(dir.filePath("catalogue.json"));
+    QVERIFY(catalogue.entries("dev").isEmpty());
+    const auto before = catalogue.revision();
+    catalogue.recordWritten("dev", "B.OPL", 20);
+    catalogue.recordWritten("dev", "A.OPL", 10);
+    QVERIFY(catalogue.revision() != before);
+    auto entries = catalogue.entries("dev");
+    QCOMPARE(entries.size(), 2);
+    QCOMPARE(entries[0].name, QByteArray("A.OPL"));
+    QCOMPARE(entries[0].size, qint64{10});
+    QCOMPARE(entries[1].name, QByteArray("B.OPL"));
+    QVERIFY(entries[1].modified > 0);
+
+    // Writing a file again replaces its entry.
+    catalogue.recordWritten("dev", "A.OPL", 15);
+    CatalogueEntry entry;
+    QVERIFY(catalogue.find("dev", "A.OPL", entry));
+    QCOMPARE(entry.size, qint64{15});
+    QCOMPARE(catalogue.entries("dev").size(), 2);
+
+    catalogue.recordRemoved("dev", "A.OPL");
+    QVERIFY(!catalogue.find("dev", "A.OPL", entry));
+    QCOMPARE(catalogue.entries("dev").size(), 1);
+    // Removing a file that isn't there changes nothing.
+    const auto unchanged = catalogue.revision();
+    catalogue.recordRemoved("dev", "A.OPL");
+    QCOMPARE(catalogue.revision(), unchanged);
+
+    // Our own writes don't count as a listing.
+    QVERIFY(catalogue.needsListing("dev"));
+}
+
+void TestDeviceCatalogue::testFillReplacesEntries() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    DeviceCatalogue catalogue(dir.filePath("catalogue.json"));
+    catalogue.recordWritten("dev", "GONE.OPL", 5);
+    QVERIFY(catalogue.needsListing("dev"));
+    catalogue.fill("dev", {{"A.ODB", 100, 1000}, {"B.ODB", 200, 2000}});
+    QVERIFY(!catalogue.needsListing("dev"));
+    CatalogueEntry entry;
+    QVERIFY(!catalogue.find("dev", "GONE.OPL", entry));
+    QVERIFY(catalogue.find("dev", "B.ODB", entry));
+    QCOMPARE(entry.size, qint64{200});
+    QCOMPARE(entry.modified, qint64{2000});
+
+    // Writes after the listing are added to it.
+    catalogue.recordWritten("dev", "C.ODB", 300);
+    QCOMPARE(catalogue.entries("dev").size(), 3);
+    QVERIFY(!catalogue.needsListing("dev"));
+
+    catalogue.forgetDevice("dev");
+    QVERIFY(catalogue.entries("dev").isEmpty());
+    QVERIFY(catalogue.needsListing("dev"));
+}
+
+void TestDeviceCatalogue::testDevicesAreSeparate() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    DeviceCatalogue catalogue(dir.filePath("catalogue.json"));
+    catalogue.recordWritten("one", "A.OPL", 10);
+    catalogue.fill("two", {{"B.OPL", 20, 0}});
+    CatalogueEntry entry;
+    QVERIFY(catalogue.find("one", "A.OPL", entry));
+    QVERIFY(!catalogue.find("two", "A.OPL", entry));
+    QVERIFY(catalogue.needsListing("one"));
+    QVERIFY(!catalogue.needsListing("two"));
+    catalogue.recordRemoved("two", "B.OPL");
+    QVERIFY(catalogue.entries("two").isEmpty());
+    QCOMPARE(catalogue.entries("one").size(), 1);
+}
+
+void TestDeviceCatalogue::testPersistence() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto path = dir.filePath("sub/catalogue.json");
+    {
+        DeviceCatalogue catalogue(path);
+        QVERIFY(catalogue.load());
+        catalogue.fill("dev", {{"A.ODB", 100, 1000}});
+        catalogue.recordWritten("dev", "B.OPL", 7);
+        QVERIFY(catalogue.save());
+    }
+    // A later session starts with what was known, but still has to list
+    // the device to be sure of it.
+    DeviceCatalogue catalogue(path);
+    QVERIFY(catalogue.load());
+    QVERIFY(catalogue.needsListing("dev"));
+    const auto entries = catalogue.entries("dev");
+    QCOMPARE(entries.size(), 2);
+    QCOMPARE(entries[0].name, QByteArray("A.ODB"));
+    QCOMPARE(entries[0].size, qint64{100});
+    QCOMPARE(entries[0].modified, qint64{1000});
+    QCOMPARE(entries[1].size, qint64{7});
+
+    // An unreadable file gives an empty catalogue.
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::WriteOnly));
+    file.write("not json");
+    file.close();
+    QVERIFY(!catalogue.load());
+    QVERIFY(catalogue.entries("dev").isEmpty());
+}
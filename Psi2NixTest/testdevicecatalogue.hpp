@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QObject>
+
+class TestDeviceCatalogue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testUpdatedInPlace();
+    void testFillReplacesEntries();
+    void testDevicesAreSeparate();
+    void testPersistence();
+};
@@ -0,0 +1,143 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QtTest>
+#include <QTemporaryDir>
+
+#include <thread>
+
+#include "eventtrace.hpp"
+#include "eventtracedumper.hpp"
+#include "framedecoder.hpp"
+
+#include "testeventtrace.hpp"
+
+using namespace CommsLink;
+
+namespace {
+// Return the events of one kind recorded since start.
+std::vector<TraceEvent> eventsSince(quint64 start, TraceEventId id) {
+    std::vector<TraceEvent> events;
+    for (const auto &event : EventTrace::snapshot()) {
+        if (event.timestamp >= start && event.id == id) {
+            events.push_back(event);
+        }
+    }
+    return events;
+}
+}
+
+void TestEventTrace::cleanup() {
+    EventTrace::setLevel(TraceLevel::debug);
+}
+
+void TestEventTrace::testRecordAndFormat() {
+    const auto start = EventTrace::now();
+    traceEvent<TraceLevel::debug>(TraceEventId::bytesWritten, 12, 34);
+    traceEvent<TraceLevel::info>(TraceEventId::readTimeout);
+    const auto written = eventsSince(start, TraceEventId::bytesWritten);
+    QCOMPARE(written.size(), size_t{1});
+    QCOMPARE(written[0].args[0], qint64{12});
+    QCOMPARE(written[0].args[1], qint64{34});
+    QVERIFY(written[0].level == TraceLevel::debug);
+    QVERIFY(EventTrace::format(written[0])
+            .endsWith("debug: 12 bytes written; 34 remaining"));
+    const auto timeouts = eventsSince(start, TraceEventId::readTimeout);
+    QCOMPARE(timeouts.size(), size_t{1});
+    QVERIFY(timeouts[0].timestamp >= written[0].timestamp);
+    QVERIFY(EventTrace::format(timeouts[0])
+            .endsWith("info: Read timeout; discarding partial frame"));
+}
+
+void TestEventTrace::testLevels() {
+    const auto start = EventTrace::now();
+    EventTrace::setLevel(TraceLevel::info);
+    QVERIFY(!EventTrace::isEnabled(TraceLevel::debug));
+    traceEvent<TraceLevel::debug>(TraceEventId::framingError);
+    traceEvent<TraceLevel::warning>(TraceEventId::writeOverrun, 1, 2);
+    EventTrace::setLevel(TraceLevel::off);
+    traceEvent<TraceLevel::warning>(TraceEventId::writeOverrun, 3, 4);
+    QVERIFY(eventsSince(start, TraceEventId::framingError).empty());
+    const auto overruns = eventsSince(start, TraceEventId::writeOverrun);
+    QCOMPARE(overruns.size(), size_t{1});
+    QCOMPARE(overruns[0].args[0], qint64{1});
+
+    TraceLevel level;
+    QVERIFY(EventTrace::levelFromName("warning", level));
+    QVERIFY(level == TraceLevel::warning);
+    QCOMPARE(EventTrace::levelName(level), QString("warning"));
+    QVERIFY(!EventTrace::levelFromName("verbose", level));
+}
+
+void TestEventTrace::testRingOverwritesOldest() {
+    constexpr int extra = 10;
+    const auto start = EventTrace::now();
+    // A thread of its own, so that it gets a ring of its own.
+    std::thread recorder([] {
+        for (int i = 0; i < EventTrace::RING_SIZE + extra; i++) {
+            traceEvent<TraceLevel::debug>(TraceEventId::mockReceived, i);
+        }
+    });
+    // Reading while the ring is being written mustn't return torn events.
+    for (int i = 0; i < 10; i++) {
+        for (const auto &event
+             : eventsSince(start, TraceEventId::mockReceived)) {
+            QCOMPARE(event.args[1], qint64{0});
+        }
+    }
+    recorder.join();
+    const auto events = eventsSince(start, TraceEventId::mockReceived);
+    QCOMPARE(events.size(), size_t{EventTrace::RING_SIZE});
+    for (size_t i = 0; i < events.size(); i++) {
+        QCOMPARE(events[i].args[0], static_cast<qint64>(i) + extra);
+    }
+}
+
+void TestEventTrace::testDecoderErrors() {
+    const auto start = EventTrace::now();
+    // A link request with its CRC's low byte wrong, then one cut short by
+    // the start of the next.
+    const quint8 wire[]{
+        0x16, 0x10, 0x02, 0x01, 0x10, 0x10, 0x10, 0x03, 0x00, 0x5D,
+        0x16, 0x10, 0x02, 0x01, 0x10, 0x10, 0x16, 0x10, 0x02,
+        0x01, 0x10, 0x10, 0x10, 0x03, 0x00, 0x5C
+    };
+    FrameDecoder decoder;
+    const auto consumed = decoder.decode(reinterpret_cast<const char *>(wire),
+                                         sizeof(wire));
+    QCOMPARE(consumed, qint64{sizeof(wire)});
+    QVERIFY(decoder.hasMessage());
+    QCOMPARE(decoder.crcErrors(), quint64{1});
+    const auto crcErrors = eventsSince(start, TraceEventId::badCrc);
+    QCOMPARE(crcErrors.size(), size_t{1});
+    QVERIFY(crcErrors[0].level == TraceLevel::warning);
+    QCOMPARE(crcErrors[0].args[0], qint64{0x005C});
+    QCOMPARE(crcErrors[0].args[1], qint64{0x005D});
+    QCOMPARE(eventsSince(start, TraceEventId::truncatedFrame).size(),
+             size_t{1});
+}
+
+void TestEventTrace::testDump() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto path = dir.filePath("events.txt");
+    traceEvent<TraceLevel::debug>(TraceEventId::bytesAvailable, 4321);
+    EventTraceDumper dumper;
+    // dumped() comes from the dumper's thread; have it queued to this one.
+    int events = -1;
+    bool ok = false;
+    connect(&dumper, &EventTraceDumper::dumped,
+            this, [&](const QString &dumpedPath, int count, bool success) {
+        QCOMPARE(dumpedPath, path);
+        events = count;
+        ok = success;
+    });
+    dumper.dump(path);
+    QTRY_VERIFY_WITH_TIMEOUT(events >= 0, 5000);
+    QVERIFY(events > 0);
+    QVERIFY(ok);
+    QFile file(path);
+    QVERIFY(file.open(QIODevice::ReadOnly | QIODevice::Text));
+    const auto text = QString::fromUtf8(file.readAll());
+    QVERIFY(text.contains("4321 bytes available to read\n"));
+}
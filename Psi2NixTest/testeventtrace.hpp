@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QObject>
+
+class TestEventTrace : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRecordAndFormat();
+    void testLevels();
+    void testRingOverwritesOldest();
+    void testDecoderErrors();
+    void testDump();
+    void cleanup();
+};
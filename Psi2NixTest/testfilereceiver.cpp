@@ -0,0 +1,126 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QtTest>
+#include <QSignalSpy>
+#include <QTemporaryDir>
+
+#include "bufferedwriter.hpp"
+#include "clock.hpp"
+#include "filereceiver.hpp"
+#include "link.hpp"
+#include "protocol.hpp"
+#include "simulatedorganiser.hpp"
+
+#include "testfilereceiver.hpp"
+
+using namespace CommsLink;
+
+namespace {
+QByteArray makeContents(int size) {
+    QByteArray contents;
+    for (int i = 0; i < size; i++) {
+        contents.append(static_cast<char>(i % 5 == 0 ? 0x10 : i & 0xff));
+    }
+    return contents;
+}
+
+QByteArray readFile(const QString &path) {
+    QFile file(path);
+    return file.open(QIODevice::ReadOnly) ? file.readAll() : QByteArray();
+}
+}
+
+void TestFileReceiver::testBufferedWriter() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto path = dir.filePath("out.bin");
+    const auto contents = makeContents(3 * BufferedWriter::FLUSH_SIZE + 123);
+    BufferedWriter writer(path);
+    QSignalSpy finished(&writer, &BufferedWriter::finished);
+    for (int pos = 0; pos < contents.size(); pos += 100) {
+        writer.append(contents.constData() + pos,
+                      std::min(100, contents.size() - pos));
+    }
+    QCOMPARE(writer.size(), qint64{contents.size()});
+    // Nothing appears under the file's name until all of it is written.
+    QVERIFY(!QFile::exists(path));
+    writer.close();
+    QVERIFY(finished.wait(5000));
+    QCOMPARE(finished.at(0).at(0).toBool(), true);
+    QCOMPARE(readFile(path), contents);
+}
+
+void TestFileReceiver::testWriterFailure() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    BufferedWriter writer(dir.filePath("missing/out.bin"));
+    QSignalSpy finished(&writer, &BufferedWriter::finished);
+    const auto contents = makeContents(2 * BufferedWriter::FLUSH_SIZE);
+    writer.append(contents.constData(), contents.size());
+    writer.close();
+    QVERIFY(finished.wait(5000));
+    QCOMPARE(finished.at(0).at(0).toBool(), false);
+}
+
+void TestFileReceiver::testReceiveFiles() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    SimulatedOrganiser::Config config;
+    config.baudRate = 0;
+    config.turnaround = std::chrono::microseconds{0};
+    SimulatedOrganiser device(config);
+    VirtualClock clock;
+    device.setClock(clock);
+    Link link;
+    link.setClock(clock);
+    link.setPort(device);
+    Protocol protocol;
+    protocol.setClock(clock);
+    protocol.setLink(link);
+    FileReceiver receiver(protocol, dir.path());
+    QSignalSpy received(&receiver, &FileReceiver::fileReceived);
+    const auto data = makeContents(5000);
+    const QByteArray program("PROC MAIN:\nPRINT \"HI\"\nGET\nENDP\n");
+    device.transmit("A:DATA.ODB", data);
+    device.transmit("MAIN.OPL", program);
+    // The device hears the last acknowledgement in its own time.
+    QVERIFY(clock.runUntil([&] {
+        return received.count() == 2 && device.transmitDone();
+    }, std::chrono::seconds{10}));
+    QVERIFY(!receiver.isReceiving());
+    QCOMPARE(received.at(0).at(0).toString(), dir.filePath("A_DATA.ODB"));
+    QCOMPARE(received.at(0).at(1).toBool(), true);
+    QCOMPARE(readFile(dir.filePath("A_DATA.ODB")), data);
+    QCOMPARE(received.at(1).at(1).toBool(), true);
+    QCOMPARE(readFile(dir.filePath("MAIN.OPL")), program);
+}
+
+void TestFileReceiver::testReceiveWithBitErrors() {
+    // Lost acknowledgements mean repeated frames, which mustn't be saved
+    // twice.
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    SimulatedOrganiser::Config config;
+    config.baudRate = 0;
+    config.turnaround = std::chrono::microseconds{0};
+    config.bitErrorRate = 1e-4;
+    config.seed = 7;
+    SimulatedOrganiser device(config);
+    VirtualClock clock;
+    device.setClock(clock);
+    Link link;
+    link.setClock(clock);
+    link.setPort(device);
+    Protocol protocol;
+    protocol.setClock(clock);
+    protocol.setLink(link);
+    FileReceiver receiver(protocol, dir.path());
+    QSignalSpy received(&receiver, &FileReceiver::fileReceived);
+    const auto data = makeContents(20000);
+    device.transmit("BACKUP.ODB", data);
+    QVERIFY(clock.runUntil([&received] { return received.count() == 1; },
+                           std::chrono::seconds{60}));
+    QCOMPARE(received.at(0).at(1).toBool(), true);
+    QCOMPARE(readFile(dir.filePath("BACKUP.ODB")), data);
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QObject>
+
+class TestFileReceiver : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testBufferedWriter();
+    void testWriterFailure();
+    void testReceiveFiles();
+    void testReceiveWithBitErrors();
+};
@@ -0,0 +1,193 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QtTest>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+
+#include "filetransfer.hpp"
+#include "framedecoder.hpp"
+
+#include "testfiletransfer.hpp"
+
+using namespace CommsLink;
+
+void TestFileTransfer::init() {
+    port = std::make_unique<MockSerial>();
+    port->setAutoAcknowledge(true);
+    link = std::make_unique<Link>();
+    link->setPort(*port);
+    protocol = std::make_unique<Protocol>();
+    protocol->setLink(*link);
+}
+
+void TestFileTransfer::cleanup() {
+    protocol.reset();
+    link.reset();
+    port.reset();
+}
+
+void TestFileTransfer::testChunkLength() {
+    const char escapes[]{0x10, 0x10, 0x10};
+    QCOMPARE(PayloadPlanner::chunkLength(escapes, 3, 6), qint64{3});
+    QCOMPARE(PayloadPlanner::chunkLength(escapes, 3, 5), qint64{2});
+    QCOMPARE(PayloadPlanner::chunkLength(escapes, 3, 3), qint64{1});
+    const char mixed[]{0x41, 0x42, 0x10, 0x43};
+    QCOMPARE(PayloadPlanner::chunkLength(mixed, 4, 3), qint64{2});
+    QCOMPARE(PayloadPlanner::chunkLength(mixed, 4, 4), qint64{3});
+    QCOMPARE(PayloadPlanner::chunkLength(mixed, 4, 100), qint64{4});
+
+    // The wire bytes used count each 0x10 twice.
+    qint64 wireBytes = 0;
+    QCOMPARE(PayloadPlanner::chunkLength(escapes, 3, 5, &wireBytes),
+             qint64{2});
+    QCOMPARE(wireBytes, qint64{4});
+    QCOMPARE(PayloadPlanner::chunkLength(mixed, 4, 100, &wireBytes),
+             qint64{4});
+    QCOMPARE(wireBytes, qint64{5});
+}
+
+void TestFileTransfer::testPlannerAdapts() {
+    PayloadPlanner planner;
+    // A clean line keeps frames full.
+    for (int i = 0; i < 100; i++) {
+        planner.frameAcknowledged(planner.budget() + 1, 0);
+    }
+    QCOMPARE(planner.budget(), PayloadPlanner::MAX_BUDGET);
+    QCOMPARE(planner.errorRate(), 0.0);
+    // One unlucky frame doesn't shrink them.
+    planner.frameAcknowledged(planner.budget() + 1, 1);
+    QCOMPARE(planner.budget(), PayloadPlanner::MAX_BUDGET);
+
+    // A quarter of frames being sent again does.
+    for (int i = 0; i < 64; i++) {
+        planner.frameAcknowledged(planner.budget() + 1, i % 4 == 0 ? 1 : 0);
+    }
+    const auto noisy = planner.budget();
+    QVERIFY(noisy < PayloadPlanner::MAX_BUDGET);
+    QVERIFY(noisy >= PayloadPlanner::MIN_BUDGET);
+    // The worse the line, the shorter the frames.
+    for (int i = 0; i < 64; i++) {
+        planner.frameAcknowledged(planner.budget() + 1, 1);
+    }
+    QVERIFY(planner.budget() < noisy);
+    QVERIFY(planner.budget() >= PayloadPlanner::MIN_BUDGET);
+
+    // They grow back once it clears.
+    for (int i = 0; i < 1000; i++) {
+        planner.frameAcknowledged(planner.budget() + 1, 0);
+    }
+    QCOMPARE(planner.budget(), PayloadPlanner::MAX_BUDGET);
+}
+
+void TestFileTransfer::testSendFile() {
+    QTemporaryFile source;
+    QVERIFY(source.open());
+    QByteArray contents;
+    for (int i = 0; i < 3000; i++) {
+        contents.append(static_cast<char>(i % 7 == 0 ? 0x10 : i & 0xff));
+    }
+    source.write(contents);
+    source.flush();
+
+    FileTransfer transfer(*protocol);
+    QSignalSpy finished(&transfer, &FileTransfer::finished);
+    QVERIFY(transfer.start(source.fileName(), "TEST.ODB"));
+    QVERIFY(finished.wait(2000));
+    QCOMPARE(finished.at(0).at(0).toBool(), true);
+    QCOMPARE(transfer.bytesSent(), qint64{contents.size()});
+
+    // Reassemble the file from what went over the wire.
+    FrameDecoder decoder;
+    const QByteArray wire = port->sendBuf.buffer();
+    const char *pos = wire.constData();
+    qint64 remaining = wire.size();
+    QList<QByteArray> payloads;
+    QList<qint64> frameSizes;
+    while (remaining > 0) {
+        const auto consumed = decoder.decode(pos, remaining);
+        pos += consumed;
+        remaining -= consumed;
+        QVERIFY(decoder.hasMessage());
+        payloads.append(decoder.takeMessage().data);
+        frameSizes.append(consumed);
+    }
+    QVERIFY(payloads.size() >= 3);
+    QCOMPARE(payloads.first(),
+             QByteArray(1, static_cast<char>(FileOp::open)) + "TEST.ODB");
+    QCOMPARE(payloads.last(), QByteArray(1, static_cast<char>(FileOp::close)));
+    QByteArray received;
+    for (int i = 1; i < payloads.size() - 1; i++) {
+        QCOMPARE(payloads[i].at(0), static_cast<char>(FileOp::data));
+        received.append(payloads[i].mid(1));
+        QVERIFY(frameSizes[i] <= MAX_MSG_SIZE);
+        if (i < payloads.size() - 2) {
+            // All but the last chunk should fill their frames.
+            QVERIFY(frameSizes[i] >= MAX_MSG_SIZE - 1);
+        }
+    }
+    QCOMPARE(received, contents);
+}
+
+void TestFileTransfer::testRemoteNameChecked() {
+    QTemporaryFile source;
+    QVERIFY(source.open());
+    const auto budget = static_cast<int>(PayloadPlanner::MAX_BUDGET);
+    FileTransfer transfer(*protocol);
+    QSignalSpy finished(&transfer, &FileTransfer::finished);
+    QVERIFY(!transfer.start(source.fileName(), QByteArray()));
+    QVERIFY(!transfer.start(source.fileName(), QByteArray(budget + 1, 'A')));
+    // Escaping doubles each 0x10, so this won't fit either.
+    QVERIFY(!transfer.start(source.fileName(),
+                            QByteArray(budget / 2 + 1, '\x10')));
+    QCOMPARE(protocol->queueLength(), 0);
+    QVERIFY(transfer.start(source.fileName(), QByteArray(budget, 'A')));
+    QVERIFY(finished.wait(2000));
+    QCOMPARE(finished.at(0).at(0).toBool(), true);
+}
+
+void TestFileTransfer::testSendTextFile() {
+    // Enough lines to take several pieces to convert, with every kind of
+    // line ending and a line too long for one record.
+    QTemporaryFile source;
+    QVERIFY(source.open());
+    QByteArray contents;
+    QList<QByteArray> expected;
+    const char *const endings[]{"\n", "\r\n", "\r"};
+    for (int i = 0; i < 4000; i++) {
+        const auto line = "LINE" + QByteArray::number(i);
+        contents.append(line).append(endings[i % 3]);
+        expected.append(line);
+    }
+    const QByteArray longLine(300, 'L');
+    contents.append(longLine);
+    expected.append(longLine.left(RecordConverter::MAX_RECORD));
+    expected.append(longLine.mid(RecordConverter::MAX_RECORD));
+    QVERIFY(contents.size() > 2 * RecordStream::CHUNK_SIZE);
+    source.write(contents);
+    source.flush();
+
+    FileTransfer transfer(*protocol);
+    QSignalSpy finished(&transfer, &FileTransfer::finished);
+    QVERIFY(transfer.start(source.fileName(), "TEST.OPL", Conversion::text));
+    QVERIFY(finished.wait(10000));
+    QCOMPARE(finished.at(0).at(0).toBool(), true);
+    QCOMPARE(transfer.bytesSent(), qint64{contents.size()});
+
+    FrameDecoder decoder;
+    const QByteArray wire = port->sendBuf.buffer();
+    const char *pos = wire.constData();
+    qint64 remaining = wire.size();
+    QList<QByteArray> records;
+    while (remaining > 0) {
+        const auto consumed = decoder.decode(pos, remaining);
+        pos += consumed;
+        remaining -= consumed;
+        QVERIFY(decoder.hasMessage());
+        const auto payload = decoder.takeMessage().data;
+        if (payload.at(0) == static_cast<char>(FileOp::data)) {
+            records.append(payload.mid(1));
+        }
+    }
+    QCOMPARE(records, expected);
+}
@@ -5,6 +5,9 @@
 #include <QCoreApplication>
 #include <QSignalSpy>
 
+#include "clock.hpp"
+#include "controlframes.hpp"
+#include "frameencoder.hpp"
 #include "link.hpp"
 #include "mockserial.hpp"
 
@@ -13,7 +16,8 @@
 void TestLink::init() {
     link = std::make_unique<CommsLink::Link>();
     port = std::make_unique<MockSerial>();
-    receivedMsg.reset();
+    receivedMsg = {};
+    receivedCount = 0;
     link->setPort(*port);
 }
 
@@ -66,8 +70,72 @@ void TestLink::testSendLinkRequest() {
     QCOMPARE(actual, expected);
 }
 
-void TestLink::receiveMessage(CommsLink::Message m) {
-    receivedMsg = std::make_unique<CommsLink::Message>(m);
+void TestLink::testSendControlFrames() {
+    QSignalSpy spy(&*port, &QIODevice::bytesWritten);
+    // The precomputed frames must match what the encoder would produce.
+    QByteArray expected;
+    CommsLink::FrameEncoder encoder;
+    for (auto type : CommsLink::controlTypes) {
+        const CommsLink::Message msg{type, QByteArray{}};
+        for (quint8 seq = 0; seq < 8; seq++) {
+            QVERIFY(encoder.encode(type, seq, nullptr, 0));
+            expected.append(encoder.data(), static_cast<int>(encoder.size()));
+            QVERIFY(link->send(msg, seq));
+            QVERIFY(spy.wait(250));
+        }
+    }
+    QCOMPARE(port->sendBuf.buffer(), expected);
+    QCOMPARE(link->metrics().snapshot().framesSent, quint64{24});
+    QCOMPARE(link->metrics().snapshot().payloadBytesSent, quint64{0});
+}
+
+void TestLink::testSendConsecutive() {
+    QSignalSpy spy(&*port, &QIODevice::bytesWritten);
+    const CommsLink::Message msg{
+        CommsLink::PacketType::data,
+                QByteArray("FILE")
+    };
+    const quint8 expectedData[]{
+        0x16, 0x10, 0x02, 0x01, 0x19,   // type 3, seq 1
+        0x46, 0x49, 0x4C, 0x45, 0x10, 0x03, 0x2D, 0xBE,
+        0x16, 0x10, 0x02, 0x01, 0x1A,   // type 3, seq 2
+        0x46, 0x49, 0x4C, 0x45, 0x10, 0x03, 0x69, 0xBE
+    };
+    QVERIFY(link->send(msg));
+    QVERIFY(spy.wait(250));
+    QVERIFY(link->send(msg));
+    QVERIFY(spy.wait(250));
+    const QByteArray expected(reinterpret_cast<const char *>(expectedData),
+                              sizeof(expectedData));
+    QCOMPARE(port->sendBuf.buffer(), expected);
+}
+
+void TestLink::testSendEscaped() {
+    QSignalSpy spy(&*port, &QIODevice::bytesWritten);
+    const char testCaseData[]{0x41, 0x10, 0x42, 0x10, 0x10};
+    const CommsLink::Message msg{
+        CommsLink::PacketType::data,
+                QByteArray(testCaseData, sizeof(testCaseData))
+    };
+    const quint8 expectedData[]{
+        0x16, 0x10, 0x02,       // preamble
+        0x01,                   // channel number
+        0x19,                   // type 3, seq 1
+        0x41, 0x10, 0x10, 0x42, // escaped data
+        0x10, 0x10, 0x10, 0x10,
+        0x10, 0x03,             // postamble
+        0x86, 0x1E              // CRC
+    };
+    QVERIFY(link->send(msg));
+    QVERIFY(spy.wait(250));
+    const QByteArray expected(reinterpret_cast<const char *>(expectedData),
+                              sizeof(expectedData));
+    QCOMPARE(port->sendBuf.buffer(), expected);
+}
+
+void TestLink::receiveMessage(CommsLink::MessageRef m) {
+    receivedMsg = m;
+    receivedCount++;
 }
 
 void TestLink::testReceiveData() {
@@ -123,3 +191,180 @@ void TestLink::testReceiveMultipleReads() {
     QVERIFY(receivedMsg->data.size() == 0);
     QVERIFY(link->readBuf.size() == 0);
 }
+
+void TestLink::testReceiveAfterNoise() {
+    QSignalSpy spy(&(*port), &QIODevice::readyRead);
+    connect(&(*link), &CommsLink::Link::packetReceived,
+            this, &TestLink::receiveMessage);
+    const quint8 noisyData[]{
+        0x00, 0x16, 0x16, 0x10, // line noise, including a false start
+        0x16, 0x10, 0x02,       // preamble
+        0x01,                   // channel number
+        0x19,                   // type 3, seq 1
+        0x46, 0x49, 0x4C, 0x45, // "FILE"
+        0x10, 0x03,             // postamble
+        0x2D, 0xBE              // CRC
+    };
+    port->sendData(reinterpret_cast<const char *>(noisyData),
+                   sizeof(noisyData));
+    QVERIFY(spy.wait(250));
+    QCOMPARE(receivedCount, 1);
+    QVERIFY(receivedMsg->type == CommsLink::PacketType::data);
+    QVERIFY(receivedMsg->sequenceNo == 1);
+    QCOMPARE(receivedMsg->data, QByteArray("FILE"));
+}
+
+void TestLink::testReceiveMultipleFrames() {
+    QSignalSpy spy(&(*port), &QIODevice::readyRead);
+    connect(&(*link), &CommsLink::Link::packetReceived,
+            this, &TestLink::receiveMessage);
+    const quint8 twoFrames[]{
+        0x16, 0x10, 0x02, 0x01, 0x10, 0x10, 0x10, 0x03, 0x00, 0x5C,
+        0x16, 0x10, 0x02, 0x01, 0x19, 0x46, 0x49, 0x4C, 0x45,
+        0x10, 0x03, 0x2D, 0xBE
+    };
+    port->sendData(reinterpret_cast<const char *>(twoFrames),
+                   sizeof(twoFrames));
+    QVERIFY(spy.wait(250));
+    QCOMPARE(receivedCount, 2);
+    QVERIFY(receivedMsg->type == CommsLink::PacketType::data);
+    QCOMPARE(receivedMsg->data, QByteArray("FILE"));
+    QVERIFY(link->decoder.isIdle());
+}
+
+void TestLink::testReceiveAfterBadCrc() {
+    QSignalSpy spy(&(*port), &QIODevice::readyRead);
+    connect(&(*link), &CommsLink::Link::packetReceived,
+            this, &TestLink::receiveMessage);
+    const quint8 frames[]{
+        // Corrupted CRC
+        0x16, 0x10, 0x02, 0x01, 0x10, 0x10, 0x10, 0x03, 0x00, 0x5D,
+        0x16, 0x10, 0x02, 0x01, 0x10, 0x10, 0x10, 0x03, 0x00, 0x5C
+    };
+    port->sendData(reinterpret_cast<const char *>(frames),
+                   sizeof(frames));
+    QVERIFY(spy.wait(250));
+    QCOMPARE(receivedCount, 1);
+    QCOMPARE(link->decoder.crcErrors(), quint64{1});
+    QVERIFY(receivedMsg->type == CommsLink::PacketType::linkRequest);
+}
+
+void TestLink::testReceiveWhileHeld() {
+    QSignalSpy spy(&(*port), &QIODevice::readyRead);
+    connect(&(*link), &CommsLink::Link::packetReceived,
+            this, &TestLink::receiveMessage);
+    const quint8 fileFrame[]{
+        0x16, 0x10, 0x02, 0x01, 0x19, 0x46, 0x49, 0x4C, 0x45,
+        0x10, 0x03, 0x2D, 0xBE
+    };
+    port->sendData(reinterpret_cast<const char *>(fileFrame),
+                   sizeof(fileFrame));
+    QVERIFY(spy.wait(250));
+    QCOMPARE(receivedCount, 1);
+    const auto held = receivedMsg;
+
+    // Go round the pool twice while the first message is still held.
+    const quint8 requestFrame[]{
+        0x16, 0x10, 0x02, 0x01, 0x10, 0x10, 0x10, 0x03, 0x00, 0x5C
+    };
+    QByteArray frames;
+    for (int i = 0; i < 2 * CommsLink::MessagePool::SIZE; i++) {
+        frames.append(reinterpret_cast<const char *>(requestFrame),
+                      sizeof(requestFrame));
+    }
+    port->sendData(frames.constData(), frames.size());
+    QVERIFY(spy.wait(250));
+    QCOMPARE(receivedCount, 1 + 2 * CommsLink::MessagePool::SIZE);
+    QVERIFY(receivedMsg->type == CommsLink::PacketType::linkRequest);
+    QVERIFY(held->type == CommsLink::PacketType::data);
+    QCOMPARE(held->data, QByteArray("FILE"));
+    // Holding one message mustn't have pushed the link off its pool.
+    QCOMPARE(link->pool.overflows(), quint64{0});
+}
+
+void TestLink::testMetrics() {
+    QSignalSpy written(&(*port), &QIODevice::bytesWritten);
+    QSignalSpy read(&(*port), &QIODevice::readyRead);
+    connect(&(*link), &CommsLink::Link::packetReceived,
+            this, &TestLink::receiveMessage);
+    const CommsLink::Message msg{
+        CommsLink::PacketType::data, QByteArray("A\x10", 2)
+    };
+    QVERIFY(link->send(msg));
+    QVERIFY(!link->send(msg));
+    QVERIFY(written.wait(250));
+    const quint8 frames[]{
+        // Corrupted CRC, then a good frame, then the start of another
+        0x16, 0x10, 0x02, 0x01, 0x10, 0x10, 0x10, 0x03, 0x00, 0x5D,
+        0x16, 0x10, 0x02, 0x01, 0x19, 0x46, 0x49, 0x4C, 0x45,
+        0x10, 0x03, 0x2D, 0xBE,
+        0x16, 0x10, 0x02, 0x01
+    };
+    port->sendData(reinterpret_cast<const char *>(frames), sizeof(frames));
+    QVERIFY(read.wait(250));
+    QCOMPARE(receivedCount, 1);
+    link->readTimeout();
+
+    const auto metrics = link->metrics().snapshot();
+    QCOMPARE(metrics.framesSent, quint64{1});
+    QCOMPARE(metrics.payloadBytesSent, quint64{2});
+    // The 0x10 is escaped.
+    QCOMPARE(metrics.wireBytesSent, quint64{12});
+    QCOMPARE(metrics.busyRejections, quint64{1});
+    QCOMPARE(metrics.framesReceived, quint64{1});
+    QCOMPARE(metrics.payloadBytesReceived, quint64{4});
+    QCOMPARE(metrics.wireBytesReceived, quint64{sizeof(frames)});
+    QCOMPARE(metrics.crcErrors, quint64{1});
+    QCOMPARE(metrics.readTimeouts, quint64{1});
+}
+
+void TestLink::testReadTimeout() {
+    using std::chrono::milliseconds;
+    CommsLink::VirtualClock clock;
+    link->setClock(clock);
+    connect(&(*link), &CommsLink::Link::packetReceived,
+            this, &TestLink::receiveMessage);
+    const quint8 linkRequest[]{
+        0x16, 0x10, 0x02, 0x01, 0x10, 0x10, 0x10, 0x03, 0x00, 0x5C
+    };
+    port->sendData(reinterpret_cast<const char *>(linkRequest), 5);
+    // The port reports the data through a queued signal, so let it arrive
+    // before time moves on.
+    QVERIFY(clock.runUntil([&] {
+        return link->readBuf.isEmpty() && !link->decoder.isIdle();
+    }, milliseconds{0}));
+    // A partial frame is discarded once 250 ms pass without more of it.
+    clock.advance(milliseconds{249});
+    QCOMPARE(link->metrics().snapshot().readTimeouts, quint64{0});
+    clock.advance(milliseconds{1});
+    QCOMPARE(link->metrics().snapshot().readTimeouts, quint64{1});
+    // Once, rather than every 250 ms after.
+    clock.advance(milliseconds{5000});
+    QCOMPARE(link->metrics().snapshot().readTimeouts, quint64{1});
+
+    // The next frame starts afresh.
+    port->sendData(reinterpret_cast<const char *>(linkRequest),
+                   sizeof(linkRequest));
+    QVERIFY(clock.runUntil([&] { return receivedCount == 1; },
+                           milliseconds{0}));
+    QVERIFY(receivedMsg->type == CommsLink::PacketType::linkRequest);
+    clock.advance(milliseconds{5000});
+    QCOMPARE(link->metrics().snapshot().readTimeouts, quint64{1});
+}
+
+void TestLink::testLatencyHistogram() {
+    CommsLink::LatencyHistogram histogram;
+    QCOMPARE(histogram.snapshot().percentile(50), qint64{0});
+    for (int i = 0; i < 98; i++) {
+        histogram.record(1000);
+    }
+    histogram.record(100000);
+    histogram.record(-5);
+    const auto snapshot = histogram.snapshot();
+    QCOMPARE(snapshot.count(), quint64{100});
+    QCOMPARE(snapshot.mean(), qint64{1980});
+    // 1000 µs falls in the bucket below 1024 µs.
+    QCOMPARE(snapshot.percentile(50), qint64{1024});
+    QCOMPARE(snapshot.percentile(99), qint64{1024});
+    QCOMPARE(snapshot.percentile(100), qint64{131072});
+}
@@ -13,12 +13,23 @@ class TestLink : public QObject
 private:
     std::unique_ptr<CommsLink::Link> link;
     std::unique_ptr<MockSerial> port;
-    std::unique_ptr<CommsLink::Message> receivedMsg;
+    CommsLink::MessageRef receivedMsg;
+    int receivedCount = 0;
 private slots:
     void testSendData();
     void testSendLinkRequest();
+    void testSendControlFrames();
+    void testSendConsecutive();
+    void testSendEscaped();
     void testReceiveData();
     void testReceiveMultipleReads();
+    void testReceiveAfterNoise();
+    void testReceiveMultipleFrames();
+    void testReceiveAfterBadCrc();
+    void testReceiveWhileHeld();
+    void testMetrics();
+    void testReadTimeout();
+    void testLatencyHistogram();
     void init();
-    void receiveMessage(CommsLink::Message);
+    void receiveMessage(CommsLink::MessageRef);
 };
@@ -0,0 +1,161 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QtEndian>
+#include <QtTest>
+
+#include "portmonitor.hpp"
+
+#include "testportmonitor.hpp"
+
+using namespace CommsLink;
+
+namespace {
+
+/// \brief Stands in for the platform's hotplug events; the tests emit its
+/// signals themselves.
+class StandInHotplugSource : public HotplugSource
+{
+public:
+    bool start() override {
+        started = true;
+        return true;
+    }
+    bool started = false;
+};
+
+/// \brief Return a udev broadcast carrying \p properties, laid out as udev
+/// does.
+QByteArray udevMessage(const QByteArray &properties) {
+    constexpr quint32 headerSize = 40;
+    QByteArray msg("libudev", 8);
+    for (const quint32 field : {0xfeedcafeu, headerSize, headerSize,
+                                static_cast<quint32>(properties.size())}) {
+        char bytes[4];
+        qToBigEndian(field, bytes);
+        msg.append(bytes, 4);
+    }
+    // udev's filter hashes, which we have no use for.
+    msg.append(headerSize - msg.size(), '\0');
+    msg.append(properties);
+    return msg;
+}
+}
+
+void TestPortMonitor::testHotplugDuringScan() {
+    auto *source = new StandInHotplugSource;
+    PortMonitor monitor(source);
+    QSignalSpy added(&monitor, &PortMonitor::portAdded);
+    QSignalSpy removed(&monitor, &PortMonitor::portRemoved);
+    monitor.start();
+    QVERIFY(source->started);
+    // The scan can't finish until we return to the event loop.
+    QVERIFY(!monitor.isEnumerated());
+
+    emit source->portAdded("ttyTEST0", "Test adapter");
+    QCOMPARE(added.count(), 1);
+    QCOMPARE(added.at(0).at(0).toString(), QString("ttyTEST0"));
+    QCOMPARE(added.at(0).at(1).toString(), QString("Test adapter"));
+    // Each port is only reported once.
+    emit source->portAdded("ttyTEST0", "Test adapter");
+    QCOMPARE(added.count(), 1);
+
+    QTRY_VERIFY(monitor.isEnumerated());
+    int reports = 0;
+    for (const auto &args : added) {
+        reports += args.at(0).toString() == "ttyTEST0" ? 1 : 0;
+    }
+    QCOMPARE(reports, 1);
+    QVERIFY(monitor.ports().contains("ttyTEST0"));
+
+    emit source->portRemoved("ttyTEST0");
+    QCOMPARE(removed.count(), 1);
+    QCOMPARE(removed.at(0).at(0).toString(), QString("ttyTEST0"));
+    QVERIFY(!monitor.ports().contains("ttyTEST0"));
+    // Nor is it reported gone twice.
+    emit source->portRemoved("ttyTEST0");
+    QCOMPARE(removed.count(), 1);
+}
+
+void TestPortMonitor::testRemovedDuringScan() {
+    auto *source = new StandInHotplugSource;
+    PortMonitor monitor(source);
+    QSignalSpy enumerated(&monitor, &PortMonitor::enumerated);
+    monitor.start();
+    emit source->portAdded("ttyTEST1", QString());
+    emit source->portRemoved("ttyTEST1");
+    QVERIFY(enumerated.wait());
+    QVERIFY(!monitor.ports().contains("ttyTEST1"));
+    QCOMPARE(enumerated.count(), 1);
+}
+
+void TestPortMonitor::testHotplugOfScannedPort() {
+    auto *source = new StandInHotplugSource;
+    PortMonitor monitor(source);
+    monitor.setScanner([] {
+        return QMap<QString, QString>{{"ttyTEST2", "Scanned adapter"}};
+    });
+    QSignalSpy added(&monitor, &PortMonitor::portAdded);
+    QSignalSpy removed(&monitor, &PortMonitor::portRemoved);
+    QSignalSpy enumerated(&monitor, &PortMonitor::enumerated);
+    monitor.start();
+    QVERIFY(enumerated.wait());
+    QCOMPARE(added.count(), 1);
+    QCOMPARE(added.at(0).at(0).toString(), QString("ttyTEST2"));
+    QCOMPARE(added.at(0).at(1).toString(), QString("Scanned adapter"));
+
+    // The hotplug source names ports as the scan does, so this is the same
+    // port rather than a second one, and unplugging it removes it.
+    emit source->portAdded("ttyTEST2", "Test adapter");
+    QCOMPARE(added.count(), 1);
+    emit source->portRemoved("ttyTEST2");
+    QCOMPARE(removed.count(), 1);
+    QVERIFY(monitor.ports().isEmpty());
+    emit source->portAdded("ttyTEST2", "Test adapter");
+    QCOMPARE(added.count(), 2);
+    QCOMPARE(monitor.ports(), QStringList{"ttyTEST2"});
+}
+
+void TestPortMonitor::testParseKernelUevent() {
+    const QByteArray msg("add@/devices/pci0000:00/usb1/1-1/ttyUSB0/tty/ttyUSB0\0"
+                         "ACTION=add\0"
+                         "DEVPATH=/devices/pci0000:00/usb1/1-1/ttyUSB0/tty/"
+                         "ttyUSB0\0"
+                         "SUBSYSTEM=tty\0"
+                         "DEVNAME=ttyUSB0\0"
+                         "SEQNUM=4242", 162);
+    Uevent event;
+    QVERIFY(parseUevent(msg.constData(), msg.size(), event));
+    QCOMPARE(event.action, QByteArray("add"));
+    QCOMPARE(event.properties.value("SUBSYSTEM"), QByteArray("tty"));
+    QCOMPARE(event.properties.value("DEVNAME"), QByteArray("ttyUSB0"));
+    QCOMPARE(ueventPortName(event), QString("ttyUSB0"));
+    // The last field needn't be terminated.
+    QCOMPARE(event.properties.value("SEQNUM"), QByteArray("4242"));
+}
+
+void TestPortMonitor::testParseUdevUevent() {
+    const auto msg = udevMessage(
+                QByteArray("ACTION=remove\0SUBSYSTEM=tty\0"
+                           "DEVNAME=/dev/ttyACM0\0ID_MODEL=3Fax_Link\0", 68));
+    Uevent event;
+    QVERIFY(parseUevent(msg.constData(), msg.size(), event));
+    QCOMPARE(event.action, QByteArray("remove"));
+    QCOMPARE(event.properties.value("DEVNAME"), QByteArray("/dev/ttyACM0"));
+    // Named as the scan names it.
+    QCOMPARE(ueventPortName(event), QString("ttyACM0"));
+    QCOMPARE(event.properties.value("ID_MODEL"), QByteArray("3Fax_Link"));
+}
+
+void TestPortMonitor::testParseMalformedUevent() {
+    Uevent event;
+    const QByteArray noAction("hello\0SUBSYSTEM=tty\0", 20);
+    QVERIFY(!parseUevent(noAction.constData(), noAction.size(), event));
+    // The properties run past the end of the message.
+    auto truncated = udevMessage(QByteArray("ACTION=add\0", 11));
+    truncated.chop(4);
+    QVERIFY(!parseUevent(truncated.constData(), truncated.size(), event));
+    auto badMagic = udevMessage(QByteArray("ACTION=add\0", 11));
+    badMagic[8] = 0;
+    QVERIFY(!parseUevent(badMagic.constData(), badMagic.size(), event));
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QObject>
+
+class TestPortMonitor : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testHotplugDuringScan();
+    void testRemovedDuringScan();
+    void testHotplugOfScannedPort();
+    void testParseKernelUevent();
+    void testParseUdevUevent();
+    void testParseMalformedUevent();
+};
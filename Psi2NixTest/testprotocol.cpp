@@ -3,17 +3,23 @@
 
 #include "testprotocol.hpp"
 
+using std::chrono::milliseconds;
+
 void TestProtocol::init() {
+    clock = std::make_unique<CommsLink::VirtualClock>();
     port = std::make_unique<MockSerial>();
     link = std::make_unique<CommsLink::Link>();
+    link->setClock(*clock);
     link->setPort(*port);
     protocol = std::make_unique<CommsLink::Protocol>();
+    protocol->setClock(*clock);
 }
 
 void TestProtocol::cleanup() {
     protocol.reset();
     link.reset();
     port.reset();
+    clock.reset();
 }
 
 void TestProtocol::testLinkRequestSent() {
@@ -23,7 +29,8 @@ void TestProtocol::testLinkRequestSent() {
     QVERIFY(spy.isValid());
     // Connect to our link.
     protocol->setLink(*link);
-    QVERIFY(spy.wait(1500));
+    QVERIFY(clock->runUntil([&spy] { return spy.count() > 0; },
+                            milliseconds{1500}));
     const quint8 expectedData[]{
         0x16, 0x10, 0x02,       // preamble
         0x01,                   // channel number
@@ -36,3 +43,231 @@ void TestProtocol::testLinkRequestSent() {
     const QByteArray &actual = port->sendBuf.buffer();
     QCOMPARE(actual, expected);
 }
+
+void TestProtocol::testQueueSendsBackToBack() {
+    port->setAutoAcknowledge(true);
+    protocol->setLink(*link);
+    const CommsLink::Message msg{
+        CommsLink::PacketType::data,
+                QByteArray("FILE")
+    };
+    int completed = 0;
+    for (int i = 0; i < 3; i++) {
+        QVERIFY(protocol->enqueue(msg, [&](bool sent) {
+            if (sent) {
+                completed++;
+            }
+        }));
+    }
+    QVERIFY(clock->runUntil([&completed] { return completed == 3; },
+                            milliseconds{500}));
+    QCOMPARE(protocol->queueLength(), 0);
+    const quint8 expectedData[]{
+        0x16, 0x10, 0x02, 0x01, 0x19,   // type 3, seq 1
+        0x46, 0x49, 0x4C, 0x45, 0x10, 0x03, 0x2D, 0xBE,
+        0x16, 0x10, 0x02, 0x01, 0x1A,   // type 3, seq 2
+        0x46, 0x49, 0x4C, 0x45, 0x10, 0x03, 0x69, 0xBE,
+        0x16, 0x10, 0x02, 0x01, 0x1B,   // type 3, seq 3
+        0x46, 0x49, 0x4C, 0x45, 0x10, 0x03, 0x54, 0x7E
+    };
+    QByteArray expected(reinterpret_cast<const char *>(expectedData),
+                        sizeof(expectedData));
+    QCOMPARE(port->sendBuf.buffer(), expected);
+}
+
+void TestProtocol::testBackpressure() {
+    protocol->setQueueLimits(4, 1, 3);
+    QSignalSpy spy(&*protocol, &CommsLink::Protocol::backpressure);
+    QVERIFY(spy.isValid());
+    port->setAutoAcknowledge(true);
+    protocol->setLink(*link);
+    const CommsLink::Message msg{
+        CommsLink::PacketType::data,
+                QByteArray("FILE")
+    };
+    for (int i = 0; i < 4; i++) {
+        QVERIFY(protocol->enqueue(msg));
+    }
+    QVERIFY(!protocol->enqueue(msg));
+    QCOMPARE(spy.count(), 1);
+    QCOMPARE(spy.at(0).at(0).toBool(), true);
+    QVERIFY(clock->runUntil([this] { return protocol->queueLength() == 0; },
+                            milliseconds{500}));
+    QCOMPARE(spy.count(), 2);
+    QCOMPARE(spy.at(1).at(0).toBool(), false);
+}
+
+void TestProtocol::testLinkRequestAcknowledged() {
+    port->setAutoAcknowledge(true);
+    protocol->setLink(*link);
+    QVERIFY(!protocol->isConnected());
+    QVERIFY(clock->runUntil([this] { return protocol->isConnected(); },
+                            milliseconds{1500}));
+}
+
+void TestProtocol::testConnectsWithoutWaiting() {
+    // The first request goes out as soon as the event loop runs, rather
+    // than on a timer.
+    port->setAutoAcknowledge(true);
+    protocol->setLink(*link);
+    QVERIFY(clock->runUntil([this] { return protocol->isConnected(); },
+                            milliseconds{0}));
+}
+
+void TestProtocol::testDisconnect() {
+    port->setAutoAcknowledge(true);
+    protocol->setLink(*link);
+    QVERIFY(clock->runUntil([this] { return protocol->isConnected(); },
+                            milliseconds{1500}));
+    QSignalSpy spy(&*protocol, &CommsLink::Protocol::connectionChanged);
+    bool disconnected = false;
+    protocol->disconnectDevice([&disconnected](bool sent) {
+        disconnected = sent;
+    });
+    QVERIFY(clock->runUntil([&disconnected] { return disconnected; },
+                            milliseconds{500}));
+    QVERIFY(!protocol->isConnected());
+    QCOMPARE(spy.count(), 1);
+    const quint8 frame[]{
+        0x16, 0x10, 0x02, 0x01, 0x08,   // type 1, seq 0
+        0x10, 0x03, 0x00, 0x56
+    };
+    const QByteArray expected(reinterpret_cast<const char *>(frame),
+                              sizeof(frame));
+    QVERIFY(port->sendBuf.buffer().endsWith(expected));
+}
+
+void TestProtocol::testRetransmitsWithoutAck() {
+    protocol->setLink(*link);
+    const CommsLink::Message msg{
+        CommsLink::PacketType::data,
+                QByteArray("FILE")
+    };
+    QVERIFY(protocol->enqueue(msg));
+    const quint8 frame[]{
+        0x16, 0x10, 0x02, 0x01, 0x19,   // type 3, seq 1
+        0x46, 0x49, 0x4C, 0x45, 0x10, 0x03, 0x2D, 0xBE
+    };
+    QByteArray expected(reinterpret_cast<const char *>(frame),
+                        sizeof(frame));
+    // Retransmitted with the same sequence number once the initial
+    // timeout has passed.
+    expected += expected;
+    QVERIFY(clock->runUntil([&] { return port->sendBuf.buffer() == expected; },
+                            milliseconds{2500}));
+    QCOMPARE(protocol->queueLength(), 1);
+    // That's exactly one initial timeout after the first was written.
+    QVERIFY(clock->now() == milliseconds{1000});
+}
+
+void TestProtocol::testRequestsBackOff() {
+    protocol->setLink(*link);
+    const quint8 frame[]{
+        0x16, 0x10, 0x02, 0x01, 0x10, 0x10, 0x10, 0x03, 0x00, 0x5C
+    };
+    const QByteArray request(reinterpret_cast<const char *>(frame),
+                             sizeof(frame));
+    // Nobody answers, so the interval doubles after each request: they go
+    // out at 0, 1, 3 and 7 seconds.
+    QVERIFY(clock->runUntil([&] {
+        return port->sendBuf.buffer() == request.repeated(4);
+    }, milliseconds{10000}));
+    QVERIFY(clock->now() == milliseconds{7000});
+    QVERIFY(!protocol->isConnected());
+}
+
+void TestProtocol::testDataAcknowledged() {
+    protocol->setLink(*link);
+    QByteArray payloads;
+    connect(&*protocol, &CommsLink::Protocol::dataReceived,
+            [&payloads](CommsLink::MessageRef msg) {
+        payloads.append(msg->data);
+    });
+    CommsLink::FrameEncoder encoder;
+    QVERIFY(encoder.encode(CommsLink::PacketType::data, 5, "FILE", 4));
+    const QByteArray frame(encoder.data(), static_cast<int>(encoder.size()));
+    // The same frame twice, as if the first acknowledgement were lost.
+    port->sendData(frame);
+    port->sendData(frame);
+    const quint8 ack[]{
+        0x16, 0x10, 0x02, 0x01, 0x05,   // type 0, seq 5
+        0x10, 0x03, 0xC1, 0x93
+    };
+    QByteArray expected(reinterpret_cast<const char *>(ack), sizeof(ack));
+    expected += expected;
+    QVERIFY(clock->runUntil([&] { return port->sendBuf.buffer() == expected; },
+                            milliseconds{500}));
+    QCOMPARE(payloads, QByteArray("FILE"));
+    QVERIFY(protocol->isConnected());
+}
+
+void TestProtocol::testAckWhileWriting() {
+    protocol->setLink(*link);
+    CommsLink::FrameEncoder encoder;
+    QVERIFY(encoder.encode(CommsLink::PacketType::acknowledge, 1,
+                           nullptr, 0));
+    // The acknowledgement is read before the write is reported complete.
+    port->sendData(encoder.data(), static_cast<qint64>(encoder.size()));
+    const CommsLink::Message msg{
+        CommsLink::PacketType::data,
+                QByteArray("FILE")
+    };
+    bool completed = false;
+    QVERIFY(protocol->enqueue(msg, [&completed](bool sent) {
+        completed = sent;
+    }));
+    const auto written = port->sendBuf.buffer();
+    QVERIFY(clock->runUntil([&completed] { return completed; },
+                            milliseconds{0}));
+    // Nor is the frame sent again.
+    clock->runUntil([] { return false; }, milliseconds{5000});
+    QCOMPARE(port->sendBuf.buffer(), written);
+}
+
+void TestProtocol::testLinkRequestAckJumpsQueue() {
+    protocol->setLink(*link);
+    const CommsLink::Message msg{
+        CommsLink::PacketType::data,
+                QByteArray("FILE")
+    };
+    for (int i = 0; i < 3; i++) {
+        QVERIFY(protocol->enqueue(msg));
+    }
+    QVERIFY(clock->runUntil([&] {
+        return !port->sendBuf.buffer().isEmpty();
+    }, milliseconds{0}));
+    const auto dataFrame = port->sendBuf.buffer();
+    const quint8 request[]{
+        0x16, 0x10, 0x02, 0x01, 0x10, 0x10, 0x10, 0x03, 0x00, 0x5C
+    };
+    port->sendData(reinterpret_cast<const char *>(request), sizeof(request));
+    // Answered straight away, although the data is still waiting for its
+    // acknowledgement.
+    CommsLink::FrameEncoder encoder;
+    QVERIFY(encoder.encode(CommsLink::PacketType::acknowledge, 0,
+                           nullptr, 0));
+    const auto expected = dataFrame + QByteArray(
+                encoder.data(), static_cast<int>(encoder.size()));
+    QVERIFY(clock->runUntil([&] { return port->sendBuf.buffer() == expected; },
+                            milliseconds{0}));
+    QCOMPARE(protocol->queueLength(), 3);
+}
+
+void TestProtocol::testRttEstimator() {
+    using std::chrono::microseconds;
+    CommsLink::RttEstimator rtt;
+    QVERIFY(rtt.timeout() == milliseconds{1000});
+    rtt.addSample(microseconds{100000});
+    // SRTT + 4 * RTTVAR, where RTTVAR starts at half the first sample.
+    QVERIFY(rtt.timeout() == milliseconds{300});
+    for (int i = 0; i < 50; i++) {
+        rtt.addSample(microseconds{100000});
+    }
+    QVERIFY(rtt.timeout() == milliseconds{100});
+    rtt.backoff();
+    QVERIFY(rtt.timeout() == milliseconds{200});
+    for (int i = 0; i < 10; i++) {
+        rtt.backoff();
+    }
+    QVERIFY(rtt.timeout() == milliseconds{8000});
+}
@@ -3,6 +3,7 @@
 #include <memory>
 #include <QObject>
 
+#include "clock.hpp"
 #include "protocol.hpp"
 #include "mockserial.hpp"
 
@@ -10,6 +11,7 @@ class TestProtocol : public QObject
 {
     Q_OBJECT
 private:
+    std::unique_ptr<CommsLink::VirtualClock> clock;
     std::unique_ptr<MockSerial> port;
     std::unique_ptr<CommsLink::Link> link;
     std::unique_ptr<CommsLink::Protocol> protocol;
@@ -18,4 +20,15 @@ private slots:
     void init();
     void cleanup();
     void testLinkRequestSent();
+    void testQueueSendsBackToBack();
+    void testBackpressure();
+    void testLinkRequestAcknowledged();
+    void testConnectsWithoutWaiting();
+    void testDisconnect();
+    void testRetransmitsWithoutAck();
+    void testRequestsBackOff();
+    void testDataAcknowledged();
+    void testAckWhileWriting();
+    void testLinkRequestAckJumpsQueue();
+    void testRttEstimator();
 };
@@ -0,0 +1,121 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QtTest>
+#include <QBuffer>
+
+#include "recordconverter.hpp"
+#include "recordstream.hpp"
+
+#include "testrecordconverter.hpp"
+
+using namespace CommsLink;
+
+namespace {
+// Convert text in pieces of the given size.
+QList<QByteArray> convert(const QByteArray &text, int pieceSize,
+                          qint64 *sourceBytes = nullptr) {
+    RecordConverter converter;
+    QVector<Record> records;
+    for (int pos = 0; pos < text.size(); pos += pieceSize) {
+        const auto length = std::min(pieceSize, text.size() - pos);
+        converter.convert(text.constData() + pos, length, records);
+    }
+    converter.finish(records);
+    QList<QByteArray> result;
+    qint64 total = 0;
+    for (const auto &record : records) {
+        result.append(record.data);
+        total += record.sourceBytes;
+    }
+    if (sourceBytes != nullptr) {
+        *sourceBytes = total;
+    }
+    return result;
+}
+}
+
+void TestRecordConverter::testFindLineEnd() {
+    // Put the line ending at every position within and beyond a vector's
+    // width.
+    for (int size = 0; size < 40; size++) {
+        for (int at = 0; at <= size; at++) {
+            QByteArray data(size, 'x');
+            if (at < size) {
+                data[at] = (at % 2) ? '\r' : '\n';
+            }
+            QCOMPARE(RecordConverter::findLineEnd(data.constData(), size),
+                     qint64{at});
+        }
+    }
+}
+
+void TestRecordConverter::testLineEndings_data() {
+    QTest::addColumn<int>("pieceSize");
+    for (int pieceSize : {1, 2, 3, 7, 1000}) {
+        QTest::newRow(qPrintable(QString("%1-byte pieces").arg(pieceSize)))
+                << pieceSize;
+    }
+}
+
+void TestRecordConverter::testLineEndings() {
+    QFETCH(int, pieceSize);
+    const QByteArray text("one\ntwo\r\nthree\rfour\n\nsix\r\n\r\neight");
+    const QList<QByteArray> expected{
+        "one", "two", "three", "four", "", "six", "", "eight"
+    };
+    qint64 sourceBytes = 0;
+    QCOMPARE(convert(text, pieceSize, &sourceBytes), expected);
+    QCOMPARE(sourceBytes, qint64{text.size()});
+    // A final line ending doesn't make an extra record.
+    QCOMPARE(convert("one\r\n", pieceSize),
+             (QList<QByteArray>{"one"}));
+}
+
+void TestRecordConverter::testLongLines() {
+    const QByteArray exact(RecordConverter::MAX_RECORD, 'a');
+    const QByteArray longer(2 * RecordConverter::MAX_RECORD + 1, 'b');
+    RecordConverter converter;
+    QVector<Record> records;
+    const auto text = exact + "\n" + longer + "\n";
+    converter.convert(text.constData(), text.size(), records);
+    converter.finish(records);
+    QCOMPARE(records.size(), 4);
+    QCOMPARE(records[0].data, exact);
+    QCOMPARE(records[1].data, longer.left(RecordConverter::MAX_RECORD));
+    QCOMPARE(records[2].data, longer.mid(RecordConverter::MAX_RECORD,
+                                         RecordConverter::MAX_RECORD));
+    QCOMPARE(records[3].data, QByteArray("b"));
+    QCOMPARE(converter.splitLines(), qint64{1});
+}
+
+void TestRecordConverter::testStream() {
+    QByteArray text;
+    QList<QByteArray> expected;
+    for (int i = 0; text.size() < 3 * RecordStream::CHUNK_SIZE; i++) {
+        expected.append(QByteArray::number(i * 7919));
+        text.append(expected.last()).append("\r\n");
+    }
+    QBuffer buffer(&text);
+    QVERIFY(buffer.open(QIODevice::ReadOnly));
+    RecordStream stream(buffer);
+    int ready = 0;
+    connect(&stream, &RecordStream::recordsReady, [&ready] { ready++; });
+    stream.start();
+    QList<QByteArray> records;
+    qint64 sourceBytes = 0;
+    while (!stream.atEnd()) {
+        Record record;
+        if (stream.take(record)) {
+            records.append(record.data);
+            sourceBytes += record.sourceBytes;
+        } else {
+            // Wait for the next piece.
+            const int before = ready;
+            QTRY_VERIFY(ready > before || stream.isReady());
+        }
+    }
+    QVERIFY(!stream.hasError());
+    QCOMPARE(records, expected);
+    QCOMPARE(sourceBytes, qint64{text.size()});
+}
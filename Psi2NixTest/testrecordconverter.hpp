@@ -0,0 +1,15 @@
+#pragma once
+
+#include <QObject>
+
+class TestRecordConverter : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFindLineEnd();
+    void testLineEndings_data();
+    void testLineEndings();
+    void testLongLines();
+    void testStream();
+};
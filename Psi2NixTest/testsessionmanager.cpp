@@ -0,0 +1,81 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QtTest>
+#include <QTemporaryFile>
+
+#include "sessionmanager.hpp"
+
+#include "mockserial.hpp"
+
+#include "testsessionmanager.hpp"
+
+using namespace CommsLink;
+
+void TestSessionManager::testThreadCount() {
+    SessionManager defaultManager;
+    QVERIFY(defaultManager.threadCount() >= 1);
+    QVERIFY(defaultManager.threadCount() <= 4);
+    SessionManager manager(2);
+    QCOMPARE(manager.threadCount(), 2);
+}
+
+void TestSessionManager::testPortsFailIndependently() {
+    // Ports that can't be opened fail their files straight away, and each
+    // reports its own status.
+    SessionManager manager(2);
+    QHash<QString, SessionStatus> latest;
+    connect(&manager, &SessionManager::statusChanged,
+            [&latest](const QString &portName, SessionStatus status) {
+        latest.insert(portName, status);
+    });
+    const QStringList portNames{"psi2nix-none-a", "psi2nix-none-b",
+                                "psi2nix-none-c"};
+    for (const auto &portName : portNames) {
+        QVERIFY(manager.open(portName, 9600) != nullptr);
+    }
+    QCOMPARE(manager.portNames(), portNames);
+    QVERIFY(manager.sendFile("a", "A"));
+    QVERIFY(manager.sendFile("b", "B"));
+    for (const auto &portName : portNames) {
+        QTRY_COMPARE(latest.value(portName).filesFailed, 2);
+        QCOMPARE(latest.value(portName).filesSent, 0);
+        QCOMPARE(latest.value(portName).filesPending, 0);
+        QVERIFY(!latest.value(portName).portOpen);
+    }
+    manager.close("psi2nix-none-b");
+    QCOMPARE(manager.portNames(),
+             (QStringList{"psi2nix-none-a", "psi2nix-none-c"}));
+    QVERIFY(manager.session("psi2nix-none-b") == nullptr);
+}
+
+void TestSessionManager::testStalledDeviceDoesNotHoldUpOthers() {
+    // Three devices sharing one I/O thread, one of which never answers.
+    SessionManager manager(1);
+    manager.setPortFactory([](const QString &portName) {
+        auto *port = new MockSerial;
+        port->setAutoAcknowledge(portName != "silent");
+        return port;
+    });
+    QTemporaryFile source;
+    QVERIFY(source.open());
+    source.write(QByteArray(3000, 'x'));
+    source.flush();
+    const QStringList portNames{"answers-a", "silent", "answers-b"};
+    for (const auto &portName : portNames) {
+        QVERIFY(manager.open(portName, 9600) != nullptr);
+    }
+    QVERIFY(manager.sendFile(source.fileName(), "TEST.ODB"));
+    for (const auto &portName : {"answers-a", "answers-b"}) {
+        const auto session = manager.session(portName);
+        QTRY_COMPARE(session->status().filesSent, 1);
+        QCOMPARE(session->status().filesPending, 0);
+        QVERIFY(session->status().connected);
+    }
+    const auto silent = manager.session("silent")->status();
+    QVERIFY(silent.portOpen);
+    QVERIFY(!silent.connected);
+    QVERIFY(silent.transferring);
+    QCOMPARE(silent.filesSent, 0);
+    QCOMPARE(silent.filesPending, 1);
+}
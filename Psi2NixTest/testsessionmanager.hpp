@@ -0,0 +1,13 @@
+#pragma once
+
+#include <QObject>
+
+class TestSessionManager : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testThreadCount();
+    void testPortsFailIndependently();
+    void testStalledDeviceDoesNotHoldUpOthers();
+};
@@ -0,0 +1,180 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QtTest>
+#include <QSignalSpy>
+#include <QTemporaryFile>
+
+#include "clock.hpp"
+#include "filetransfer.hpp"
+#include "link.hpp"
+#include "protocol.hpp"
+
+#include "testsimulatedorganiser.hpp"
+
+using namespace CommsLink;
+using std::chrono::milliseconds;
+using std::chrono::seconds;
+
+namespace {
+QByteArray makeContents(int size) {
+    QByteArray contents;
+    for (int i = 0; i < size; i++) {
+        contents.append(static_cast<char>(i % 7 == 0 ? 0x10 : i & 0xff));
+    }
+    return contents;
+}
+}
+
+bool TestSimulatedOrganiser::transfer(SimulatedOrganiser &device,
+                                      VirtualClock &clock,
+                                      const QByteArray &contents,
+                                      std::chrono::milliseconds timeout) {
+    QTemporaryFile source;
+    if (!source.open()) {
+        return false;
+    }
+    source.write(contents);
+    source.flush();
+    device.setClock(clock);
+    Link link;
+    link.setClock(clock);
+    link.setPort(device);
+    Protocol protocol;
+    protocol.setClock(clock);
+    protocol.setLink(link);
+    FileTransfer fileTransfer(protocol);
+    QSignalSpy finished(&fileTransfer, &FileTransfer::finished);
+    if (!fileTransfer.start(source.fileName(), "TEST.ODB")
+            || !clock.runUntil([&finished] { return finished.count() > 0; },
+                               timeout)) {
+        return false;
+    }
+    return finished.at(0).at(0).toBool();
+}
+
+void TestSimulatedOrganiser::testTransfer() {
+    SimulatedOrganiser::Config config;
+    config.baudRate = 0;
+    config.turnaround = std::chrono::microseconds{0};
+    SimulatedOrganiser device(config);
+    VirtualClock clock;
+    const auto contents = makeContents(3000);
+    QVERIFY(transfer(device, clock, contents, seconds{5}));
+    QCOMPARE(device.files().size(), 1);
+    QCOMPARE(device.files().value("TEST.ODB"), contents);
+    QCOMPARE(device.bytesStored(), qint64{contents.size()});
+}
+
+void TestSimulatedOrganiser::testPacing() {
+    SimulatedOrganiser::Config config;
+    config.baudRate = 9600;
+    SimulatedOrganiser device(config);
+    VirtualClock clock;
+    const auto contents = makeContents(200);
+    QVERIFY(transfer(device, clock, contents, seconds{5}));
+    // The file alone takes over 200 ms at 9600 baud.
+    QVERIFY(clock.now() >= milliseconds{200 * 10 * 1000 / 9600});
+    QCOMPARE(device.files().value("TEST.ODB"), contents);
+}
+
+void TestSimulatedOrganiser::testLongTransfer() {
+    // Minutes on the line, which take no time on a virtual clock.
+    SimulatedOrganiser::Config config;
+    config.baudRate = 9600;
+    config.capacity = 256 * 1024;
+    SimulatedOrganiser device(config);
+    VirtualClock clock;
+    const auto contents = makeContents(256 * 1024);
+    QVERIFY(transfer(device, clock, contents, std::chrono::minutes{10}));
+    QVERIFY(clock.now() >= seconds{256 * 1024 * 10 / 9600});
+    QCOMPARE(device.files().value("TEST.ODB"), contents);
+}
+
+void TestSimulatedOrganiser::testCapacity() {
+    SimulatedOrganiser::Config config;
+    config.baudRate = 0;
+    config.turnaround = std::chrono::microseconds{0};
+    config.capacity = 1000;
+    SimulatedOrganiser device(config);
+    VirtualClock clock;
+    QVERIFY(!transfer(device, clock, makeContents(3000), seconds{20}));
+    QVERIFY(device.bytesStored() <= 1000);
+    QVERIFY(device.files().isEmpty());
+    // The partial file is abandoned, and its room reclaimed, by the next.
+    const auto contents = makeContents(900);
+    QVERIFY(transfer(device, clock, contents, seconds{20}));
+    QCOMPARE(device.bytesStored(), qint64{contents.size()});
+}
+
+void TestSimulatedOrganiser::testOverwrite() {
+    SimulatedOrganiser::Config config;
+    config.baudRate = 0;
+    config.turnaround = std::chrono::microseconds{0};
+    config.capacity = 1000;
+    SimulatedOrganiser device(config);
+    VirtualClock clock;
+    QVERIFY(transfer(device, clock, makeContents(700), seconds{20}));
+    // The old file takes up room until the new one replaces it.
+    const auto smaller = makeContents(200);
+    QVERIFY(transfer(device, clock, smaller, seconds{20}));
+    QCOMPARE(device.bytesStored(), qint64{200});
+    QCOMPARE(device.files().value("TEST.ODB"), smaller);
+    const auto larger = makeContents(750);
+    QVERIFY(transfer(device, clock, larger, seconds{20}));
+    QCOMPARE(device.bytesStored(), qint64{750});
+    QCOMPARE(device.files().value("TEST.ODB"), larger);
+}
+
+void TestSimulatedOrganiser::testRemove() {
+    SimulatedOrganiser::Config config;
+    config.baudRate = 0;
+    config.turnaround = std::chrono::microseconds{0};
+    SimulatedOrganiser device(config);
+    VirtualClock clock;
+    device.setClock(clock);
+    QTemporaryFile source;
+    QVERIFY(source.open());
+    source.write("PROC A:");
+    source.flush();
+    Link link;
+    link.setClock(clock);
+    link.setPort(device);
+    Protocol protocol;
+    protocol.setClock(clock);
+    protocol.setLink(link);
+    FileTransfer fileTransfer(protocol);
+    QSignalSpy finished(&fileTransfer, &FileTransfer::finished);
+    QVERIFY(fileTransfer.start(source.fileName(), "A.OPL"));
+    QVERIFY(clock.runUntil([&finished] { return finished.count() > 0; },
+                           seconds{5}));
+    QVERIFY(finished.at(0).at(0).toBool());
+    QCOMPARE(fileTransfer.bytesStored(), qint64{7});
+    QCOMPARE(device.files().size(), 1);
+
+    // A deletion goes through the same sequence as the file did.
+    const Message remove{PacketType::data,
+                         QByteArray(1, static_cast<char>(FileOp::remove))
+                         + "A.OPL"};
+    bool removed = false;
+    QVERIFY(protocol.enqueue(remove, [&removed](bool sent) {
+        removed = sent;
+    }));
+    QVERIFY(clock.runUntil([&removed] { return removed; }, seconds{5}));
+    QVERIFY(device.files().isEmpty());
+    QCOMPARE(device.bytesStored(), qint64{0});
+}
+
+void TestSimulatedOrganiser::testBitErrors() {
+    // The protocol should retransmit its way past occasional errors.
+    SimulatedOrganiser::Config config;
+    config.baudRate = 0;
+    config.turnaround = std::chrono::microseconds{0};
+    config.bitErrorRate = 1e-4;
+    config.seed = 42;
+    SimulatedOrganiser device(config);
+    VirtualClock clock;
+    const auto contents = makeContents(3000);
+    QVERIFY(transfer(device, clock, contents, seconds{30}));
+    QCOMPARE(device.files().value("TEST.ODB"), contents);
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <QObject>
+
+#include <chrono>
+
+#include "clock.hpp"
+#include "simulatedorganiser.hpp"
+
+class TestSimulatedOrganiser : public QObject
+{
+    Q_OBJECT
+
+private:
+    /// \brief Send \p contents to \p device as TEST.ODB, with everything
+    /// on \p clock; return whether the transfer succeeded.
+    bool transfer(SimulatedOrganiser &device, CommsLink::VirtualClock &clock,
+                  const QByteArray &contents,
+                  std::chrono::milliseconds timeout);
+
+private slots:
+    void testTransfer();
+    void testPacing();
+    void testLongTransfer();
+    void testCapacity();
+    void testOverwrite();
+    void testRemove();
+    void testBitErrors();
+};
@@ -0,0 +1,55 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QtTest>
+
+#include <thread>
+
+#include "spscqueue.hpp"
+
+#include "testspscqueue.hpp"
+
+using namespace CommsLink;
+
+void TestSpscQueue::testFillAndDrain() {
+    SpscQueue<QByteArray, 4> queue;
+    QVERIFY(queue.isEmpty());
+    // Go round more than once, so that the indices wrap.
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 4; i++) {
+            QVERIFY(queue.push(QByteArray::number(i)));
+        }
+        QVERIFY(!queue.push(QByteArray("overflow")));
+        QByteArray value;
+        for (int i = 0; i < 4; i++) {
+            QVERIFY(queue.pop(value));
+            QCOMPARE(value, QByteArray::number(i));
+        }
+        QVERIFY(!queue.pop(value));
+        QVERIFY(queue.isEmpty());
+    }
+}
+
+void TestSpscQueue::testAcrossThreads() {
+    constexpr int count = 100000;
+    SpscQueue<int, 64> queue;
+    std::thread producer([&queue] {
+        for (int i = 0; i < count; i++) {
+            while (!queue.push(i)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    int expected = 0;
+    while (expected < count) {
+        int value;
+        if (queue.pop(value)) {
+            QCOMPARE(value, expected);
+            expected++;
+        } else {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    QVERIFY(queue.isEmpty());
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+#include <QObject>
+
+class TestSpscQueue : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testFillAndDrain();
+    void testAcrossThreads();
+};
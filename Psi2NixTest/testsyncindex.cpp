@@ -0,0 +1,135 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QtTest>
+#include <QCryptographicHash>
+#include <QTemporaryDir>
+
+#include "syncindex.hpp"
+
+#include "testsyncindex.hpp"
+
+using namespace CommsLink;
+
+namespace {
+// Write a file, giving it a fixed modification time so that changes to
+// its contents can be made with or without one to its time.
+QString writeFile(const QTemporaryDir &dir, const QString &name,
+                  const QByteArray &contents, qint64 modified) {
+    const auto path = dir.filePath(name);
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly)) {
+        return {};
+    }
+    file.write(contents);
+    // Flush first, or the write would set the time again.
+    file.flush();
+    file.setFileTime(QDateTime::fromMSecsSinceEpoch(modified),
+                     QFileDevice::FileModificationTime);
+    return path;
+}
+
+constexpr qint64 JAN_2019 = 1546300800000;
+}
+
+void TestSyncIndex::testChangedFilesNeedSending() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    SyncIndex index(dir.filePath("index.json"));
+    QVector<SyncFile> files{
+        {writeFile(dir, "a.opl", "PROC A:", JAN_2019), "A.OPL", {}, 0, 0},
+        {writeFile(dir, "b.opl", "PROC B:", JAN_2019), "B.OPL", {}, 0, 0}
+    };
+    index.refresh(files);
+    QCOMPARE(index.lastHashed(), 2);
+    QCOMPARE(files[0].hash, QCryptographicHash::hash(
+                 "PROC A:", QCryptographicHash::Sha256).toHex());
+    QCOMPARE(files[0].size, qint64{7});
+    QCOMPARE(files[0].modified, JAN_2019);
+    QVERIFY(index.needsSending("dev", files[0]));
+    index.recordSent("dev", files[0]);
+    index.recordSent("dev", files[1]);
+    QVERIFY(!index.needsSending("dev", files[0]));
+
+    // Change one file's contents and time.
+    writeFile(dir, "b.opl", "PROC B2:", JAN_2019 + 1000);
+    index.refresh(files);
+    QCOMPARE(index.lastHashed(), 1);
+    QVERIFY(!index.needsSending("dev", files[0]));
+    QVERIFY(index.needsSending("dev", files[1]));
+
+    // A missing file always needs attention.
+    QFile::remove(files[0].path);
+    index.refresh(files);
+    QVERIFY(files[0].hash.isEmpty());
+    QVERIFY(index.needsSending("dev", files[0]));
+}
+
+void TestSyncIndex::testUnchangedFilesAreNotRehashed() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    SyncIndex index(dir.filePath("index.json"));
+    QVector<SyncFile> files;
+    for (int i = 0; i < 32; i++) {
+        files.append({writeFile(dir, QString("f%1").arg(i),
+                                QByteArray(1000 + i, char('a' + i % 26)),
+                                JAN_2019), {}, {}, 0, 0});
+        files.last().remoteName = QByteArray::number(i);
+    }
+    index.refresh(files);
+    QCOMPARE(index.lastHashed(), files.size());
+    for (const auto &file : files) {
+        QCOMPARE(file.hash, SyncIndex::hashFile(file.path));
+    }
+    index.refresh(files);
+    QCOMPARE(index.lastHashed(), 0);
+
+    // Same size and time: taken on trust, as make and rsync do.
+    writeFile(dir, "f0", QByteArray(1000, 'z'), JAN_2019);
+    index.refresh(files);
+    QCOMPARE(index.lastHashed(), 0);
+}
+
+void TestSyncIndex::testDevicesAreSeparate() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    SyncIndex index(dir.filePath("index.json"));
+    QVector<SyncFile> files{
+        {writeFile(dir, "a.opl", "PROC A:", JAN_2019), "A.OPL", {}, 0, 0}
+    };
+    index.refresh(files);
+    index.recordSent("one", files[0]);
+    QVERIFY(!index.needsSending("one", files[0]));
+    QVERIFY(index.needsSending("two", files[0]));
+    index.forgetDevice("one");
+    QVERIFY(index.needsSending("one", files[0]));
+}
+
+void TestSyncIndex::testPersistence() {
+    QTemporaryDir dir;
+    QVERIFY(dir.isValid());
+    const auto indexPath = dir.filePath("sub/index.json");
+    QVector<SyncFile> files{
+        {writeFile(dir, "a.opl", "PROC A:", JAN_2019), "A.OPL", {}, 0, 0}
+    };
+    {
+        SyncIndex index(indexPath);
+        QVERIFY(index.load());
+        index.refresh(files);
+        index.recordSent("dev", files[0]);
+        QVERIFY(index.save());
+    }
+    SyncIndex index(indexPath);
+    QVERIFY(index.load());
+    index.refresh(files);
+    // Both the hash and the record of sending survive.
+    QCOMPARE(index.lastHashed(), 0);
+    QVERIFY(!index.needsSending("dev", files[0]));
+
+    QFile corrupt(indexPath);
+    QVERIFY(corrupt.open(QIODevice::WriteOnly));
+    corrupt.write("{not json");
+    corrupt.close();
+    QVERIFY(!index.load());
+    QVERIFY(index.needsSending("dev", files[0]));
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include <QObject>
+
+class TestSyncIndex : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testChangedFilesNeedSending();
+    void testUnchangedFilesAreNotRehashed();
+    void testDevicesAreSeparate();
+    void testPersistence();
+};
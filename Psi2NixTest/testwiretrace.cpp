@@ -0,0 +1,181 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include <QBuffer>
+#include <QtTest>
+
+#include "frameencoder.hpp"
+#include "link.hpp"
+#include "mockserial.hpp"
+#include "tracereplayer.hpp"
+#include "wiretrace.hpp"
+
+#include "testwiretrace.hpp"
+
+using namespace CommsLink;
+
+namespace {
+// Return the wire form of a message.
+QByteArray frame(PacketType type, quint8 seq, const QByteArray &data) {
+    FrameEncoder encoder;
+    encoder.encode(type, seq, data.constData(), data.size());
+    return QByteArray(encoder.data(), static_cast<int>(encoder.size()));
+}
+
+// Write records to a trace and read them back.
+QVector<TraceRecord> roundTrip(const QVector<TraceRecord> &records) {
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    WireTraceWriter writer(buffer);
+    writer.start();
+    for (const auto &record : records) {
+        writer.record(record.direction, record.timestamp,
+                      record.data.constData(), record.data.size());
+    }
+    buffer.seek(0);
+    WireTraceReader reader(buffer);
+    if (!reader.start()) {
+        return {};
+    }
+    return reader.readAll();
+}
+}
+
+void TestWireTrace::testRoundTrip() {
+    const QVector<TraceRecord> records{
+        {TraceDirection::sent, 0, QByteArray("\x16\x10\x02", 3)},
+        {TraceDirection::received, 150, QByteArray(300, 'x')},
+        {TraceDirection::received, 150, QByteArray()},
+        {TraceDirection::sent, 5000000000, QByteArray("A")}
+    };
+    const auto readBack = roundTrip(records);
+    QCOMPARE(readBack.size(), records.size());
+    for (int i = 0; i < records.size(); i++) {
+        QVERIFY(readBack.at(i).direction == records.at(i).direction);
+        QCOMPARE(readBack.at(i).timestamp, records.at(i).timestamp);
+        QCOMPARE(readBack.at(i).data, records.at(i).data);
+    }
+}
+
+void TestWireTrace::testCorruptTrace() {
+    QBuffer notATrace;
+    notATrace.setData("hello");
+    notATrace.open(QIODevice::ReadOnly);
+    WireTraceReader badHeader(notATrace);
+    QVERIFY(!badHeader.start());
+    QVERIFY(badHeader.isCorrupt());
+
+    // A record that claims more data than there is.
+    QBuffer truncated;
+    truncated.setData(QByteArray("P2NT\x01\x00\x10" "ab", 9));
+    truncated.open(QIODevice::ReadOnly);
+    WireTraceReader reader(truncated);
+    QVERIFY(reader.start());
+    TraceRecord record;
+    QVERIFY(!reader.next(record));
+    QVERIFY(reader.isCorrupt());
+}
+
+void TestWireTrace::testLinkRecordsTraffic() {
+    QBuffer buffer;
+    buffer.open(QIODevice::ReadWrite);
+    WireTraceWriter writer(buffer);
+    QVERIFY(writer.start());
+    MockSerial port;
+    Link link;
+    link.setPort(port);
+    link.setTrace(&writer);
+    QVERIFY(link.send(Message{PacketType::data, QByteArray("FILE")}));
+    const auto incoming = frame(PacketType::acknowledge, 1, {});
+    int received = 0;
+    connect(&link, &Link::packetReceived, [&received](const MessageRef &) {
+        received++;
+    });
+    port.sendData(incoming);
+    QTRY_COMPARE(received, 1);
+
+    buffer.seek(0);
+    WireTraceReader reader(buffer);
+    QVERIFY(reader.start());
+    const auto records = reader.readAll();
+    QVERIFY(!reader.isCorrupt());
+    QCOMPARE(records.size(), 2);
+    QVERIFY(records.at(0).direction == TraceDirection::sent);
+    QCOMPARE(records.at(0).data, port.sendBuf.buffer());
+    QVERIFY(records.at(1).direction == TraceDirection::received);
+    QCOMPARE(records.at(1).data, incoming);
+    QVERIFY(records.at(1).timestamp >= records.at(0).timestamp);
+}
+
+void TestWireTrace::testAnomalies() {
+    const auto data = frame(PacketType::data, 1, "FILE");
+    const auto ack = frame(PacketType::acknowledge, 1, {});
+    const QVector<TraceRecord> records{
+        {TraceDirection::sent, 0, data},
+        {TraceDirection::sent, 1500000, data},
+        {TraceDirection::received, 2600000, ack.left(4)},
+        {TraceDirection::received, 3000000, ack.mid(4)}
+    };
+    const auto anomalies = findTraceAnomalies(records);
+    QCOMPARE(anomalies.size(), 3);
+    QVERIFY(anomalies.at(0).kind == TraceAnomaly::Kind::retransmission);
+    QCOMPARE(anomalies.at(0).record, 1);
+    QVERIFY(anomalies.at(1).kind == TraceAnomaly::Kind::slowResponse);
+    QCOMPARE(anomalies.at(1).record, 2);
+    QCOMPARE(anomalies.at(1).delay, qint64{1100000});
+    QVERIFY(anomalies.at(2).kind == TraceAnomaly::Kind::stalledFrame);
+    QCOMPARE(anomalies.at(2).record, 3);
+    QCOMPARE(anomalies.at(2).delay, qint64{400000});
+}
+
+void TestWireTrace::testRetransmissions() {
+    const auto data = frame(PacketType::data, 2, "FILE");
+    const auto ack = frame(PacketType::acknowledge, 2, {});
+    const auto deviceData = frame(PacketType::data, 5, "DATA");
+    const auto ourAck = frame(PacketType::acknowledge, 5, {});
+    const QVector<TraceRecord> records{
+        // Acknowledging the device's frames twice is no retransmission.
+        {TraceDirection::received, 0, deviceData},
+        {TraceDirection::sent, 1000, ourAck},
+        {TraceDirection::received, 2000, deviceData},
+        {TraceDirection::sent, 3000, ourAck},
+        // Nor is sending the same frame once it's been acknowledged.
+        {TraceDirection::sent, 4000, data},
+        {TraceDirection::received, 5000, ack},
+        {TraceDirection::sent, 6000, data},
+        // But sending it again before then is, whatever came in between.
+        {TraceDirection::received, 7000, deviceData},
+        {TraceDirection::sent, 8000, data}
+    };
+    const auto anomalies = findTraceAnomalies(records);
+    QCOMPARE(anomalies.size(), 1);
+    QVERIFY(anomalies.at(0).kind == TraceAnomaly::Kind::retransmission);
+    QCOMPARE(anomalies.at(0).record, 8);
+}
+
+void TestWireTrace::testReplay() {
+    QVector<TraceRecord> records;
+    for (int i = 0; i < 20; i++) {
+        records.append({TraceDirection::sent, i * 10000,
+                        frame(PacketType::acknowledge,
+                              static_cast<quint8>(i % 8), {})});
+        records.append({TraceDirection::received, i * 10000 + 5000,
+                        frame(PacketType::data, static_cast<quint8>(i % 8),
+                              QByteArray(100, static_cast<char>(i)))});
+    }
+    for (double timeScale : {0.0, 0.1}) {
+        MockSerial port;
+        Link link;
+        link.setPort(port);
+        TraceReplayer replayer(port, link);
+        const auto report = replayer.replay(records, timeScale);
+        QCOMPARE(report.frames, qint64{20});
+        QCOMPARE(report.bytes, qint64{20} * records.at(1).data.size());
+        QVERIFY(report.anomalies.isEmpty());
+        QVERIFY(report.bytesPerSecond() > 0);
+        if (timeScale > 0) {
+            // The last frame was due 19.5 ms in at this scale.
+            QVERIFY(report.elapsedNs >= 19000000);
+        }
+    }
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <QObject>
+
+class TestWireTrace : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void testRoundTrip();
+    void testCorruptTrace();
+    void testLinkRecordsTraffic();
+    void testAnomalies();
+    void testRetransmissions();
+    void testReplay();
+};
@@ -0,0 +1,43 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#include "tracereplayer.hpp"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QThread>
+
+using namespace CommsLink;
+
+TraceReplayer::TraceReplayer(MockSerial &aPort, Link &aLink) :
+    port(aPort), link(aLink) {}
+
+ReplayReport TraceReplayer::replay(const QVector<TraceRecord> &records,
+                                   double timeScale) {
+    ReplayReport report;
+    report.anomalies = findTraceAnomalies(records);
+    const auto connection = QObject::connect(
+                &link, &Link::packetReceived,
+                [&report](const MessageRef &) { report.frames++; });
+    QElapsedTimer timer;
+    timer.start();
+    for (const auto &record : records) {
+        if (record.direction != TraceDirection::received) {
+            continue;
+        }
+        if (timeScale > 0) {
+            const auto due = static_cast<qint64>(record.timestamp * timeScale);
+            const auto now = timer.nsecsElapsed() / 1000;
+            if (due > now) {
+                QThread::usleep(static_cast<unsigned long>(due - now));
+            }
+        }
+        port.sendData(record.data);
+        report.bytes += record.data.size();
+        // The mock port signals readyRead from the event loop.
+        QCoreApplication::processEvents();
+    }
+    report.elapsedNs = timer.nsecsElapsed();
+    QObject::disconnect(connection);
+    return report;
+}
@@ -0,0 +1,47 @@
+// Copyright © 2019 Brad Ackerman.
+// Licensed under the MIT License (LICENSE.txt in this repository).
+
+#pragma once
+
+#include <QVector>
+
+#include "link.hpp"
+#include "mockserial.hpp"
+#include "wiretrace.hpp"
+
+/// \brief The outcome of replaying a trace.
+struct ReplayReport {
+    /// \brief Received bytes fed to the link.
+    qint64 bytes = 0;
+    /// \brief Messages the link decoded from them.
+    qint64 frames = 0;
+    /// \brief Wall time taken by the replay.
+    qint64 elapsedNs = 0;
+    /// \brief Timing problems in the trace itself.
+    QVector<CommsLink::TraceAnomaly> anomalies;
+
+    double bytesPerSecond() const {
+        return elapsedNs > 0 ? bytes * 1e9 / elapsedNs : 0;
+    }
+    double framesPerSecond() const {
+        return elapsedNs > 0 ? frames * 1e9 / elapsedNs : 0;
+    }
+};
+
+/// \brief Feeds the received side of a wire trace to a Link through a
+/// MockSerial, to reproduce and measure what happened in the field.
+class TraceReplayer
+{
+public:
+    /// \param port The port to feed; \p link must already be using it.
+    TraceReplayer(MockSerial &port, CommsLink::Link &link);
+    /// \brief Replay a trace.
+    /// \param timeScale 0 to replay as fast as possible; otherwise the
+    /// factor applied to the trace's timestamps, so 1 is real time and
+    /// 0.1 ten times as fast.
+    ReplayReport replay(const QVector<CommsLink::TraceRecord> &records,
+                        double timeScale = 0);
+private:
+    MockSerial &port;
+    CommsLink::Link &link;
+};
@@ -1,9 +1,64 @@
 MAINSRCPATH = ../Psi2Nix
 
+# SyncIndex, RecordStream, BufferedWriter and PortMonitor use the global
+# thread pool.
+QT += concurrent
+
 SOURCES += \
+    $$MAINSRCPATH/baudprober.cpp \
+    $$MAINSRCPATH/bufferedwriter.cpp \
+    $$MAINSRCPATH/clock.cpp \
+    $$MAINSRCPATH/crc16.cpp \
+    $$MAINSRCPATH/devicecatalogue.cpp \
+    $$MAINSRCPATH/eventtrace.cpp \
+    $$MAINSRCPATH/eventtracedumper.cpp \
+    $$MAINSRCPATH/filereceiver.cpp \
+    $$MAINSRCPATH/filetransfer.cpp \
+    $$MAINSRCPATH/framedecoder.cpp \
+    $$MAINSRCPATH/frameencoder.cpp \
+    $$MAINSRCPATH/hotplugsource.cpp \
     $$MAINSRCPATH/link.cpp \
-    $$MAINSRCPATH/protocol.cpp
+    $$MAINSRCPATH/linkmetrics.cpp \
+    $$MAINSRCPATH/messagepool.cpp \
+    $$MAINSRCPATH/payloadplanner.cpp \
+    $$MAINSRCPATH/portmonitor.cpp \
+    $$MAINSRCPATH/protocol.cpp \
+    $$MAINSRCPATH/recordconverter.cpp \
+    $$MAINSRCPATH/recordstream.cpp \
+    $$MAINSRCPATH/rttestimator.cpp \
+    $$MAINSRCPATH/session.cpp \
+    $$MAINSRCPATH/sessionmanager.cpp \
+    $$MAINSRCPATH/sessionworker.cpp \
+    $$MAINSRCPATH/syncindex.cpp \
+    $$MAINSRCPATH/wiretrace.cpp
 
 HEADERS += \
+    $$MAINSRCPATH/baudprober.hpp \
+    $$MAINSRCPATH/bufferedwriter.hpp \
+    $$MAINSRCPATH/clock.hpp \
+    $$MAINSRCPATH/controlframes.hpp \
+    $$MAINSRCPATH/crc16.hpp \
+    $$MAINSRCPATH/devicecatalogue.hpp \
+    $$MAINSRCPATH/eventtrace.hpp \
+    $$MAINSRCPATH/eventtracedumper.hpp \
+    $$MAINSRCPATH/filereceiver.hpp \
+    $$MAINSRCPATH/filetransfer.hpp \
+    $$MAINSRCPATH/framedecoder.hpp \
+    $$MAINSRCPATH/frameencoder.hpp \
+    $$MAINSRCPATH/hotplugsource.hpp \
     $$MAINSRCPATH/link.hpp \
-    $$MAINSRCPATH/protocol.hpp
+    $$MAINSRCPATH/linkmetrics.hpp \
+    $$MAINSRCPATH/message.hpp \
+    $$MAINSRCPATH/messagepool.hpp \
+    $$MAINSRCPATH/payloadplanner.hpp \
+    $$MAINSRCPATH/portmonitor.hpp \
+    $$MAINSRCPATH/protocol.hpp \
+    $$MAINSRCPATH/recordconverter.hpp \
+    $$MAINSRCPATH/recordstream.hpp \
+    $$MAINSRCPATH/rttestimator.hpp \
+    $$MAINSRCPATH/session.hpp \
+    $$MAINSRCPATH/sessionmanager.hpp \
+    $$MAINSRCPATH/sessionworker.hpp \
+    $$MAINSRCPATH/spscqueue.hpp \
+    $$MAINSRCPATH/syncindex.hpp \
+    $$MAINSRCPATH/wiretrace.hpp